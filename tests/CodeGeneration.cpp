@@ -17,13 +17,13 @@ namespace tests
 		{
 
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
 
 			SimpleBinaryOpAtom atom("OR", left, right, res);
 
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (OR, 0, 1, 2)\nLDA VAR1\nMOV B, A\nLDA VAR0\nORA B\nSTA VAR2\n", stream.str().c_str());
@@ -33,13 +33,13 @@ namespace tests
 		{
 
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
 
 			SimpleBinaryOpAtom atom("AND", left, right, res);
 
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (AND, 0, 1, 2)\nLDA VAR1\nMOV B, A\nLDA VAR0\nANA B\nSTA VAR2\n", stream.str().c_str());
@@ -49,13 +49,13 @@ namespace tests
 		{
 
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
 
 			UnaryOpAtom atom("MOV", left, res);
 
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (MOV, 0, , 2)\nLDA VAR0\nSTA VAR2\n", stream.str().c_str());
@@ -63,13 +63,13 @@ namespace tests
 
 		TEST_METHOD(Code__NOT) {
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
 
 			UnaryOpAtom atom("NOT", left, res);
 
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (NOT, 0, , 2)\nLDA VAR0\nCMA\nSTA VAR2\n", stream.str().c_str());
@@ -81,10 +81,10 @@ namespace tests
 
 			OutAtom atom(record);
 
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
-			Assert::AreEqual("; (OUT, , , str`0`)\nLXI A, str0\nCALL @PRINT\n", stream.str().c_str());
+			Assert::AreEqual("; (OUT, , , str`0`)\nLXI H, str0\nCALL @PRINT\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(Code__OUT_value) {
@@ -93,23 +93,23 @@ namespace tests
 
 			OutAtom atom(a);
 
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
-			Assert::AreEqual("; (OUT, , , '5')\nMVI A, 5\nOUT 1\n", stream.str().c_str());
+			Assert::AreEqual("; (OUT, , , '5')\nMVI A, 5\nCALL @OUTD\n", stream.str().c_str());
 		}
 
 
 		TEST_METHOD(Code__ADD)
 		{
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
 
 			SimpleBinaryOpAtom atom("ADD", left, right, res);
 
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (ADD, 0, 1, 2)\nLDA VAR1\nMOV B, A\nLDA VAR0\nADD B\nSTA VAR2\n", stream.str().c_str());
@@ -119,13 +119,13 @@ namespace tests
 		{
 
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
 
 			SimpleBinaryOpAtom atom("SUB", left, right, res);
 
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (SUB, 0, 1, 2)\nLDA VAR1\nMOV B, A\nLDA VAR0\nSUB B\nSTA VAR2\n", stream.str().c_str());
@@ -133,26 +133,66 @@ namespace tests
 
 		TEST_METHOD(Code__MUL) {
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
 
 			FnBinaryOpAtom atom("MUL", left, right, res);
 
-			std::ostringstream stream;
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual("; (MUL, 0, 1, 2)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCALL @MUL\nSTA VAR2\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__MOD) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
+
+			FnBinaryOpAtom atom("MOD", left, right, res);
+
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual("; (MOD, 0, 1, 2)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCALL @DIV\nMOV A, H\nSTA VAR2\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__MUL_constant) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
+
+			FnBinaryOpAtom atom("MUL", left, std::make_shared<NumberOperand>(10), res);
+
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual("; (MUL, 0, '10', 1)\nLDA VAR0\nMOV B, A\nADD A\nADD A\nADD B\nADD A\nSTA VAR1\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__MUL_powerOfTwo) {
+			SymbolTable table;
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::chr);
+
+			FnBinaryOpAtom atom("MUL", std::make_shared<NumberOperand>(4), right, res);
+
+			CodeWriter stream;
 			atom.generate(stream);
 
-			Assert::AreEqual("; (MUL, 0, 1, 2)\nLDA VAR1\nMOV B, A\nLDA VAR0\nMOV C, A\nMOV D, B\nCALL @MUL\nMOV A, C\nSTA VAR2\n", stream.str().c_str());
+			Assert::AreEqual("; (MUL, '4', 0, 1)\nLDA VAR0\nADD A\nADD A\nSTA VAR1\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(Code__EQ) {
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
 			LabelOperand label(0);
 
 			SimpleConditionalJumpAtom atom("EQ", left, right, std::make_shared<LabelOperand>(label));
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (EQ, 0, 1, lbl`0`)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCMP B\nJZ LBL0\n", stream.str().c_str());
@@ -160,12 +200,12 @@ namespace tests
 
 		TEST_METHOD(Code__NE) {
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
 			LabelOperand label(0);
 
 			SimpleConditionalJumpAtom atom("NE", left, right, std::make_shared<LabelOperand>(label));
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (NE, 0, 1, lbl`0`)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCMP B\nJNZ LBL0\n", stream.str().c_str());
@@ -173,48 +213,48 @@ namespace tests
 
 		TEST_METHOD(Code__GT) {
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
 			LabelOperand label(0);
 
 			SimpleConditionalJumpAtom atom("GT", left, right, std::make_shared<LabelOperand>(label));
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
-			Assert::AreEqual("; (GT, 0, 1, lbl`0`)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCMP B\nJP LBL0\n", stream.str().c_str());
+			Assert::AreEqual("; (GT, 0, 1, lbl`0`)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCMP B\nJNC LBL0\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(Code__LT) {
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
 			LabelOperand label(0);
 
 			SimpleConditionalJumpAtom atom("LT", left, right, std::make_shared<LabelOperand>(label));
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
-			Assert::AreEqual("; (LT, 0, 1, lbl`0`)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCMP B\nJM LBL0\n", stream.str().c_str());
+			Assert::AreEqual("; (LT, 0, 1, lbl`0`)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCMP B\nJC LBL0\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(Code__LE) {
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::chr);
 			LabelOperand label(0);
 
 			ComplexConditinalJumpAtom atom("LE", left, right, std::make_shared<LabelOperand>(label));
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
-			Assert::AreEqual("; (LE, 0, 1, lbl`0`)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCMP B\nJZ LBL0\nJM LBL0\n", stream.str().c_str());
+			Assert::AreEqual("; (LE, 0, 1, lbl`0`)\nLDA VAR1\nMOV B, A\nLDA VAR0\nCMP B\nJZ LBL0\nJC LBL0\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(Code__LBL) {
 			LabelOperand label(0);
 
 			LabelAtom atom(std::make_shared<LabelOperand>(label));
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("LBL0: ", stream.str().c_str());
@@ -224,7 +264,7 @@ namespace tests
 			LabelOperand label(0);
 
 			JumpAtom atom(std::make_shared<LabelOperand>(label));
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (JMP, , , lbl`0`)\nJMP LBL0\n", stream.str().c_str());
@@ -232,10 +272,10 @@ namespace tests
 
 		TEST_METHOD(CODE__IN) {
 			SymbolTable table;
-			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
 
 			InAtom atom(left);
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (IN, , , 0)\nIN 0\nSTA VAR0\n", stream.str().c_str());
@@ -243,19 +283,320 @@ namespace tests
 
 		TEST_METHOD(Code__RET) {
 			SymbolTable table;
-			auto func = table.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
-			auto left = table.insertVar("a", 0, SymbolTable::TableRecord::RecordType::integer);
-			auto right = table.insertVar("b", 0, SymbolTable::TableRecord::RecordType::integer);
+			auto func = table.insertFunc("f", SymbolTable::TableRecord::RecordType::chr, 0);
+			auto left = table.insertVar("a", 0, SymbolTable::TableRecord::RecordType::chr);
+			auto right = table.insertVar("b", 0, SymbolTable::TableRecord::RecordType::chr);
 
 			table.calculateOffset();
 			RetAtom atom(std::make_shared<NumberOperand>(5), 0, table);
-			std::ostringstream stream;
+			CodeWriter stream;
 			atom.generate(stream);
 
 			Assert::AreEqual("; (RET, , , '5')\nMVI A, 5\nLXI H, 6\nDAD SP\nMOV M, A\nPOP B\nPOP B\nRET\n", stream.str().c_str());
 		}
 
+		TEST_METHOD(Code__RET_largeFrame) {
+			SymbolTable table;
+			auto func = table.insertFunc("f", SymbolTable::TableRecord::RecordType::chr, 0);
+			auto left = table.insertVar("a", 0, SymbolTable::TableRecord::RecordType::chr);
+			auto arr = table.insertArray("b", 0, SymbolTable::TableRecord::RecordType::chr, 10);
+
+			table.calculateOffset();
+			RetAtom atom(std::make_shared<NumberOperand>(5), 0, table);
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual("; (RET, , , '5')\nMVI A, 5\nLXI H, 24\nDAD SP\nMOV M, A\nLXI H, 22\nDAD SP\nSPHL\nRET\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__functionFrame) {
+			std::istringstream input("int main(){ int a[100]; int i; a[i] = 1; return 0; }");
+			Translator translator(input);
+			Assert::IsTrue(translator.translate());
+
+			std::ostringstream stream;
+			translator.generateCode(stream);
+
+			// Arrays are zeroed as small frames are
+			Assert::IsTrue(stream.str().find("main: LXI B, 0\nMVI D, 101\nmain@ZERO: PUSH B\nDCR D\nJNZ main@ZERO\n") != std::string::npos);
+
+			std::istringstream large("int main(){ int a[300]; a[2] = 1; return 0; }");
+			Translator other(large);
+			Assert::IsTrue(other.translate());
+
+			std::ostringstream code;
+			other.generateCode(code);
+			Assert::IsTrue(code.str().find("main: LXI B, 0\nLXI D, 300\nmain@ZERO: PUSH B\nDCX D\nMOV A, D\nORA E\nJNZ main@ZERO\n") != std::string::npos);
+		}
+
+		TEST_METHOD(Code__SWITCH_table) {
+			SymbolTable table;
+			auto value = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+
+			std::vector<std::pair<int, std::shared_ptr<LabelOperand>>> cases;
+			for (int i = 0; i < 4; ++i) {
+				cases.push_back({ i + 2, std::make_shared<LabelOperand>(i) });
+			}
+			SwitchAtom atom(value, cases, std::make_shared<LabelOperand>(4), std::make_shared<LabelOperand>(5));
+
+			CodeWriter stream;
+			atom.generate(stream);
+			atom.generateTable(stream);
+
+			Assert::AreEqual((std::string("; (SWITCH, 0, 2:lbl`0` 3:lbl`1` 4:lbl`2` 5:lbl`3`, lbl`4`)\n") +
+				"LDA VAR0\nSUI 2\nCPI 4\nJNC LBL4\nADD A\nLXI H, TBL5\nADD L\nMOV L, A\nMVI A, 0\nADC H\nMOV H, A\n" +
+				"MOV A, M\nINX H\nMOV H, M\nMOV L, A\nPCHL\n" +
+				"TBL5: DW LBL0, LBL1, LBL2, LBL3\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__SWITCH_tree) {
+			SymbolTable table;
+			auto value = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+
+			std::vector<std::pair<int, std::shared_ptr<LabelOperand>>> cases;
+			for (int i = 0; i < 4; ++i) {
+				cases.push_back({ i * 50, std::make_shared<LabelOperand>(i) });
+			}
+			SwitchAtom atom(value, cases, std::make_shared<LabelOperand>(4), std::make_shared<LabelOperand>(5));
+
+			CodeWriter stream;
+			atom.generate(stream);
+			atom.generateTable(stream);
+
+			Assert::AreEqual((std::string("; (SWITCH, 0, 0:lbl`0` 50:lbl`1` 100:lbl`2` 150:lbl`3`, lbl`4`)\n") +
+				"LDA VAR0\nCPI 100\nJZ LBL2\nJC SW5_0\nCPI 150\nJZ LBL3\nJMP LBL4\n" +
+				"SW5_0: CPI 0\nJZ LBL0\nCPI 50\nJZ LBL1\nJMP LBL4\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__SWITCH_outOfRange) {
+			SymbolTable table;
+			auto value = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+
+			// Byte never equals 300 or -1, and 258 isn't a duplicate of 2
+			std::vector<std::pair<int, std::shared_ptr<LabelOperand>>> cases;
+			const int values[] = { 300, 1, 2, -1, 3, 258, 4 };
+			for (int i = 0; i < 7; ++i) {
+				cases.push_back({ values[i], std::make_shared<LabelOperand>(i) });
+			}
+			SwitchAtom atom(value, cases, std::make_shared<LabelOperand>(7), std::make_shared<LabelOperand>(8));
+
+			CodeWriter stream;
+			atom.generate(stream);
+			atom.generateTable(stream);
+
+			Assert::AreEqual((std::string("; (SWITCH, 0, 1:lbl`1` 2:lbl`2` 3:lbl`4` 4:lbl`6`, lbl`7`)\n") +
+				"LDA VAR0\nSUI 1\nCPI 4\nJNC LBL7\nADD A\nLXI H, TBL8\nADD L\nMOV L, A\nMVI A, 0\nADC H\nMOV H, A\n" +
+				"MOV A, M\nINX H\nMOV H, M\nMOV L, A\nPCHL\n" +
+				"TBL8: DW LBL1, LBL2, LBL4, LBL6\n").c_str(), stream.str().c_str());
+		}
+
 		TEST_METHOD(Code__CALL) {
+			SymbolTable table;
+			std::shared_ptr<MemoryOperand> func = table.insertFunc("func", SymbolTable::TableRecord::RecordType::chr, 1);
+			std::shared_ptr<MemoryOperand> n = table.insertVar("n", 0, SymbolTable::TableRecord::RecordType::chr);
+			std::shared_ptr<MemoryOperand> tmp1 = table.insertVar("[tmp1]", 0, SymbolTable::TableRecord::RecordType::chr);
+			std::shared_ptr<MemoryOperand> tmp2 = table.insertVar("[tmp2]", 0, SymbolTable::TableRecord::RecordType::chr);
+			std::shared_ptr<MemoryOperand> res = table.insertVar("res", -1, SymbolTable::TableRecord::RecordType::chr);
+			table.calculateOffset();
+
+			CodeWriter stream;
+
+			std::deque<std::shared_ptr<RValue>> paramsList;
+			ParamAtom param(std::make_shared<NumberOperand>(5), paramsList);
+			param.generate(stream);
+
+			CallAtom callAtom(func, res, table, paramsList);
+			callAtom.generate(stream);
+
+			Assert::AreEqual((std::string("; (CALL, 0, , 4)\n") +
+				"PUSH PSW\nMVI A, 5\nMOV L, A\nPUSH H\nCALL func\nPOP H\nPOP H\nMOV A, L\nSTA VAR4\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__CALL_savedRegisters) {
+			SymbolTable table;
+			std::shared_ptr<MemoryOperand> func = table.insertFunc("func", SymbolTable::TableRecord::RecordType::chr, 2);
+			std::shared_ptr<MemoryOperand> n = table.insertVar("n", 0, SymbolTable::TableRecord::RecordType::chr);
+			std::shared_ptr<MemoryOperand> m = table.insertVar("m", 0, SymbolTable::TableRecord::RecordType::chr);
+			std::shared_ptr<MemoryOperand> res = table.insertVar("res", 0, SymbolTable::TableRecord::RecordType::chr);
+			table.calculateOffset();
+			table.setRegister(2, Register::C);
+			table.setRegister(3, Register::D);
+
+			CodeWriter stream;
+
+			std::deque<std::shared_ptr<RValue>> paramsList;
+			ParamAtom second(m, paramsList);
+			ParamAtom first(n, paramsList);
+			second.generate(stream);
+			first.generate(stream);
+
+			CallAtom callAtom(func, res, table, paramsList);
+			callAtom.setSavedRegisters({ Register::C });
+			callAtom.generate(stream);
+
+			Assert::AreEqual((std::string("; (CALL, 0, , 3)\n") +
+				"PUSH B\nPUSH PSW\nLXI H, 10\nDAD SP\nMOV A, M\nMOV L, A\nPUSH H\nPUSH B\nCALL func\n" +
+				"POP H\nPOP H\nPOP H\nMOV A, L\nPOP B\nMOV D, A\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__ADD_int) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			SimpleBinaryOpAtom atom("ADD", left, right, res);
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual("; (ADD, 0, 1, 2)\nLHLD VAR1\nMOV B, H\nMOV C, L\nLHLD VAR0\nDAD B\nSHLD VAR2\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__SUB_int) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			SimpleBinaryOpAtom atom("SUB", left, right, res);
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual((std::string("; (SUB, 0, 1, 2)\nLHLD VAR1\nMOV B, H\nMOV C, L\nLHLD VAR0\n") +
+				"MOV A, L\nSUB C\nMOV L, A\nMOV A, H\nSBB B\nMOV H, A\nSHLD VAR2\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__ADD_intConstant) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			CodeWriter stream;
+			SimpleBinaryOpAtom increment("ADD", left, std::make_shared<NumberOperand>(1), res);
+			increment.generate(stream);
+			SimpleBinaryOpAtom add("ADD", left, std::make_shared<NumberOperand>(300), res);
+			add.generate(stream);
+
+			Assert::AreEqual((std::string("; (ADD, 0, '1', 1)\nLHLD VAR0\nINX H\nSHLD VAR1\n") +
+				"; (ADD, 0, '300', 1)\nLXI B, 300\nLHLD VAR0\nDAD B\nSHLD VAR1\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__MUL_int) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			FnBinaryOpAtom atom("MUL", left, right, res);
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual("; (MUL, 0, 1, 2)\nLHLD VAR1\nXCHG\nLHLD VAR0\nCALL @MUL16\nSHLD VAR2\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__DIV_int) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto res = table.insertVar("c", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			CodeWriter stream;
+			FnBinaryOpAtom div("DIV", left, right, res);
+			div.generate(stream);
+			FnBinaryOpAtom mod("MOD", left, right, res);
+			mod.generate(stream);
+
+			Assert::AreEqual((std::string("; (DIV, 0, 1, 2)\nLHLD VAR1\nXCHG\nLHLD VAR0\nCALL @DIV16\nSHLD VAR2\n") +
+				"; (MOD, 0, 1, 2)\nLHLD VAR1\nXCHG\nLHLD VAR0\nCALL @DIV16\nMOV H, B\nMOV L, C\nSHLD VAR2\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__EQ_int) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			SimpleConditionalJumpAtom atom("EQ", left, right, std::make_shared<LabelOperand>(0));
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual((std::string("; (EQ, 0, 1, lbl`0`)\nLHLD VAR1\nMOV B, H\nMOV C, L\nLHLD VAR0\n") +
+				"MOV A, L\nSUB C\nMOV L, A\nMOV A, H\nSBB B\nORA L\nJZ LBL0\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__LE_int) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+			auto right = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			ComplexConditinalJumpAtom atom("LE", left, right, std::make_shared<LabelOperand>(0));
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual((std::string("; (LE, 0, 1, lbl`0`)\nLHLD VAR1\nMOV A, H\nXRI 128\nMOV B, A\nMOV C, L\nLHLD VAR0\n") +
+				"MOV A, H\nXRI 128\nMOV H, A\nMOV A, L\nSUB C\nMOV L, A\nMOV A, H\nSBB B\nJC LBL0\nORA L\nJZ LBL0\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__LT_intBoundary) {
+			SymbolTable table;
+			auto left = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			// Sign bits are inverted, so -30000 < 30000 and 32767 > -32768 are ordered by carry
+			CodeWriter stream;
+			SimpleConditionalJumpAtom less("LT", left, std::make_shared<NumberOperand>(-30000), std::make_shared<LabelOperand>(0));
+			less.generate(stream);
+			SimpleConditionalJumpAtom greater("GT", left, std::make_shared<NumberOperand>(32767), std::make_shared<LabelOperand>(0));
+			greater.generate(stream);
+			SimpleConditionalJumpAtom equal("EQ", left, std::make_shared<NumberOperand>(-32768), std::make_shared<LabelOperand>(0));
+			equal.generate(stream);
+
+			const std::string subtract = "LHLD VAR0\nMOV A, H\nXRI 128\nMOV H, A\nMOV A, L\nSUB C\nMOV L, A\nMOV A, H\nSBB B\n";
+			Assert::AreEqual(("; (LT, 0, '-30000', lbl`0`)\nLXI B, 2768\n" + subtract + "JC LBL0\n" +
+				"; (GT, 0, '32767', lbl`0`)\nLXI B, 65535\n" + subtract + "JNC LBL0\n" +
+				"; (EQ, 0, '-32768', lbl`0`)\nLXI B, -32768\nLHLD VAR0\nMOV A, L\nSUB C\nMOV L, A\nMOV A, H\nSBB B\nORA L\nJZ LBL0\n").c_str(),
+				stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__MOV_widening) {
+			SymbolTable table;
+			auto narrow = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::chr);
+			auto wide = table.insertVar("b", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			CodeWriter stream;
+			UnaryOpAtom widen("MOV", narrow, wide);
+			widen.generate(stream);
+			UnaryOpAtom truncate("MOV", wide, narrow);
+			truncate.generate(stream);
+
+			Assert::AreEqual((std::string("; (MOV, 0, , 1)\nLDA VAR0\nMOV L, A\nMVI H, 0\nSHLD VAR1\n") +
+				"; (MOV, 1, , 0)\nLDA VAR1\nSTA VAR0\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__OUT_int) {
+			SymbolTable table;
+			auto value = table.insertVar("a", -1, SymbolTable::TableRecord::RecordType::integer);
+
+			OutAtom atom(value);
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual("; (OUT, , , 0)\nLHLD VAR0\nCALL @OUTD16\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__RET_int) {
+			SymbolTable table;
+			auto func = table.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
+			auto left = table.insertVar("a", 0, SymbolTable::TableRecord::RecordType::integer);
+			auto right = table.insertVar("b", 0, SymbolTable::TableRecord::RecordType::integer);
+
+			table.calculateOffset();
+			RetAtom atom(std::make_shared<NumberOperand>(500), 0, table);
+			CodeWriter stream;
+			atom.generate(stream);
+
+			Assert::AreEqual("; (RET, , , '500')\nLXI D, 500\nLXI H, 6\nDAD SP\nMOV M, E\nINX H\nMOV M, D\nPOP B\nPOP B\nRET\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(Code__CALL_int) {
 			SymbolTable table;
 			std::shared_ptr<MemoryOperand> func = table.insertFunc("func", SymbolTable::TableRecord::RecordType::integer, 1);
 			std::shared_ptr<MemoryOperand> n = table.insertVar("n", 0, SymbolTable::TableRecord::RecordType::integer);
@@ -264,19 +605,17 @@ namespace tests
 			std::shared_ptr<MemoryOperand> res = table.insertVar("res", -1, SymbolTable::TableRecord::RecordType::integer);
 			table.calculateOffset();
 
-			std::ostringstream stream;
+			CodeWriter stream;
 
 			std::deque<std::shared_ptr<RValue>> paramsList;
-			ParamAtom param(std::make_shared<NumberOperand>(5), paramsList);
+			ParamAtom param(std::make_shared<NumberOperand>(500), paramsList);
 			param.generate(stream);
 
 			CallAtom callAtom(func, res, table, paramsList);
 			callAtom.generate(stream);
 
 			Assert::AreEqual((std::string("; (CALL, 0, , 4)\n") +
-				"PUSH PSW\nPUSH B\nPUSH D\nPUSH H\n" +
-				"LXI B, 0\nPUSH B\nMVI A, 5\nMOV C, A\nPUSH B\nCALL func\nPOP B\nPOP B\nMOV A, C\nSTA VAR4\n" +
-				"POP H\nPOP D\nPOP B\nPOP PSW\n").c_str(), stream.str().c_str());
+				"PUSH PSW\nLXI H, 500\nPUSH H\nCALL func\nPOP H\nPOP H\nSHLD VAR4\n").c_str(), stream.str().c_str());
 		}
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,112 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include "Emission\CodeWriter.h"
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(CodeWriterTest)
+	{
+	public:
+		// Program of many functions, so its code is large
+		std::string largeProgram(const unsigned int functions)
+		{
+			std::string source = "int g = 1; char s[8];\n";
+			for (unsigned int i = 0; i < functions; ++i) {
+				source += "int f" + std::to_string(i) + "(int a, char b){ int i, r; r = 0;"
+					" for(i = 0; i < a; ++i){ r = r + i * " + std::to_string(i + 3) + " + g; s[i] = b; }"
+					" switch(a){ case 1: r = r - 1; case 2: r = r + 2; case 3: r = r * 3; case 4: r = 0; }"
+					" out \"f" + std::to_string(i) + "\"; out r; return r; }\n";
+			}
+			source += "int main(){ int x; in x; out f0(x, 'c'); return 0; }";
+			return source;
+		}
+
+		TEST_METHOD(CodeWriter__integers)
+		{
+			CodeWriter writer;
+			writer << 0 << ' ' << -1 << ' ' << 1234 << ' ' << INT_MIN << ' ' << INT_MAX << ' ' << UINT_MAX << ' ' << 10u;
+			writer << " str" << std::string("ing") << '\n';
+
+			Assert::AreEqual("0 -1 1234 -2147483648 2147483647 4294967295 10 string\n", writer.str().c_str());
+			Assert::AreEqual((size_t)54, writer.size());
+
+			std::ostringstream stream;
+			writer.flush(stream);
+			Assert::AreEqual(writer.str().c_str(), stream.str().c_str());
+
+			writer.clear();
+			Assert::AreEqual((size_t)0, writer.size());
+		}
+
+		TEST_METHOD(CodeWriter__benchmark)
+		{
+			// Writing of large listing to file line by line with std::endl, as code was written
+			// before, and by code writer
+			std::istringstream input(largeProgram(300));
+			Translator translator(input);
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+			const std::string listing = code.str();
+
+			std::vector<std::string> lines;
+			std::istringstream split(listing);
+			for (std::string line; std::getline(split, line);) {
+				lines.push_back(line);
+			}
+
+			const char* name = "CodeWriter__benchmark.asm.txt";
+
+			auto start = std::chrono::steady_clock::now();
+			{
+				std::ofstream file(name, std::ios::binary);
+				for (auto it = lines.begin(); it != lines.end(); ++it) {
+					file << *it << std::endl;
+				}
+			}
+			auto flushed = std::chrono::steady_clock::now() - start;
+
+			start = std::chrono::steady_clock::now();
+			{
+				std::ofstream file(name, std::ios::binary);
+				CodeWriter writer;
+				for (auto it = lines.begin(); it != lines.end(); ++it) {
+					writer << *it << '\n';
+				}
+				writer.flush(file);
+			}
+			auto buffered = std::chrono::steady_clock::now() - start;
+
+			start = std::chrono::steady_clock::now();
+			{
+				std::ofstream file(name, std::ios::binary);
+				translator.generateCode(file);
+			}
+			auto generated = std::chrono::steady_clock::now() - start;
+
+			std::ifstream file(name, std::ios::binary);
+			std::ostringstream written;
+			written << file.rdbuf();
+			file.close();
+			std::remove(name);
+			Assert::AreEqual(listing.c_str(), written.str().c_str());
+
+			std::ostringstream message;
+			message << "Writing " << lines.size() << " lines (" << listing.size() << " bytes): std::endl "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(flushed).count() << " us, code writer "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(buffered).count() << " us, generateCode "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(generated).count() << " us";
+			Logger::WriteMessage(message.str().c_str());
+		}
+	};
+}
@@ -0,0 +1,122 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include "Cache\CompilationCache.h"
+#include <sstream>
+#include <regex>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(CompilationCacheTest)
+	{
+	public:
+		const std::string PROGRAM = "int g = 3; char s[4];\n"
+			"int twice(int x){ return x + x; }\n"
+			"int sum(int n){ int i, r; r = 0; for(i = 0; i < n; ++i){ r = r + s[i]; } return r; }\n"
+			"int main(){ int i; for(i = 0; i < 4; ++i){ s[i] = twice(i) + g; } out sum(4); out \"done\"; return 0; }";
+
+		std::string compile(const std::string& program, CompilationCache* cache)
+		{
+			std::istringstream stream(program);
+			Translator translator(stream);
+			translator.setCache(cache);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+			return code.str();
+		}
+
+		TEST_METHOD(CompilationCache__relocation)
+		{
+			CompilationCache::Symbols symbols;
+			symbols.labels = { 7, 3 };
+			symbols.strings = { 2 };
+			symbols.globals = { { 0, "g" }, { 1, "a" } };
+
+			std::string code = "f: ; (MOV, '1', , 5)\nLBL7: ; (OUT, , , 5)\nLDA VAR0\nLXI H, ARR1+2\nLXI H, str2\n"
+				"JZ LBL3\nJC SW3_0\nCALL @MUL\n";
+			std::string relocatable = CompilationCache::relocate(code, symbols);
+			Assert::AreEqual("f: LBL{0}: LDA VAR{g}\nLXI H, ARR{a}+2\nLXI H, str{0}\nJZ LBL{1}\nJC SW{1}_0\nCALL @MUL\n",
+				relocatable.c_str());
+
+			// The same function in other program
+			CompilationCache::Symbols other;
+			other.labels = { 10, 11 };
+			other.strings = { 0 };
+			other.globals = { { 4, "a" }, { 6, "g" } };
+
+			std::string resolved;
+			Assert::IsTrue(CompilationCache::resolve(relocatable, other, resolved));
+			Assert::AreEqual("f: LBL10: LDA VAR6\nLXI H, ARR4+2\nLXI H, str0\nJZ LBL11\nJC SW11_0\nCALL @MUL\n", resolved.c_str());
+
+			other.globals.erase(6);
+			Assert::IsFalse(CompilationCache::resolve(relocatable, other, resolved));
+		}
+
+		TEST_METHOD(CompilationCache__unchangedProgram)
+		{
+			CompilationCache cache;
+			std::string fresh = compile(PROGRAM, &cache);
+			Assert::AreEqual(3u, cache.size());
+			Assert::AreEqual(3u, cache.misses());
+
+			// Reused code differs only by comments of atoms
+			std::string cached = compile(PROGRAM, &cache);
+			Assert::AreEqual(3u, cache.hits());
+			Assert::AreEqual(std::regex_replace(fresh, std::regex("; [^\\n]*\\n"), "").c_str(), cached.c_str());
+		}
+
+		TEST_METHOD(CompilationCache__changedFunction)
+		{
+			CompilationCache cache;
+			compile(PROGRAM, &cache);
+
+			// Callers of changed function are compiled again, as it may be inlined
+			std::string changed = std::regex_replace(PROGRAM, std::regex("x \\+ x"), "x + x + 1");
+			compile(changed, &cache);
+			Assert::AreEqual(1u, cache.hits());
+			Assert::AreEqual(5u, cache.misses());
+		}
+
+		TEST_METHOD(CompilationCache__changedGlobal)
+		{
+			CompilationCache cache;
+			compile(PROGRAM, &cache);
+
+			// Only main reads g, moved functions are still reused
+			std::string changed = "int g = 5; char s[4];\n"
+				"int sum(int n){ int i, r; r = 0; for(i = 0; i < n; ++i){ r = r + s[i]; } return r; }\n"
+				"int twice(int x){ return x + x; }\n"
+				"int main(){ int i; for(i = 0; i < 4; ++i){ s[i] = twice(i) + g; } out sum(4); out \"done\"; return 0; }";
+			compile(changed, &cache);
+			Assert::AreEqual(2u, cache.hits());
+			Assert::AreEqual(4u, cache.misses());
+		}
+
+		TEST_METHOD(CompilationCache__saveLoad)
+		{
+			CompilationCache cache;
+			std::string fresh = compile(PROGRAM, &cache);
+
+			std::stringstream file;
+			cache.save(file);
+
+			CompilationCache loaded;
+			loaded.load(file);
+			Assert::AreEqual(3u, loaded.size());
+			Assert::AreEqual(compile(PROGRAM, &cache).c_str(), compile(PROGRAM, &loaded).c_str());
+			Assert::AreEqual(3u, loaded.hits());
+
+			// Other versions are ignored
+			std::istringstream old("MINIC-CACHE 0 1\n");
+			CompilationCache empty;
+			empty.load(old);
+			Assert::AreEqual(0u, empty.size());
+		}
+	};
+}
@@ -0,0 +1,82 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include "CycleCounter\CycleCounter.h"
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(CycleCounterTest)
+	{
+	public:
+
+		TEST_METHOD(CycleCounter__instructions)
+		{
+			Assert::AreEqual(5u, CycleCounter::cycles("MOV A, B"));
+			Assert::AreEqual(7u, CycleCounter::cycles("MOV A, M"));
+			Assert::AreEqual(7u, CycleCounter::cycles("MOV M, B"));
+			Assert::AreEqual(10u, CycleCounter::cycles("LXI H, 4"));
+			Assert::AreEqual(4u, CycleCounter::cycles("ADD B"));
+			Assert::AreEqual(17u, CycleCounter::cycles("CALL main"));
+		}
+
+		TEST_METHOD(CycleCounter__labelsAndComments)
+		{
+			Assert::AreEqual(0u, CycleCounter::cycles("; (ADD, 1, 2, 3)"));
+			Assert::AreEqual(0u, CycleCounter::cycles("LBL1: ; (JMP, , , lbl`2`)"));
+			Assert::AreEqual(10u, CycleCounter::cycles("LBL2: JMP LBL0"));
+			Assert::AreEqual(10u, CycleCounter::cycles("main: LXI B, 0"));
+			Assert::AreEqual(0u, CycleCounter::cycles("str0: DB 'a: b', 0"));
+			Assert::AreEqual(0u, CycleCounter::cycles("ORG 8000H"));
+		}
+
+		TEST_METHOD(CycleCounter__count)
+		{
+			std::istringstream code("LBL0: MVI A, 1\nMOV B, A\n; comment\nADD B\nRET\n");
+
+			Assert::AreEqual(26u, CycleCounter::count(code));
+		}
+
+		TEST_METHOD(CycleCounter__registersFibLocal)
+		{
+			const std::string program = std::string("int main(){ int arr[10]; int i; arr[0] = 0; arr[1] = 1; ") +
+				"for(i = 2; i < 10; ++i){ arr[i] = arr[i - 1] + arr[i - 2]; } " +
+				"for(i = 0; i < 10; ++i){ out arr[i]; } return 0; }";
+
+			std::istringstream plainStream(program);
+			Translator plain(plainStream);
+			Assert::IsTrue(plain.translate());
+
+			std::istringstream optimizedStream(program);
+			Translator optimized(optimizedStream);
+			Assert::IsTrue(optimized.translate());
+			optimized.optimize();
+
+			std::stringstream plainCode, optimizedCode;
+			plain.generateCode(plainCode);
+			optimized.generateCode(optimizedCode);
+
+			Assert::IsTrue(CycleCounter::count(optimizedCode) < CycleCounter::count(plainCode));
+		}
+
+		TEST_METHOD(CycleCounter__charExpressions)
+		{
+			auto cycles = [](const std::string& type) {
+				std::istringstream stream("int main(){ " + type + " a, b, c; in a; in b; c = a * b + a / b; out c; " +
+					"c = a % b; out c; return 0; }");
+				Translator translator(stream);
+				Assert::IsTrue(translator.translate());
+				translator.optimize();
+
+				std::stringstream code;
+				translator.generateCode(code);
+				return CycleCounter::count(code);
+			};
+
+			// The same expressions of chars don't need word arithmetic
+			Assert::IsTrue(cycles("char") < cycles("int"));
+		}
+	};
+}
@@ -188,10 +188,10 @@ namespace Tests
 		}
 
 		TEST_METHOD(LexicalScanner__Ops) {
-			std::istringstream input("= + - * ++ == != < > <= ! || &&");
+			std::istringstream input("= + - * / % ++ == != < > <= ! || &&");
 			LexicalScanner scanner(input);
 			std::vector<LexemType> excepted = { LexemType::opassign, LexemType::opplus, LexemType::opminus,
-				LexemType::opmult, LexemType::opinc, LexemType::opeq, LexemType::opne, LexemType::oplt,
+				LexemType::opmult, LexemType::opdiv, LexemType::opmod, LexemType::opinc, LexemType::opeq, LexemType::opne, LexemType::oplt,
 				LexemType::opgt, LexemType::ople, LexemType::opnot, LexemType::opor, LexemType::opand
 			};
 			LexemType* current = &excepted[0];
@@ -313,5 +313,21 @@ namespace Tests
 
 			AssertAreTypesEqual(token_1.type(), LexemType::error);
 		}
+
+		TEST_METHOD(LexicalScanner__Positions) {
+			std::istringstream input("int a;\n\tb = 'xy' + 12;\n");
+			LexicalScanner scanner(input);
+
+			std::vector<std::pair<unsigned int, unsigned int>> expected = { { 1, 1 }, { 1, 5 }, { 1, 6 },
+				{ 2, 2 }, { 2, 4 }, { 2, 6 }, { 2, 11 }, { 2, 13 }, { 2, 15 }, { 3, 1 } };
+
+			// Rest of invalid char constant is skipped
+			for (auto it = expected.begin(); it != expected.end(); ++it) {
+				LexicalToken token = scanner.getNextToken();
+				Assert::AreEqual(it->first, token.position().line);
+				Assert::AreEqual(it->second, token.position().column);
+				Assert::AreEqual(it->first, scanner.position().line);
+			}
+		}
 	};
 }
\ No newline at end of file
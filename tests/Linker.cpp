@@ -0,0 +1,162 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include "Linker\Linker.h"
+#include <sstream>
+#include <regex>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(LinkerTest)
+	{
+	public:
+		const std::string LIBRARY = "int g = 3; char s[4];\n"
+			"int twice(int x){ return x + x; }\n"
+			"int kind(int c){ switch(c){ case 0: return 5; case 1: return 7; case 2: return 9; case 3: return 11; default: return 0; } }\n"
+			"int show(char v){ out \"v=\"; out v; out g; return 0; }";
+
+		const std::string PROGRAM = "int twice(int x); int kind(int c); int show(char v);\n"
+			"int g = 40; int s[3];\n"
+			"int main(){ int i; for(i = 0; i < 3; ++i){ s[i] = twice(i) + g; } out kind(s[0]); show(7); out \"v=\"; return 0; }";
+
+		ModuleObject compile(const std::string& name, const std::string& source)
+		{
+			std::istringstream stream(source);
+			Translator translator(stream);
+			translator.setSeparateCompilation(true);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+			return translator.generateObject(name);
+		}
+
+		std::string link(const Linker& linker)
+		{
+			std::ostringstream stream;
+			linker.link(stream);
+			return stream.str();
+		}
+
+		TEST_METHOD(Linker__object)
+		{
+			ModuleObject object = compile("main", PROGRAM);
+
+			Assert::AreEqual(1u, (unsigned int)object.exports.size());
+			Assert::AreEqual("main", object.exports[0].name.c_str());
+			Assert::AreEqual(3u, (unsigned int)object.imports.size());
+			Assert::AreEqual("show", object.imports[2].name.c_str());
+			Assert::IsTrue(SymbolTable::TableRecord::RecordType::chr == object.imports[2].params[0]);
+
+			Assert::AreEqual(2u, (unsigned int)object.globals.size());
+			Assert::AreEqual("s", object.globals[1].name.c_str());
+			Assert::AreEqual(3, object.globals[1].len);
+
+			// Globals are referred by name
+			Assert::IsTrue(object.code.find("VAR{g}") != std::string::npos);
+			Assert::IsTrue(object.code.find("CALL twice") != std::string::npos);
+		}
+
+		TEST_METHOD(Linker__modules)
+		{
+			Linker linker;
+			linker.add(compile("lib", LIBRARY));
+			linker.add(compile("main", PROGRAM));
+			std::string program = link(linker);
+
+			// Globals of modules are placed one after another, equal strings are shared
+			Assert::IsTrue(program.find("var0: DW 3\nARR1: DS 8\nvar2: DW 40\nARR3: DS 6\nstr0: DB 'v=', 0\n") == 10);
+			Assert::IsTrue(program.find("str1") == std::string::npos);
+
+			// Labels of modules don't clash
+			std::set<std::string> labels;
+			std::smatch match;
+			for (std::string rest = program; std::regex_search(rest, match, std::regex("(LBL|TBL)\\d+:")); rest = match.suffix()) {
+				Assert::IsTrue(labels.insert(match.str()).second);
+			}
+			Assert::IsTrue(labels.size() > 2);
+
+			Assert::IsTrue(program.find("twice: ") != std::string::npos);
+			Assert::IsTrue(program.find("main: ") != std::string::npos);
+			Assert::IsTrue(program.find("CALL @PRINT") != std::string::npos);
+		}
+
+		TEST_METHOD(Linker__relink)
+		{
+			Linker linker;
+			linker.add(compile("lib", LIBRARY));
+			linker.add(compile("main", PROGRAM));
+			std::string program = link(linker);
+
+			// Changed module replaces the old one
+			linker.add(compile("lib", std::regex_replace(LIBRARY, std::regex("g = 3"), "g = 5")));
+			std::string changed = link(linker);
+			Assert::IsTrue(changed.find("var0: DW 5\n") != std::string::npos);
+			Assert::AreEqual(program.size(), changed.size());
+
+			linker.remove("lib");
+			Assert::ExpectException<LinkError>([this, &linker]() { link(linker); });
+		}
+
+		TEST_METHOD(Linker__errors)
+		{
+			Linker missing;
+			missing.add(compile("main", PROGRAM));
+			Assert::ExpectException<LinkError>([this, &missing]() { link(missing); });
+
+			Linker twice;
+			twice.add(compile("lib", LIBRARY));
+			twice.add(compile("other", "int twice(int y){ return y; }"));
+			twice.add(compile("main", PROGRAM));
+			Assert::ExpectException<LinkError>([this, &twice]() { link(twice); });
+
+			Linker signature;
+			signature.add(compile("lib", std::regex_replace(LIBRARY, std::regex("show\\(char"), "show(int")));
+			signature.add(compile("main", PROGRAM));
+			Assert::ExpectException<LinkError>([this, &signature]() { link(signature); });
+
+			Linker entry;
+			entry.add(compile("lib", LIBRARY));
+			Assert::ExpectException<LinkError>([this, &entry]() { link(entry); });
+		}
+
+		TEST_METHOD(Linker__saveLoad)
+		{
+			ModuleObject object = compile("lib", LIBRARY);
+			std::stringstream file;
+			object.save(file);
+			const std::string data = file.str();
+
+			ModuleObject loaded;
+			loaded.load(file);
+			Assert::AreEqual(object.name.c_str(), loaded.name.c_str());
+			Assert::AreEqual(object.code.c_str(), loaded.code.c_str());
+			Assert::AreEqual(object.tables.c_str(), loaded.tables.c_str());
+			Assert::AreEqual(object.labels, loaded.labels);
+			Assert::IsTrue(object.routines == loaded.routines);
+
+			std::istringstream truncated(data.substr(0, data.size() - 1));
+			Assert::ExpectException<FormatError>([&loaded, &truncated]() { loaded.load(truncated); });
+			Assert::AreEqual(object.code.c_str(), loaded.code.c_str());
+		}
+
+		TEST_METHOD(Linker__declarationWithoutModules)
+		{
+			// Without separate compilation every declared function must be defined
+			std::istringstream stream("int f(int a);\nint main(){ return f(1); }");
+			std::ostringstream errors;
+			Translator translator(stream, errors);
+
+			Assert::IsFalse(translator.translate());
+			Assert::AreEqual(1u, (unsigned int)translator.diagnostics().size());
+			Assert::AreEqual(1u, translator.diagnostics()[0].position.line);
+			Assert::AreEqual("Syntax error: Function f is declared but not defined", translator.diagnostics()[0].message.c_str());
+
+			std::istringstream redefinition("int f(int a){ return a; }\nint f(int b){ return b; }\nint main(){ return f(1); }");
+			Translator other(redefinition, errors);
+			Assert::IsFalse(other.translate());
+			Assert::AreEqual(2u, other.diagnostics()[0].position.line);
+		}
+	};
+}
@@ -46,7 +46,7 @@ namespace tests
 		}
 
 		TEST_METHOD(NumberOperand__load) {
-			std::ostringstream stream;
+			CodeWriter stream;
 			NumberOperand numOp(14);
 			numOp.load(stream);
 
@@ -59,7 +59,7 @@ namespace tests
 			symbolTable.insertVar("a", 1, SymbolTable::TableRecord::RecordType::integer);
 
 			MemoryOperand memOp(1, &symbolTable);
-			std::ostringstream stream;
+			CodeWriter stream;
 			memOp.load(stream);
 
 			Assert::AreEqual("LXI H, 0\nDAD SP\nMOV A, M\n", stream.str().c_str());
@@ -70,7 +70,7 @@ namespace tests
 			symbolTable.insertVar("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer);
 
 			MemoryOperand memOp(0, &symbolTable);
-			std::ostringstream stream;
+			CodeWriter stream;
 			memOp.load(stream);
 
 			Assert::AreEqual("LDA VAR0\n", stream.str().c_str());
@@ -79,10 +79,10 @@ namespace tests
 		TEST_METHOD(MemoryOperand__saveLocal) {
 			SymbolTable symbolTable;
 			symbolTable.insertFunc("main", SymbolTable::TableRecord::RecordType::integer, 0);
-			symbolTable.insertVar("a", 1, SymbolTable::TableRecord::RecordType::integer);
+			symbolTable.insertVar("a", 1, SymbolTable::TableRecord::RecordType::chr);
 
 			MemoryOperand memOp(1, &symbolTable);
-			std::ostringstream stream;
+			CodeWriter stream;
 			memOp.save(stream);
 
 			Assert::AreEqual("LXI H, 0\nDAD SP\nMOV M, A\n", stream.str().c_str());
@@ -90,61 +90,246 @@ namespace tests
 
 		TEST_METHOD(MemoryOperand__saveGlobal) {
 			SymbolTable symbolTable;
-			symbolTable.insertVar("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer);
+			symbolTable.insertVar("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
 
 			MemoryOperand memOp(0, &symbolTable);
-			std::ostringstream stream;
+			CodeWriter stream;
 			memOp.save(stream);
 
 			Assert::AreEqual("STA VAR0\n", stream.str().c_str());
 		}
 
+		TEST_METHOD(MemoryOperand__loadRegister) {
+			SymbolTable symbolTable;
+			symbolTable.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
+			symbolTable.insertVar("a", 0, SymbolTable::TableRecord::RecordType::chr);
+			symbolTable.calculateOffset();
+			symbolTable.setRegister(1, Register::D);
+
+			MemoryOperand memOp(1, &symbolTable);
+			CodeWriter stream;
+			memOp.load(stream);
+
+			Assert::AreEqual("MOV A, D\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(MemoryOperand__saveRegister) {
+			SymbolTable symbolTable;
+			symbolTable.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
+			symbolTable.insertVar("a", 0, SymbolTable::TableRecord::RecordType::chr);
+			symbolTable.calculateOffset();
+			symbolTable.setRegister(1, Register::E);
+
+			MemoryOperand memOp(1, &symbolTable);
+			CodeWriter stream;
+			memOp.save(stream);
+
+			Assert::AreEqual("MOV E, A\n", stream.str().c_str());
+		}
+
 		TEST_METHOD(ArrayElementOperand__loadLocal) {
 			SymbolTable symbolTable;
 			symbolTable.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
 			symbolTable.insertArray("a", 0, SymbolTable::TableRecord::RecordType::integer, 10);
+			auto key = symbolTable.insertVar("i", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
 			symbolTable.calculateOffset();
 
-			std::shared_ptr<MemoryOperand> arrayOp = std::make_shared<ArrayElementOperand>(1, std::make_shared<NumberOperand>(3), &symbolTable);
-			std::ostringstream stream;
+			std::shared_ptr<MemoryOperand> arrayOp = std::make_shared<ArrayElementOperand>(1, key, &symbolTable);
+			CodeWriter stream;
 			arrayOp->load(stream);
 
-			Assert::AreEqual("MVI A, 3\nLXI H, 0\nLXI D, 0\nMOV E, A\nADD E\nMOV E, A\nDAD SP\nDAD D\nMOV A, M\n", stream.str().c_str());
+			Assert::AreEqual("LDA VAR2\nLXI H, 0\nDAD SP\nADD A\nADD L\nMOV L, A\nMVI A, 0\nADC H\nMOV H, A\nMOV A, M\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(ArrayElementOperand__loadGlobal) {
 			SymbolTable symbolTable;
 			symbolTable.insertArray("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer, 10);
+			auto key = symbolTable.insertVar("i", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
 
-			std::shared_ptr<MemoryOperand> arrayOp = std::make_shared<ArrayElementOperand>(0, std::make_shared<NumberOperand>(3), &symbolTable);
-			std::ostringstream stream;
+			std::shared_ptr<MemoryOperand> arrayOp = std::make_shared<ArrayElementOperand>(0, key, &symbolTable);
+			CodeWriter stream;
 			arrayOp->load(stream);
 
-			Assert::AreEqual("MVI A, 3\nLXI H, ARR0\nLXI D, 0\nMOV E, A\nADD E\nMOV E, A\nDAD D\nMOV A, M\n", stream.str().c_str());
+			Assert::AreEqual("LDA VAR1\nLXI H, ARR0\nADD A\nADD L\nMOV L, A\nMVI A, 0\nADC H\nMOV H, A\nMOV A, M\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(ArrayElementOperand__saveLocal) {
 			SymbolTable symbolTable;
 			symbolTable.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
-			symbolTable.insertArray("a", 0, SymbolTable::TableRecord::RecordType::integer, 10);
+			symbolTable.insertArray("a", 0, SymbolTable::TableRecord::RecordType::chr, 10);
+			auto key = symbolTable.insertVar("i", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
 			symbolTable.calculateOffset();
 
-			std::shared_ptr<MemoryOperand> arrayOp = std::make_shared<ArrayElementOperand>(1, std::make_shared<NumberOperand>(3), &symbolTable);
-			std::ostringstream stream;
+			std::shared_ptr<MemoryOperand> arrayOp = std::make_shared<ArrayElementOperand>(1, key, &symbolTable);
+			CodeWriter stream;
 			arrayOp->save(stream);
 
-			Assert::AreEqual("MOV C, A\nMVI A, 3\nLXI H, 0\nLXI D, 0\nMOV E, A\nADD E\nMOV E, A\nDAD SP\nDAD D\nMOV A, C\nMOV M, A\n", stream.str().c_str());
+			Assert::AreEqual("MOV B, A\nLDA VAR2\nLXI H, 0\nDAD SP\nADD A\nADD L\nMOV L, A\nMVI A, 0\nADC H\nMOV H, A\nMOV M, B\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(ArrayElementOperand__saveGlobal) {
 			SymbolTable symbolTable;
-			symbolTable.insertArray("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer, 10);
+			symbolTable.insertArray("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr, 10);
+			auto key = symbolTable.insertVar("i", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
 
-		 	std::shared_ptr<MemoryOperand> arrayOp = std::make_shared<ArrayElementOperand>(0, std::make_shared<NumberOperand>(3), &symbolTable);
-			std::ostringstream stream;
+		 	std::shared_ptr<MemoryOperand> arrayOp = std::make_shared<ArrayElementOperand>(0, key, &symbolTable);
+			CodeWriter stream;
 			arrayOp->save(stream);
 
-			Assert::AreEqual("MOV C, A\nMVI A, 3\nLXI H, ARR0\nLXI D, 0\nMOV E, A\nADD E\nMOV E, A\nDAD D\nMOV A, C\nMOV M, A\n", stream.str().c_str());
+			Assert::AreEqual("MOV B, A\nLDA VAR1\nLXI H, ARR0\nADD A\nADD L\nMOV L, A\nMVI A, 0\nADC H\nMOV H, A\nMOV M, B\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(NumberOperand__loadWide) {
+			NumberOperand numOp(300);
+
+			CodeWriter stream;
+			numOp.loadWide(stream);
+			numOp.load(stream);
+
+			Assert::IsTrue(numOp.isWide());
+			Assert::AreEqual("LXI H, 300\nMVI A, 44\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(MemoryOperand__wideLocal) {
+			SymbolTable symbolTable;
+			symbolTable.insertFunc("main", SymbolTable::TableRecord::RecordType::integer, 0);
+			symbolTable.insertVar("a", 1, SymbolTable::TableRecord::RecordType::integer);
+
+			MemoryOperand memOp(1, &symbolTable);
+			CodeWriter stream;
+			memOp.loadWide(stream);
+			memOp.saveWide(stream);
+			memOp.save(stream);
+
+			Assert::AreEqual((std::string("LXI H, 0\nDAD SP\nMOV A, M\nINX H\nMOV H, M\nMOV L, A\n") +
+				"MOV B, H\nMOV C, L\nLXI H, 0\nDAD SP\nMOV M, C\nINX H\nMOV M, B\n" +
+				"LXI H, 0\nDAD SP\nMOV M, A\nINX H\nMVI M, 0\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(MemoryOperand__wideGlobal) {
+			SymbolTable symbolTable;
+			symbolTable.insertVar("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer);
+
+			MemoryOperand memOp(0, &symbolTable);
+			CodeWriter stream;
+			memOp.loadWide(stream);
+			memOp.saveWide(stream);
+			memOp.save(stream);
+
+			Assert::AreEqual("LHLD VAR0\nSHLD VAR0\nMOV L, A\nMVI H, 0\nSHLD VAR0\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(MemoryOperand__wideRegister) {
+			SymbolTable symbolTable;
+			symbolTable.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
+			symbolTable.insertVar("a", 0, SymbolTable::TableRecord::RecordType::integer);
+			symbolTable.calculateOffset();
+			symbolTable.setRegister(1, Register::D);
+
+			MemoryOperand memOp(1, &symbolTable);
+			CodeWriter stream;
+			memOp.load(stream);
+			memOp.loadWide(stream);
+			memOp.saveWide(stream);
+
+			Assert::AreEqual("MOV A, E\nMOV L, E\nMOV H, D\nMOV E, L\nMOV D, H\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(MemoryOperand__charToWide) {
+			SymbolTable symbolTable;
+			symbolTable.insertVar("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
+
+			MemoryOperand memOp(0, &symbolTable);
+			CodeWriter stream;
+			memOp.loadWide(stream);
+			memOp.saveWide(stream);
+
+			Assert::IsFalse(memOp.isWide());
+			Assert::AreEqual("LDA VAR0\nMOV L, A\nMVI H, 0\nMOV A, L\nSTA VAR0\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(ArrayElementOperand__wideGlobal) {
+			SymbolTable symbolTable;
+			symbolTable.insertArray("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer, 10);
+			auto key = symbolTable.insertVar("i", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
+
+			ArrayElementOperand arrOp(0, key, &symbolTable);
+			CodeWriter stream;
+			arrOp.loadWide(stream);
+			arrOp.saveWide(stream);
+
+			std::string address = "LDA VAR1\nLXI H, ARR0\nADD A\nADD L\nMOV L, A\nMVI A, 0\nADC H\nMOV H, A\n";
+			Assert::AreEqual((address + "MOV A, M\nINX H\nMOV H, M\nMOV L, A\n" +
+				"MOV B, H\nMOV C, L\n" + address + "MOV M, C\nINX H\nMOV M, B\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(ArrayElementOperand__constantIndexGlobal) {
+			SymbolTable symbolTable;
+			symbolTable.insertArray("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer, 10);
+			symbolTable.insertArray("b", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr, 10);
+
+			ArrayElementOperand word(0, std::make_shared<NumberOperand>(3), &symbolTable);
+			ArrayElementOperand first(1, std::make_shared<NumberOperand>(0), &symbolTable);
+			CodeWriter stream;
+			word.loadWide(stream);
+			word.saveWide(stream);
+			word.save(stream);
+			first.load(stream);
+			first.save(stream);
+
+			Assert::AreEqual("LHLD ARR0+6\nSHLD ARR0+6\nMOV L, A\nMVI H, 0\nSHLD ARR0+6\nLDA ARR1\nSTA ARR1\n", stream.str().c_str());
+		}
+
+		TEST_METHOD(ArrayElementOperand__constantIndexLocal) {
+			SymbolTable symbolTable;
+			symbolTable.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
+			symbolTable.insertArray("a", 0, SymbolTable::TableRecord::RecordType::integer, 10);
+			symbolTable.calculateOffset();
+
+			ArrayElementOperand arrOp(1, std::make_shared<NumberOperand>(3), &symbolTable);
+			CodeWriter stream;
+			arrOp.load(stream, 2);
+			arrOp.save(stream);
+			arrOp.saveWide(stream);
+
+			Assert::AreEqual((std::string("LXI H, 8\nDAD SP\nMOV A, M\n") + "LXI H, 6\nDAD SP\nMOV M, A\nINX H\nMVI M, 0\n" +
+				"MOV B, H\nMOV C, L\nLXI H, 6\nDAD SP\nMOV M, C\nINX H\nMOV M, B\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(ArrayElementOperand__longGlobal) {
+			SymbolTable symbolTable;
+			symbolTable.insertArray("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer, 200);
+			auto key = symbolTable.insertVar("i", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
+
+			// Index 150 is doubled as word both at compile time and at runtime
+			ArrayElementOperand constant(0, std::make_shared<NumberOperand>(150), &symbolTable);
+			ArrayElementOperand variable(0, key, &symbolTable);
+			CodeWriter stream;
+			constant.loadWide(stream);
+			variable.loadWide(stream);
+			variable.save(stream);
+
+			std::string address = "LDA VAR1\nMOV L, A\nMVI H, 0\nDAD H\nPUSH D\nLXI D, ARR0\nDAD D\nPOP D\n";
+			Assert::AreEqual(("LHLD ARR0+300\n" + address + "MOV A, M\nINX H\nMOV H, M\nMOV L, A\n" +
+				"MOV B, A\n" + address + "MOV M, B\nINX H\nMVI M, 0\n").c_str(), stream.str().c_str());
+		}
+
+		TEST_METHOD(ArrayElementOperand__longLocal) {
+			SymbolTable symbolTable;
+			symbolTable.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 0);
+			symbolTable.insertArray("a", 0, SymbolTable::TableRecord::RecordType::chr, 150);
+			auto key = symbolTable.insertVar("i", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer);
+			symbolTable.calculateOffset();
+
+			ArrayElementOperand constant(1, std::make_shared<NumberOperand>(140), &symbolTable);
+			ArrayElementOperand variable(1, key, &symbolTable);
+			CodeWriter stream;
+			constant.load(stream, 2);
+			variable.load(stream);
+			variable.load(stream, 2);
+
+			Assert::AreEqual((std::string("LXI H, 282\nDAD SP\nMOV A, M\n") + "LHLD VAR2\nDAD H\nDAD SP\nMOV A, M\n" +
+				"LHLD VAR2\nDAD H\nDAD SP\nPUSH D\nLXI D, 2\nDAD D\nPOP D\nMOV A, M\n").c_str(), stream.str().c_str());
 		}
 
 		TEST_METHOD(ArrayElementOperand__Init)
@@ -0,0 +1,602 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(OptimizerTest)
+	{
+	public:
+
+		TEST_METHOD(Optimizer__CSE_expression)
+		{
+			std::istringstream stream("int main(){int a, b, c, d; c = a + b; d = b + a; out c; out d;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = "0 (ADD, 1, 2, 5)\n0 (OUT, , , 5)\n0 (OUT, , , 5)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__CSE_operandChanged)
+		{
+			std::istringstream stream("int main(){int a, b, c, d; c = a + b; a = 1; d = a + b; out c; out d;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = "0 (ADD, 1, 2, 5)\n0 (ADD, '1', 2, 6)\n0 (OUT, , , 5)\n0 (OUT, , , 6)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__CSE_basicBlock)
+		{
+			// Loop changes a, so the expression isn't hoisted
+			std::istringstream stream("int main(){int a, b, c, d; c = a + b; while (c) { d = a + b; a = 0; } out d;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = std::string("0 (ADD, 1, 2, 3)\n0 (LBL, , , lbl`0`)\n0 (EQ, 3, '0', lbl`1`)\n0 (ADD, 1, 2, 4)\n") +
+				"0 (MOV, '0', , 1)\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`1`)\n0 (OUT, , , 4)\n" +
+				"0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__CSE_callInvalidatesGlobals)
+		{
+			std::istringstream stream("int g; int f(){ return f() + 1; } int main(){int c, d; c = g + 1; f(); d = g + 1; out c; out d;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = std::string("1 (CALL, 1, , 2)\n1 (ADD, 2, '1', 3)\n1 (RET, , , 3)\n1 (RET, , , '0')\n") +
+				"4 (ADD, 0, '1', 7)\n4 (CALL, 1, , )\n4 (ADD, 0, '1', 9)\n4 (OUT, , , 7)\n4 (OUT, , , 9)\n" +
+				"4 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__CSE_arrayLoad)
+		{
+			std::istringstream stream("int main(){int a[5], i, c; c = a[i] - a[i]; out c;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = "0 (MOV, 1[2], , 5)\n0 (SUB, 5, 5, 4)\n0 (OUT, , , 4)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__CSE_arrayIndexExpression)
+		{
+			std::istringstream stream("int main(){int a[5], i, c, d; c = a[i - 1]; d = a[i - 1]; out c; out d;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = "0 (SUB, 2, '1', 5)\n0 (MOV, 1[5], , 3)\n0 (OUT, , , 3)\n0 (OUT, , , 3)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__CSE_arrayStore)
+		{
+			std::istringstream stream("int main(){int a[5], i, c; a[i] = 3; c = a[i] + 1; out c;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = "0 (MOV, '3', , 1[2])\n0 (ADD, '3', '1', 4)\n0 (OUT, , , 4)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__CSE_arrayIndexChanged)
+		{
+			std::istringstream stream("int main(){int a[5], i, c; a[i] = 3; i = 2; c = a[i]; out c;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = "0 (MOV, '3', , 1[2])\n0 (MOV, 1['2'], , 3)\n0 (OUT, , , 3)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+	
+		TEST_METHOD(Optimizer__licm_invariant)
+		{
+			std::istringstream stream("int main(){int i, a, b, s; in a; in b; for(i = 0; i < 4; ++i) { s = s + a * b; } out s;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			Assert::IsTrue(result.str().find("0 (MOV, '0', , 1)\n0 (MUL, 2, 3, 6)\n0 (LBL, , , lbl`0`)") != std::string::npos);
+			Assert::IsTrue(result.str().find("0 (ADD, 4, 6, 4)\n") != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__licm_changedOperand)
+		{
+			std::istringstream stream("int g; int f(){ g = g + 1; if (g > 100) f(); return 0; } int main(){int i, s; for(i = 0; i < 4; ++i) { s = g * 3; f(); } out s;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+
+			Assert::IsTrue(statistics.str().find("licm") == std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__licm_switchDefault)
+		{
+			// Jump back to default placed before case isn't a loop, code before its label is unreachable
+			std::istringstream stream("int main(){ int x, i, y; x = 1; i = 4; switch(x){ default: { out 9; } case 1: { y = i * 7; out y; } } }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+			Assert::IsTrue(result.str().find("(NE, 1, '1', lbl`3`)\n0 (MUL, 2, '7', ") != std::string::npos);
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+			Assert::IsTrue(statistics.str().find("licm") == std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__strengthReduction_induction)
+		{
+			std::istringstream stream("int main(){int i, s; for(i = 0; i < 3; ++i) { s = i * 5; out s; }}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			Assert::IsTrue(result.str().find("0 (MUL, '0', '5', 5)\n0 (LBL, , , lbl`0`)") != std::string::npos);
+			Assert::IsTrue(result.str().find("0 (ADD, 1, '1', 1)\n0 (ADD, 5, '5', 5)\n") != std::string::npos);
+			Assert::IsTrue(result.str().find("(OUT, , , 5)") != std::string::npos);
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+			Assert::IsTrue(statistics.str().find("strength reduction: multiplications 1") != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__strengthReduction_notInduction)
+		{
+			std::istringstream stream("int main(){int i, s; for(i = 0; i < 9; ++i) { s = i * 5; i = s; }}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			Assert::IsTrue(result.str().find("(MUL, 1, '5', ") != std::string::npos);
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+			Assert::IsTrue(statistics.str().find("strength reduction") == std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__strengthReduction_switchDefault)
+		{
+			// Jump back to default placed before case isn't a loop, code before its label is unreachable
+			std::istringstream stream("int main(){ int x, i, y; x = 1; i = 4; switch(x){ default: { out 9; } case 1: { y = i * 7; out y; i = i + 1; } } out i; }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+			Assert::IsTrue(result.str().find("(MUL, 2, '7', ") != std::string::npos);
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+			Assert::IsTrue(statistics.str().find("strength reduction") == std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__copies_propagated)
+		{
+			std::istringstream stream("int main(){int a, b, c; in a; b = a; c = b + 1; out c;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = "0 (IN, , , 1)\n0 (ADD, 1, '1', 4)\n0 (OUT, , , 4)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__copies_sourceChanged)
+		{
+			std::istringstream stream("int main(){int a, b, c; in a; b = a; in a; c = b + 1; out c; out a;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = std::string("0 (IN, , , 1)\n0 (MOV, 1, , 2)\n0 (IN, , , 1)\n0 (ADD, 2, '1', 4)\n") +
+				"0 (OUT, , , 4)\n0 (OUT, , , 1)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__copies_coalesced)
+		{
+			std::istringstream stream("int main(){int i, s; s = 0; for(i = 0; i < 3; ++i) { s = s + i; } out s;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			Assert::IsTrue(result.str().find("0 (LBL, , , lbl`3`)\n0 (ADD, 2, 1, 2)\n0 (JMP, , , lbl`2`)\n") != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__deadCode)
+		{
+			std::istringstream stream("int f(){ return f() + 1; } int main(){int a, b; a = 1; a = 2; b = a * 3; f(); out a;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			Assert::IsTrue(result.str().find("3 (CALL, 0, , )\n3 (OUT, , , '2')\n3 (RET, , , '0')") != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__deadCode_frame)
+		{
+			std::istringstream stream("int f(){ return f() + 1; } int main(){int a, b; a = 1; a = 2; b = a * 3; f(); out a;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Frame keeps only return value, call result isn't stored
+			std::string function = "main: ; (CALL, 0, , )\nPUSH PSW\nCALL f\nPOP H\n";
+
+			Assert::IsTrue(code.str().find(function) != std::string::npos);
+			Assert::IsTrue(code.str().find("; (RET, , , '0')\nLXI D, 0\nLXI H, 2\nDAD SP\nMOV M, E\nINX H\nMOV M, D\nRET\n") != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__types_fitting)
+		{
+			std::istringstream stream("int main(){char a, b; in a; in b; out a / b; out a % 7;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Quotient and remainder of chars fit into byte
+			Assert::IsTrue(code.str().find("CALL @DIV\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("CALL @OUTD\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("@DIV16") == std::string::npos);
+			Assert::IsTrue(code.str().find("@OUTD16") == std::string::npos);
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+			Assert::IsTrue(statistics.str().find("types: narrowed temporaries 2") != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__types_truncated)
+		{
+			std::istringstream stream("int main(){char a, b, c; in a; in b; c = a * b + 1; out c;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Product may be greater than 255, but only its low byte is stored
+			Assert::IsTrue(code.str().find("CALL @MUL\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("@MUL16") == std::string::npos);
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+			Assert::IsTrue(statistics.str().find("types: narrowed temporaries 1") != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__types_wideSum)
+		{
+			std::istringstream stream("int main(){char a, b; in a; in b; out a + b;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			Assert::IsTrue(code.str().find("DAD B\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("CALL @OUTD16\n") != std::string::npos);
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+			Assert::IsTrue(statistics.str().find("types") == std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__types_compareAboveSignedByte)
+		{
+			std::istringstream stream("int main(){ char c; in c; out (c++ > 200); out c < 130; }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Narrowed values above 127 are compared as unsigned bytes
+			Assert::IsTrue(code.str().find("MVI A, 200\nMOV B, A\nMOV A, E\nCMP B\nJNC LBL0\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("MVI A, 130\nMOV B, A\nMOV A, C\nCMP B\nJC LBL1\n") != std::string::npos);
+
+			std::ostringstream statistics;
+			translator.printOptimizationStatistics(statistics);
+			Assert::IsTrue(statistics.str().find("types: narrowed temporaries 3") != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__types_compareNegative)
+		{
+			std::istringstream stream("int main(){ char c; in c; out c > -1; }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Negative numbers don't fit unsigned byte, so they are compared as signed words
+			Assert::IsTrue(code.str().find("LXI B, 32767\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("CMP B\n") == std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__types_negativeConstants)
+		{
+			std::istringstream stream("int main(){ char c; int x; in c; x = -7; out c / -2; out x; }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Propagated negative constant is printed and divided by as signed word
+			Assert::IsTrue(code.str().find("; (OUT, , , '-7')\nLXI H, -7\nCALL @OUTD16\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("CALL @DIV16\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("@DIV:") == std::string::npos);
+			Assert::IsTrue(code.str().find("@OUTD:") == std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__registers_loop)
+		{
+			std::istringstream stream("int main(){char i, s; s = 0; for(i = 0; i < 3; ++i) { s = s + i; } out s;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			std::string increment = "; (ADD, 1, '1', 1)\nMVI A, 1\nMOV B, A\nMOV A, C\nADD B\nMOV C, A\n";
+			std::string sum = "; (ADD, 2, 1, 2)\nMOV A, C\nMOV B, A\nMOV A, E\nADD B\nMOV E, A\n";
+
+			Assert::IsTrue(code.str().find(increment) != std::string::npos);
+			Assert::IsTrue(code.str().find(sum) != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__registers_params)
+		{
+			std::istringstream stream("int f(int a, int b){ return a - b; } int main(){ out f(5, 2); }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Words take DE pair, so only the first param is placed into register
+			std::string function = std::string("f: LXI H, 4\nDAD SP\nMOV E, M\nINX H\nMOV D, M\n") +
+				"; (SUB, 1, 2, 3)\nLXI H, 2\nDAD SP\nMOV A, M\nINX H\nMOV H, M\nMOV L, A\nMOV B, H\nMOV C, L\n" +
+				"MOV L, E\nMOV H, D\nMOV A, L\nSUB C\nMOV L, A\nMOV A, H\nSBB B\nMOV H, A\nMOV E, L\nMOV D, H\n";
+
+			Assert::IsTrue(code.str().find(function) != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__registers_readBeforeWrite)
+		{
+			std::istringstream stream("int main(){int s; s = s + 1; out s;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			std::string expression = "; (ADD, 1, '1', 2)\nLXI H, 0\nDAD SP\nMOV A, M\nINX H\nMOV H, M\nMOV L, A\nINX H\nMOV E, L\nMOV D, H\n";
+
+			Assert::IsTrue(code.str().find(expression) != std::string::npos);
+		}
+
+		TEST_METHOD(Optimizer__registers_clobbered)
+		{
+			std::istringstream stream("int main(){char a, b; in a; b = a * a; out b; out a;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Library routines keep C, D and E
+			Assert::IsTrue(code.str().find("; (IN, , , 1)\nIN 0\nMOV C, A\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("; (OUT, , , 1)\nMOV A, C\nCALL @OUTD\n") != std::string::npos);
+		}
+	
+		TEST_METHOD(Optimizer__inline_leaf)
+		{
+			std::istringstream stream("int twice(int x){ return x + x; } int main(){ int a; a = twice(3); out a; }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = std::string("0 (ADD, 1, 1, 2)\n0 (RET, , , 2)\n0 (RET, , , '0')\n3 (ADD, '3', '3', 5)\n") +
+				"3 (LBL, , , lbl`0`)\n3 (OUT, , , 5)\n3 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__inline_returns)
+		{
+			std::istringstream stream("int sign(int x){ if (x == 0) return 0; return 1; } int main(){ int a; a = sign(3); out a; }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = std::string("0 (MOV, '1', , 2)\n0 (EQ, 1, '0', lbl`0`)\n0 (MOV, '0', , 2)\n0 (LBL, , , lbl`0`)\n") +
+				"0 (EQ, 2, '0', lbl`1`)\n0 (RET, , , '0')\n0 (JMP, , , lbl`2`)\n0 (LBL, , , lbl`1`)\n" +
+				"0 (LBL, , , lbl`2`)\n0 (RET, , , '1')\n0 (RET, , , '0')\n3 (MOV, '1', , 7)\n" +
+				"3 (EQ, '3', '0', lbl`4`)\n3 (MOV, '0', , 7)\n3 (LBL, , , lbl`4`)\n3 (EQ, 7, '0', lbl`5`)\n" +
+				"3 (MOV, '0', , 5)\n3 (JMP, , , lbl`3`)\n3 (LBL, , , lbl`5`)\n3 (LBL, , , lbl`6`)\n" +
+				"3 (MOV, '1', , 5)\n3 (LBL, , , lbl`3`)\n3 (OUT, , , 5)\n3 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Optimizer__inline_charResult)
+		{
+			std::istringstream stream("char low(int x){ return x + 250; } int main(){ int a; in a; out low(a); }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			// Returned value is truncated to char before it becomes result of call
+			Assert::IsTrue(result.str().find("3 (ADD, 4, '250', 8)\n3 (MOV, 8, , 5)\n") != std::string::npos);
+			Assert::IsTrue(SymbolTable::TableRecord::RecordType::chr == translator.symbolTable()[8].type);
+		}
+	
+		TEST_METHOD(Optimizer__tailRecursion)
+		{
+			std::istringstream stream("int sum(int n, int acc){ if (n == 0) return acc; return sum(n - 1, acc + n); } int main(){ out sum(4, 0); }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = std::string("0 (LBL, , , lbl`3`)\n0 (MOV, '1', , 3)\n0 (EQ, 1, '0', lbl`0`)\n0 (MOV, '0', , 3)\n") +
+				"0 (LBL, , , lbl`0`)\n0 (EQ, 3, '0', lbl`1`)\n0 (RET, , , 2)\n0 (JMP, , , lbl`2`)\n0 (LBL, , , lbl`1`)\n" +
+				"0 (LBL, , , lbl`2`)\n0 (SUB, 1, '1', 4)\n0 (ADD, 2, 1, 5)\n0 (MOV, 4, , 1)\n0 (MOV, 5, , 2)\n" +
+				"0 (JMP, , , lbl`3`)\n0 (RET, , , '0')\n";
+
+			Assert::AreEqual(excepted.c_str(), result.str().substr(0, excepted.size()).c_str());
+		}
+
+		TEST_METHOD(Optimizer__tailRecursion_swappedParams)
+		{
+			std::istringstream stream("int f(int a, int b){ if (a < b) return f(b, a); return a - b; } int main(){ out f(2, 5); }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string swap = "0 (MOV, 1, , 9)\n0 (MOV, 2, , 1)\n0 (MOV, 9, , 2)\n0 (JMP, , , lbl`3`)\n";
+
+			Assert::IsTrue(result.str().find(swap) != std::string::npos);
+		}
+	};
+}
@@ -0,0 +1,96 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include "Runtime\Runtime.h"
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(RuntimeTest)
+	{
+	public:
+
+		TEST_METHOD(Runtime__worstCase)
+		{
+			// Bounds are sums of all instructions, fixed here so that changes of routines are noticed
+			Assert::AreEqual(304u, Runtime::worstCase(Runtime::MUL));
+			Assert::AreEqual(798u, Runtime::worstCase(Runtime::MUL16));
+			Assert::AreEqual(451u, Runtime::worstCase(Runtime::DIV));
+			Assert::AreEqual(2014u, Runtime::worstCase(Runtime::DIV16));
+			Assert::AreEqual(365u, Runtime::worstCase(Runtime::PRINT_NUMBER));
+			Assert::AreEqual(1331u, Runtime::worstCase(Runtime::PRINT_NUMBER16));
+			Assert::AreEqual(47u, Runtime::worstCase(Runtime::PRINT));
+		}
+
+		TEST_METHOD(Runtime__print)
+		{
+			CodeWriter code;
+			Runtime::generate(code, { Runtime::PRINT });
+
+			Assert::AreEqual("@PRINT:\nMOV A, M\nORA A\nRZ\nOUT 1\nINX H\nJMP @PRINT\n", code.str().c_str());
+		}
+
+		TEST_METHOD(Runtime__signed)
+		{
+			// Words are divided and printed as magnitudes with signs
+			CodeWriter code;
+			Runtime::generate(code, { Runtime::DIV16, Runtime::PRINT_NUMBER16 });
+
+			const std::string negate = "MOV A, L\nCMA\nMOV L, A\nMOV A, H\nCMA\nMOV H, A\nINX H\n";
+			Assert::IsTrue(code.str().find("@DIV16:\nMOV A, H\nPUSH PSW\nXRA D\nPUSH PSW\nMOV A, H\nORA A\nJP @DIV16X\n" + negate) == 0);
+			Assert::IsTrue(code.str().find("POP PSW\nORA A\nJP @DIV16Q\n" + negate + "@DIV16Q:\nPOP PSW\nORA A\nRP\n"
+				"MOV A, C\nCMA\nMOV C, A\nMOV A, B\nCMA\nMOV B, A\nINX B\nRET\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("@OUTD16:\nMOV A, H\nORA A\nJP @OUTD16P\nMVI A, '-'\nOUT 1\n" + negate + "@OUTD16P:\n") != std::string::npos);
+		}
+
+		TEST_METHOD(Runtime__referencedOnly)
+		{
+			std::istringstream stream("int main(){int a; in a; out a * a; out \"done\";}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			Assert::IsTrue(code.str().find("@MUL16:\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("@OUTD16:\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("@PRINT:\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("@MUL:") == std::string::npos);
+			Assert::IsTrue(code.str().find("@OUTD:") == std::string::npos);
+			Assert::IsTrue(code.str().find("@DIV") == std::string::npos);
+		}
+
+		TEST_METHOD(Runtime__charRoutines)
+		{
+			std::istringstream stream("int main(){char a; in a; out a / 3;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			// Quotient of chars is computed by byte routine, but it's printed as int temporary
+			Assert::IsTrue(code.str().find("@DIV:\n") != std::string::npos);
+			Assert::IsTrue(code.str().find("@DIV16:") == std::string::npos);
+			Assert::IsTrue(code.str().find("@OUTD16:\n") != std::string::npos);
+		}
+
+		TEST_METHOD(Runtime__noCalls)
+		{
+			std::istringstream stream("int main(){int a; a = 2 * 3;}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+
+			Assert::IsTrue(code.str().find("@") == std::string::npos);
+		}
+	};
+}
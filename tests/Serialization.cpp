@@ -0,0 +1,152 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include "Serialization\BinaryStream.h"
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(SerializationTest)
+	{
+	public:
+		const std::string PROGRAM = "int g = 3; char s[4];\n"
+			"int twice(int x){ return x + x; }\n"
+			"int fact(int n){ if(n < 2) return 1; return n * fact(n - 1); }\n"
+			"int kind(int c){ switch(c){ case 0: return 5; case 1: return 7; case 2: return 9; case 3: return 11; default: return 0; } }\n"
+			"int main(){ int i; in i; for(i = 0; i < 4; ++i){ s[i] = twice(i) + g; } out fact(s[2]); out kind(i); out \"done\"; return 0; }";
+
+		// Saves state of translator and loads it by other one
+		std::string roundTrip(Translator& translator, Translator& loaded)
+		{
+			std::stringstream state;
+			translator.save(state);
+			loaded.load(state);
+			return state.str();
+		}
+
+		std::string code(const Translator& translator)
+		{
+			std::ostringstream stream;
+			translator.generateCode(stream);
+			return stream.str();
+		}
+
+		TEST_METHOD(Serialization__numbers)
+		{
+			BinaryWriter writer;
+			writer.writeUnsigned(5);
+			writer.writeInt(-1);
+			writer.writeUnsigned(300);
+			writer.writeInt(-2147483647 - 1);
+			writer.writeUnsigned(14695981039346656037ULL);
+			writer.writeString(std::string("a\0b", 3));
+			writer.writeBool(true);
+
+			// Small numbers take one byte
+			Assert::AreEqual('\x05', writer.data()[0]);
+			Assert::AreEqual('\x01', writer.data()[1]);
+
+			BinaryReader reader(writer.data());
+			Assert::AreEqual(5ULL, (unsigned long long)reader.readUnsigned());
+			Assert::AreEqual(-1LL, (long long)reader.readInt());
+			Assert::AreEqual(300ULL, (unsigned long long)reader.readUnsigned());
+			Assert::AreEqual(-2147483648LL, (long long)reader.readInt());
+			Assert::AreEqual(14695981039346656037ULL, (unsigned long long)reader.readUnsigned());
+			Assert::IsTrue(std::string("a\0b", 3) == reader.readString());
+			Assert::IsTrue(reader.readBool());
+			Assert::IsTrue(reader.atEnd());
+
+			Assert::ExpectException<FormatError>([&reader]() { reader.readUnsigned(); });
+		}
+
+		TEST_METHOD(Serialization__translatedState)
+		{
+			std::istringstream stream(PROGRAM);
+			Translator translator(stream);
+			Assert::IsTrue(translator.translate());
+
+			std::istringstream empty;
+			Translator loaded(empty);
+			roundTrip(translator, loaded);
+
+			std::ostringstream atoms, loadedAtoms;
+			translator.printAtoms(atoms);
+			loaded.printAtoms(loadedAtoms);
+			Assert::AreEqual(atoms.str().c_str(), loadedAtoms.str().c_str());
+
+			// Loaded state is optimized the same way
+			translator.optimize();
+			loaded.optimize();
+			Assert::AreEqual(code(translator).c_str(), code(loaded).c_str());
+			Assert::AreEqual(translator.atoms(2)[0]->position().line, loaded.atoms(2)[0]->position().line);
+		}
+
+		TEST_METHOD(Serialization__optimizedState)
+		{
+			std::istringstream stream(PROGRAM);
+			Translator translator(stream);
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::istringstream empty;
+			Translator loaded(empty);
+			roundTrip(translator, loaded);
+
+			std::ostringstream table, loadedTable, statistics, loadedStatistics;
+			translator.printSymbolTable(table);
+			loaded.printSymbolTable(loadedTable);
+			translator.printOptimizationStatistics(statistics);
+			loaded.printOptimizationStatistics(loadedStatistics);
+
+			Assert::AreEqual(table.str().c_str(), loadedTable.str().c_str());
+			Assert::AreEqual(statistics.str().c_str(), loadedStatistics.str().c_str());
+			Assert::AreEqual(code(translator).c_str(), code(loaded).c_str());
+		}
+
+		TEST_METHOD(Serialization__diagnostics)
+		{
+			std::istringstream stream("int main(){ int a; a = ; out a; }");
+			std::ostringstream errors;
+			Translator translator(stream, errors);
+			Assert::IsFalse(translator.translate());
+
+			std::istringstream empty;
+			Translator loaded(empty);
+			roundTrip(translator, loaded);
+
+			Assert::AreEqual(1u, (unsigned int)loaded.diagnostics().size());
+			Assert::AreEqual(translator.diagnostics()[0].message.c_str(), loaded.diagnostics()[0].message.c_str());
+			Assert::AreEqual(1u, loaded.diagnostics()[0].position.line);
+			Assert::AreEqual("", code(loaded).c_str());
+		}
+
+		TEST_METHOD(Serialization__invalidState)
+		{
+			std::istringstream stream(PROGRAM);
+			Translator translator(stream);
+			Assert::IsTrue(translator.translate());
+
+			std::istringstream empty;
+			Translator loaded(empty);
+			const std::string state = roundTrip(translator, loaded);
+
+			// Every truncated state is rejected
+			for (unsigned int size = 0; size < state.size(); ++size) {
+				std::istringstream truncated(state.substr(0, size));
+				Assert::ExpectException<FormatError>([&loaded, &truncated]() { loaded.load(truncated); });
+			}
+			Assert::AreEqual(0u, loaded.symbolTable().size());
+
+			// Version follows magic string
+			std::string other = state;
+			other[12] = Translator::STATE_VERSION + 1;
+			std::istringstream otherVersion(other);
+			Assert::ExpectException<FormatError>([&loaded, &otherVersion]() { loaded.load(otherVersion); });
+
+			std::istringstream text("MINIC-CACHE 1 0\n");
+			Assert::ExpectException<FormatError>([&loaded, &text]() { loaded.load(text); });
+		}
+	};
+}
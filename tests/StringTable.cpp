@@ -67,7 +67,7 @@ namespace tests
 		}
 
 		TEST_METHOD(StringTable__generateGlobals) {
-			std::ostringstream stream;
+			CodeWriter stream;
 			StringTable table;
 
 			table.insert("First");
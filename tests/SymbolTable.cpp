@@ -202,16 +202,16 @@ namespace tests
 		}
 
 		TEST_METHOD(SymbolTable__generateGlobals) {
-			std::ostringstream stream;
+			CodeWriter stream;
 			SymbolTable table;
 
 			table.insertVar("a", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer, 10);
-			table.insertVar("c", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer);
+			table.insertVar("c", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::chr);
 			table.insertVar("b", SymbolTable::GLOBAL_SCOPE, SymbolTable::TableRecord::RecordType::integer);
 			table.insertVar("b", 4, SymbolTable::TableRecord::RecordType::integer);
 			table.generateGlobalsSection(stream);
 
-			Assert::AreEqual("var0: DB 10\nvar1: DB 0\nvar2: DB 0\n", stream.str().c_str());
+			Assert::AreEqual("var0: DW 10\nvar1: DB 0\nvar2: DW 0\n", stream.str().c_str());
 		}
 
 		TEST_METHOD(SymbolTable__offsetWithArrays)
@@ -245,5 +245,23 @@ namespace tests
 
 			Assert::AreEqual(excepted.c_str(), result.str().c_str());
 		}
+
+		TEST_METHOD(SymbolTable__releaseSlot)
+		{
+			SymbolTable table;
+			table.insertFunc("f", SymbolTable::TableRecord::RecordType::integer, 1);
+			table.insertVar("p", 0, SymbolTable::TableRecord::RecordType::integer);
+			table.insertVar("a", 0, SymbolTable::TableRecord::RecordType::integer);
+			table.insertVar("b", 0, SymbolTable::TableRecord::RecordType::integer);
+
+			table.releaseSlot(2);
+			table.calculateOffset();
+
+			Assert::AreEqual(1u, table.getLocalsCount(0));
+			Assert::AreEqual(6, table[0].offset);
+			Assert::AreEqual(4, table[1].offset);
+			Assert::AreEqual(-1, table[2].offset);
+			Assert::AreEqual(0, table[3].offset);
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include "Server\TranslationServer.h"
+#include "Serialization\BinaryStream.h"
+#include <sstream>
+#include <map>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(TranslationServerTest)
+	{
+	public:
+		const std::string PROGRAM = "int g = 2;\n"
+			"int f(int a){ return a * 2 + g; }\n"
+			"int main(){ int i; for(i = 0; i < 3; ++i){ out f(i); } return 0; }";
+
+		const std::string OTHER = "int main(){ int a, b; in a; b = a + 1; out b; return 0; }";
+
+		const std::string WRONG = "int main(){ int a;\n a = ; }";
+
+		std::string compile(const std::string& source, const bool optimize)
+		{
+			std::istringstream stream(source);
+			Translator translator(stream);
+			Assert::IsTrue(translator.translate());
+			if (optimize) {
+				translator.optimize();
+			}
+
+			std::ostringstream code;
+			translator.generateCode(code);
+			return code.str();
+		}
+
+		std::string request(const uint64_t id, const std::string& source, const bool optimize = true)
+		{
+			TranslationServer::Request request;
+			request.id = id;
+			request.optimize = optimize;
+			request.source = source;
+
+			std::ostringstream message;
+			TranslationServer::writeMessage(message, TranslationServer::encodeRequest(request));
+			return message.str();
+		}
+
+		std::map<uint64_t, TranslationServer::Response> responses(const std::string& output)
+		{
+			std::map<uint64_t, TranslationServer::Response> result;
+			std::istringstream stream(output);
+			std::string payload;
+			while (TranslationServer::readMessage(stream, payload)) {
+				TranslationServer::Response response = TranslationServer::decodeResponse(payload);
+				Assert::IsTrue(result.insert({ response.id, response }).second);
+			}
+			return result;
+		}
+
+		TEST_METHOD(TranslationServer__serve)
+		{
+			const unsigned int count = 30;
+			std::string requests;
+			for (unsigned int i = 0; i < count; ++i) {
+				requests += request(i, i % 3 == 0 ? PROGRAM : (i % 3 == 1 ? OTHER : WRONG), i % 2 == 0);
+			}
+
+			std::istringstream input(requests);
+			std::ostringstream output;
+			Assert::AreEqual(count, TranslationServer(3).serve(input, output));
+
+			// Every request is answered once, workers reuse translators between sources
+			auto result = responses(output.str());
+			Assert::AreEqual(count, (unsigned int)result.size());
+			for (unsigned int i = 0; i < count; ++i) {
+				const TranslationServer::Response& response = result[i];
+				if (i % 3 == 2) {
+					Assert::IsFalse(response.translated);
+					Assert::AreEqual(1u, (unsigned int)response.diagnostics.size());
+					Assert::AreEqual(2u, response.diagnostics[0].position.line);
+					Assert::IsTrue(response.code.empty());
+				}
+				else {
+					Assert::IsTrue(response.translated);
+					Assert::IsTrue(response.diagnostics.empty());
+					Assert::AreEqual(compile(i % 3 == 0 ? PROGRAM : OTHER, i % 2 == 0).c_str(), response.code.c_str());
+					Assert::IsFalse(response.atoms.empty());
+				}
+			}
+		}
+
+		TEST_METHOD(TranslationServer__lexicalError)
+		{
+			// Error in the first lexem is reported, not thrown by reset
+			std::ostringstream errors;
+			Translator translator(nullptr, 0, errors);
+
+			TranslationServer::Request request;
+			request.source = "@main(){}";
+			TranslationServer::Response response = TranslationServer::translate(translator, request);
+			Assert::IsFalse(response.translated);
+			Assert::AreEqual(1u, (unsigned int)response.diagnostics.size());
+
+			request.source = OTHER;
+			Assert::IsTrue(TranslationServer::translate(translator, request).translated);
+		}
+
+		TEST_METHOD(TranslationServer__messages)
+		{
+			TranslationServer::Response response;
+			response.id = 1ull << 40;
+			response.diagnostics.push_back({ { 3, 7 }, "Syntax error: text" });
+			response.code = std::string("ORG 8000H\n\0", 11);
+
+			TranslationServer::Response decoded = TranslationServer::decodeResponse(TranslationServer::encodeResponse(response));
+			Assert::IsTrue(response.id == decoded.id);
+			Assert::AreEqual(7u, decoded.diagnostics[0].position.column);
+			Assert::AreEqual(response.diagnostics[0].message.c_str(), decoded.diagnostics[0].message.c_str());
+			Assert::IsTrue(response.code == decoded.code);
+
+			// Empty input has no messages, truncated message is an error
+			std::istringstream empty("");
+			std::string payload;
+			Assert::IsFalse(TranslationServer::readMessage(empty, payload));
+
+			const std::string message = request(5, OTHER);
+			std::istringstream truncated(message.substr(0, message.size() - 1));
+			std::ostringstream output;
+			Assert::ExpectException<FormatError>([&truncated, &output]() { TranslationServer(2).serve(truncated, output); });
+
+			std::istringstream large(std::string("\xFF\xFF\xFF\xFF", 4));
+			Assert::ExpectException<FormatError>([&large, &payload]() { TranslationServer::readMessage(large, payload); });
+		}
+	};
+}
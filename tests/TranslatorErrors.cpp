@@ -23,7 +23,7 @@ namespace tests
 
 			translator.translateExpression(0);
 
-			Assert::AreEqual("Lexical error: Unknown symbol '?'\nAfter lexems: [opplus] [id, \"str2\"] [opplus]", errors.str().c_str());
+			Assert::AreEqual("1:13: Lexical error: Unknown symbol '?'\nAfter lexems: [opplus] [id, \"str2\"] [opplus]", errors.str().c_str());
 		}
 
 		TEST_METHOD(Translator__LexicalException_incompleteAnd)
@@ -35,7 +35,7 @@ namespace tests
 
 			translator.translateExpression(0);
 
-			Assert::AreEqual("Lexical error: Incomplete AND operator\nAfter lexems: [id, \"str\"]", errors.str().c_str());
+			Assert::AreEqual("1:5: Lexical error: Incomplete AND operator\nAfter lexems: [id, \"str\"]", errors.str().c_str());
 		}
 
 		TEST_METHOD(Translator__SyntaxException_excessLexems)
@@ -49,7 +49,7 @@ namespace tests
 
 			translator.translateExpression(0);
 
-			Assert::AreEqual("Syntax error: Excess lexems are left after translation\nAfter lexems: [id, \"str\"] [opand] [id, \"str2\"]", errors.str().c_str());
+			Assert::AreEqual("1:13: Syntax error: Excess lexems are left after translation\nAfter lexems: [id, \"str\"] [opand] [id, \"str2\"]", errors.str().c_str());
 		}
 
 		TEST_METHOD(Translator__SyntaxException_unexceptedEOF)
@@ -63,7 +63,7 @@ namespace tests
 
 			translator.translateExpression(0);
 
-			Assert::AreEqual("Syntax error: Rule #24-28. Unxepected lexem '[eof]' in expression, expected ++, (, num, id.\nAfter lexems: [id, \"str\"] [opand]", errors.str().c_str());
+			Assert::AreEqual("1:7: Syntax error: Rule #24-28. Unxepected lexem '[eof]' in expression, expected ++, (, num, id.\nAfter lexems: [id, \"str\"] [opand]", errors.str().c_str());
 		}
 
 		TEST_METHOD(Translator__SyntaxException_otherLexemExcepted)
@@ -77,7 +77,7 @@ namespace tests
 
 			translator.translateExpression(0);
 
-			Assert::AreEqual("Syntax error: Expected rpar, got [eof]\nAfter lexems: [id, \"str\"] [opand] [id, \"str2\"]", errors.str().c_str());
+			Assert::AreEqual("1:13: Syntax error: Expected rpar, got [eof]\nAfter lexems: [id, \"str\"] [opand] [id, \"str2\"]", errors.str().c_str());
 		}
 
 		TEST_METHOD(Translator__SyntaxException_noMain)
@@ -93,7 +93,7 @@ namespace tests
 			std::ostringstream result;
 			translator.printAtoms(result, 0);
 
-			Assert::AreEqual("Syntax error: No entry point for given program\nAfter lexems: [rpar] [lbrace] [rbrace]", errors.str().c_str());
+			Assert::AreEqual("1:13: Syntax error: No entry point for given program\nAfter lexems: [rpar] [lbrace] [rbrace]", errors.str().c_str());
 		}
 
 		TEST_METHOD(Translator__SyntaxError_doubleDefault) {
@@ -107,7 +107,110 @@ namespace tests
 			std::ostringstream result;
 			translator.printAtoms(result, 0);
 
-			Assert::AreEqual("Syntax error: There can't be more than ONE default section in case.\nAfter lexems: [kwreturn] [num, 0] [semicolon]", errors.str().c_str());
+			Assert::AreEqual("1:111: Syntax error: There can't be more than ONE default section in case.\nAfter lexems: [kwreturn] [num, 0] [semicolon]", errors.str().c_str());
+		}
+
+		TEST_METHOD(Translator__SyntaxError_indexOutOfBounds) {
+			std::istringstream stream("int main(){int a[10]; a[10] = 1; return 0;}");
+			std::ostringstream errors("");
+			Translator translator(stream, errors);
+
+			Assert::IsFalse(translator.translate());
+			Assert::AreEqual("1:29: Syntax error: Index 10 is out of bounds of array a[10]\nAfter lexems: [lbracket] [num, 10] [rbracket]", errors.str().c_str());
+		}
+
+		TEST_METHOD(Translator__SyntaxError_readIndexOutOfBounds) {
+			std::istringstream stream("int g[4]; int main(){int x; x = g[3] + g[7]; return x;}");
+			std::ostringstream errors("");
+			Translator translator(stream, errors);
+
+			Assert::IsFalse(translator.translate());
+			Assert::AreEqual("1:44: Syntax error: Index 7 is out of bounds of array g[4]\nAfter lexems: [lbracket] [num, 7] [rbracket]", errors.str().c_str());
+		}
+
+		TEST_METHOD(Translator__SyntaxError_nestingDepth) {
+			std::istringstream stream("int main(){ { { out 1; } } return 0; }");
+			std::ostringstream errors("");
+			Translator translator(stream, errors);
+			translator.setMaxDepth(3);
+
+			Assert::IsFalse(translator.translate());
+			Assert::AreEqual("1:17: Syntax error: Nesting depth exceeds limit of 3\nAfter lexems: [lbrace] [lbrace] [lbrace]", errors.str().c_str());
+		}
+
+		TEST_METHOD(Translator__SyntaxError_deepParentheses) {
+			// Deeper than default limit, must be rejected before native stack is exhausted
+			std::string program = "int main(){ out " + std::string(5000, '(') + "1" + std::string(5000, ')') + "; }";
+			std::istringstream stream(program);
+			std::ostringstream errors("");
+			Translator translator(stream, errors);
+
+			Assert::IsFalse(translator.translate());
+			Assert::AreEqual(("1:271: Syntax error: Nesting depth exceeds limit of " + std::to_string(Translator::DEFAULT_MAX_DEPTH) +
+				"\nAfter lexems: [lpar] [lpar] [lpar]").c_str(), errors.str().c_str());
+		}
+
+		TEST_METHOD(Translator__Recovery_severalErrors) {
+			std::istringstream stream("int main(){\n int a;\n a = ;\n out a;\n a = 1 +;\n return a;\n}");
+			std::ostringstream errors("");
+			Translator translator(stream, errors);
+
+			Assert::IsFalse(translator.translate());
+
+			auto diagnostics = translator.diagnostics();
+			Assert::AreEqual(2, (int)diagnostics.size());
+			Assert::AreEqual(3u, diagnostics[0].position.line);
+			Assert::AreEqual(6u, diagnostics[0].position.column);
+			Assert::AreEqual(5u, diagnostics[1].position.line);
+			Assert::AreEqual(9u, diagnostics[1].position.column);
+
+			Assert::AreEqual("3:6: Syntax error: Rule #24-28. Unxepected lexem '[semicolon]' in expression, expected ++, (, num, id."
+				"\nAfter lexems: [semicolon] [id, \"a\"] [opassign]"
+				"\n5:9: Syntax error: Rule #24-28. Unxepected lexem '[semicolon]' in expression, expected ++, (, num, id."
+				"\nAfter lexems: [opassign] [num, 1] [opplus]", errors.str().c_str());
+		}
+
+		TEST_METHOD(Translator__Recovery_nestedBlocks) {
+			// Block of failed statement is skipped entirely, lexical errors are collected too
+			std::istringstream stream("int main(){\n int a;\n a = 2 ? 3;\n if (a { out a; }\n a = 1;\n return 0;\n}\n"
+				"int f(){ return 1 }");
+			std::ostringstream errors("");
+			Translator translator(stream, errors);
+
+			Assert::IsFalse(translator.translate());
+
+			auto diagnostics = translator.diagnostics();
+			Assert::AreEqual(3, (int)diagnostics.size());
+			Assert::AreEqual("Lexical error: Unknown symbol '?'\nAfter lexems: [id, \"a\"] [opassign] [num, 2]", diagnostics[0].message.c_str());
+			Assert::AreEqual(3u, diagnostics[0].position.line);
+			Assert::AreEqual("Syntax error: Expected rpar, got [lbrace]\nAfter lexems: [kwif] [lpar] [id, \"a\"]", diagnostics[1].message.c_str());
+			Assert::AreEqual(4u, diagnostics[1].position.line);
+			Assert::AreEqual("Syntax error: Expected semicolon, got [rbrace]\nAfter lexems: [lbrace] [kwreturn] [num, 1]", diagnostics[2].message.c_str());
+			Assert::AreEqual(8u, diagnostics[2].position.line);
+			Assert::AreEqual(19u, diagnostics[2].position.column);
+		}
+
+		TEST_METHOD(Translator__Recovery_declaration) {
+			// Translation goes on from the next declaration, so b is known
+			std::istringstream stream("int main(){\n int a\n char b;\n b = 1;\n return b;\n}");
+			std::ostringstream errors("");
+			Translator translator(stream, errors);
+
+			Assert::IsFalse(translator.translate());
+			Assert::AreEqual("3:2: Syntax error: Expected semicolon, got [kwchar]\nAfter lexems: [lbrace] [kwint] [id, \"a\"]", errors.str().c_str());
+		}
+
+		TEST_METHOD(Translator__Recovery_noCode) {
+			std::istringstream stream("int main(){ int a; a = (1; out a; return 0; }");
+			std::ostringstream errors("");
+			Translator translator(stream, errors);
+
+			Assert::IsFalse(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+			Assert::AreEqual("", code.str().c_str());
 		}
 	};
-}
\ No newline at end of file
+}
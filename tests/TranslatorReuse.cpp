@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Translator\Translator.h"
+#include <sstream>
+#include <chrono>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace tests
+{
+	TEST_CLASS(TranslatorReuseTest)
+	{
+	public:
+		const std::string PROGRAM = "int g = 2; char s[3];\n"
+			"int f(int a){ return a * 2 + g; }\n"
+			"int main(){ int i; for(i = 0; i < 3; ++i){ s[i] = f(i); out s[i]; } out \"end\"; return 0; }";
+
+		const std::string OTHER = "int main(){ int a, b; in a; b = a + 1; out b; return 0; }";
+
+		std::string compile(Translator& translator)
+		{
+			Assert::IsTrue(translator.translate());
+			translator.optimize();
+
+			std::ostringstream code;
+			translator.generateCode(code);
+			return code.str();
+		}
+
+		std::string compileFresh(const std::string& source)
+		{
+			std::istringstream stream(source);
+			Translator translator(stream);
+			return compile(translator);
+		}
+
+		TEST_METHOD(TranslatorReuse__buffer)
+		{
+			Translator translator(PROGRAM.data(), PROGRAM.size());
+			Assert::AreEqual(compileFresh(PROGRAM).c_str(), compile(translator).c_str());
+
+			// Buffer isn't required to be terminated
+			const std::string source = "int main(){ out 1; }garbage";
+			std::ostringstream errors;
+			Translator part(source.data(), source.size() - 7, errors);
+			Assert::IsTrue(part.translate());
+		}
+
+		TEST_METHOD(TranslatorReuse__reset)
+		{
+			Translator translator(PROGRAM.data(), PROGRAM.size());
+			compile(translator);
+
+			translator.reset(OTHER.data(), OTHER.size());
+			Assert::AreEqual(compileFresh(OTHER).c_str(), compile(translator).c_str());
+			Assert::AreEqual(4u, translator.symbolTable().size());
+
+			std::istringstream stream(PROGRAM);
+			translator.reset(stream);
+			Assert::AreEqual(compileFresh(PROGRAM).c_str(), compile(translator).c_str());
+		}
+
+		TEST_METHOD(TranslatorReuse__resetAfterErrors)
+		{
+			std::ostringstream errors;
+			const std::string wrong = "int main(){ int a;\n a = ; }";
+			Translator translator(wrong.data(), wrong.size(), errors);
+			translator.setSeparateCompilation(true);
+
+			Assert::IsFalse(translator.translate());
+			Assert::AreEqual(2u, translator.diagnostics()[0].position.line);
+
+			// Diagnostics are cleared, settings are kept
+			translator.reset(OTHER.data(), OTHER.size());
+			Assert::IsTrue(translator.translate());
+			Assert::AreEqual(0u, (unsigned int)translator.diagnostics().size());
+
+			const std::string module = "int f(int a); int g(){ return f(1); }";
+			translator.reset(module.data(), module.size());
+			Assert::IsTrue(translator.translate());
+		}
+
+		TEST_METHOD(TranslatorReuse__benchmark)
+		{
+			// Latency of many small translations by new translators and by the reused one.
+			// Optimization and code generation don't depend on it, so only translation is timed
+			const unsigned int count = 1000;
+			unsigned int atoms = 0;
+
+			auto start = std::chrono::steady_clock::now();
+			for (unsigned int i = 0; i < count; ++i) {
+				std::istringstream stream(PROGRAM);
+				Translator translator(stream);
+				Assert::IsTrue(translator.translate());
+				atoms += (unsigned int)translator.atoms(6).size();
+			}
+			auto fresh = std::chrono::steady_clock::now() - start;
+
+			Translator translator(PROGRAM.data(), PROGRAM.size());
+			start = std::chrono::steady_clock::now();
+			for (unsigned int i = 0; i < count; ++i) {
+				translator.reset(PROGRAM.data(), PROGRAM.size());
+				Assert::IsTrue(translator.translate());
+				atoms -= (unsigned int)translator.atoms(6).size();
+			}
+			auto reused = std::chrono::steady_clock::now() - start;
+
+			Assert::AreEqual(0u, atoms);
+
+			std::ostringstream message;
+			message << "Translation of " << PROGRAM.size() << " bytes: new translator "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(fresh).count() / count << " us, reused "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(reused).count() / count << " us";
+			Logger::WriteMessage(message.str().c_str());
+		}
+	};
+}
@@ -176,6 +176,21 @@ namespace tests
 			Assert::AreEqual("[MemOp, 0, var]", result->toString(true).c_str());
 		}
 
+		TEST_METHOD(Translator__E3_opdivmod)
+		{
+			std::istringstream stream("7 / 2 % 3 * 4");
+			Translator translator(stream);
+
+			auto result = translator.translateExpresssion();
+
+			Assert::AreEqual("[MemOp, 2, [tmp2]]", result->toString(true).c_str());
+
+			std::ostringstream atoms;
+			translator.printAtoms(atoms, 2);
+
+			Assert::AreEqual("-1 (DIV, '7', '2', 0)\n-1 (MOD, 0, '3', 1)\n-1 (MUL, 1, '4', 2)", atoms.str().c_str());
+		}
+
 		TEST_METHOD(Translator__E3_opmult)
 		{
 			// Case 1
@@ -1066,5 +1081,157 @@ namespace tests
 
 			Assert::AreEqual(excepted.c_str(), result.str().c_str());
 		}
+	
+		TEST_METHOD(Translator__CaseOp_table) {
+			std::istringstream stream("int main(){int i; switch(i){case 0: i = 1; case 1: i = 2; case 3: i = 3; default: i = 5; case 2: i = 4;}}");
+			Translator translator(stream);
+
+			bool translated = translator.translate();
+			Assert::IsTrue(translated);
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = std::string("0 (SWITCH, 1, 0:lbl`7` 1:lbl`8` 2:lbl`10` 3:lbl`9`, lbl`5`)\n") +
+				"0 (LBL, , , lbl`7`)\n0 (MOV, '1', , 1)\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`1`)\n" +
+				"0 (LBL, , , lbl`8`)\n0 (MOV, '2', , 1)\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`2`)\n" +
+				"0 (LBL, , , lbl`9`)\n0 (MOV, '3', , 1)\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`3`)\n" +
+				"0 (JMP, , , lbl`4`)\n0 (LBL, , , lbl`5`)\n0 (MOV, '5', , 1)\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`4`)\n" +
+				"0 (LBL, , , lbl`10`)\n0 (MOV, '4', , 1)\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`6`)\n" +
+				"0 (JMP, , , lbl`5`)\n0 (LBL, , , lbl`0`)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Translator__CaseOp_charOutOfRange) {
+			// Char never matches 300, so it is left out of the switch
+			std::istringstream stream("int main(){char c; c = 44; switch(c){case 1: out 1; case 2: out 2; case 3: out 3; case 300: out 300; case 4: out 4;}}");
+			Translator translator(stream);
+
+			bool translated = translator.translate();
+			Assert::IsTrue(translated);
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+
+			std::string excepted = std::string("0 (MOV, '44', , 1)\n0 (SWITCH, 1, 1:lbl`6` 2:lbl`7` 3:lbl`8` 4:lbl`10`, lbl`0`)\n") +
+				"0 (LBL, , , lbl`6`)\n0 (OUT, , , '1')\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`1`)\n" +
+				"0 (LBL, , , lbl`7`)\n0 (OUT, , , '2')\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`2`)\n" +
+				"0 (LBL, , , lbl`8`)\n0 (OUT, , , '3')\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`3`)\n" +
+				"0 (LBL, , , lbl`9`)\n0 (OUT, , , '300')\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`4`)\n" +
+				"0 (LBL, , , lbl`10`)\n0 (OUT, , , '4')\n0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`5`)\n" +
+				"0 (JMP, , , lbl`0`)\n0 (LBL, , , lbl`0`)\n0 (RET, , , '0')";
+
+			Assert::AreEqual(excepted.c_str(), result.str().c_str());
+		}
+
+		TEST_METHOD(Translator__expressionParsers_sameAtoms) {
+			const std::vector<std::string> programs = {
+				"int main(){int a, b, c; c = a + b * c - a / b % c; out c;}",
+				"int main(){int a, b; out !a && b || a == b + 1 && !b;}",
+				"int main(){int a, b; out a <= b * 2 || (a - b) > 3 && a != b;}",
+				"int f(int x, int y){ return x * y; } int main(){int a[5]; a[1] = f(a[0] + 1, 2) * f(3, a[2]); out a[1]++;}",
+				"char g[4]; int main(){char i; for(i = 0; i < 4 && g[i] == 0; ++i){ g[i] = i * 3 + 1; } out ++i - i++;}",
+				// Comparisons can't be chained, both parsers stop at the second one
+				"int main(){int a, b; out a < b < 3;}",
+				"int main(){int a; out a + ;}"
+			};
+
+			auto translate = [](const std::string& program, const Translator::ExpressionParser parser) {
+				std::istringstream stream(program);
+				std::ostringstream errors;
+				Translator translator(stream, errors);
+				translator.setExpressionParser(parser);
+
+				std::ostringstream result;
+				result << translator.translate() << std::endl << errors.str() << std::endl;
+				translator.printAtoms(result, 0);
+				translator.printSymbolTable(result);
+				return result.str();
+			};
+
+			for (auto it = programs.begin(); it != programs.end(); ++it) {
+				Assert::AreEqual(translate(*it, Translator::ExpressionParser::recursiveDescent).c_str(),
+					translate(*it, Translator::ExpressionParser::precedenceClimbing).c_str());
+			}
+		}
+
+		TEST_METHOD(Translator__expressionParser_longChain) {
+			std::string program = "int main(){int a; out a";
+			for (unsigned int i = 0; i < 20000; ++i) {
+				program += i % 2 == 0 ? " + a" : " - 1";
+			}
+			program += ";}";
+
+			std::istringstream stream(program);
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+			Assert::IsTrue(result.str().find("0 (SUB, 20000, '1', 20001)\n0 (OUT, , , 20001)") != std::string::npos);
+		}
+
+		TEST_METHOD(Translator__StmtList_long) {
+			std::string program = "int main(){ int a; ";
+			for (unsigned int i = 0; i < 50000; ++i) {
+				program += "a = a + 1; ";
+			}
+			program += "return a; }";
+
+			std::istringstream stream(program);
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+			Assert::IsTrue(result.str().find("0 (ADD, 1, '1', 50001)\n0 (MOV, 50001, , 1)\n0 (RET, , , 1)") != std::string::npos);
+		}
+
+		TEST_METHOD(Translator__ArgList_long) {
+			std::string params, args;
+			for (unsigned int i = 0; i < 1000; ++i) {
+				params += std::string(i > 0 ? ", " : "") + "int p" + std::to_string(i);
+				args += std::string(i > 0 ? ", " : "") + std::to_string(i);
+			}
+
+			std::istringstream stream("int f(" + params + "){ return p999; } int main(){ int a, b, c; out f(" + args + "); }");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+
+			// Params are pushed from the last one
+			std::ostringstream result;
+			translator.printAtoms(result, 0);
+			Assert::IsTrue(result.str().find("1001 (PARAM, , , '999')\n1001 (PARAM, , , '998')\n") != std::string::npos);
+			Assert::IsTrue(result.str().find("1001 (PARAM, , , '0')\n1001 (CALL, 0, , 1005)\n") != std::string::npos);
+		}
+
+		TEST_METHOD(Translator__sourcePositions) {
+			std::istringstream stream("int g;\nint main(){\n  int a = 1;\n  while (a < 5)\n    a = a * 2;\n  out a; return a;\n}");
+			Translator translator(stream);
+
+			Assert::IsTrue(translator.translate());
+
+			// Declarations keep position of name
+			const SymbolTable& table = translator.symbolTable();
+			Assert::AreEqual(1u, table[0].position.line);
+			Assert::AreEqual(5u, table[0].position.column);
+			Assert::AreEqual(2u, table[1].position.line);
+			Assert::AreEqual(3u, table[2].position.line);
+			Assert::AreEqual(7u, table[2].position.column);
+
+			// Atoms keep position of the innermost statement: condition and jumps of while, assignment, out, return
+			std::vector<std::pair<unsigned int, unsigned int>> expected = { { 4, 3 }, { 4, 3 }, { 4, 3 }, { 4, 3 },
+				{ 4, 3 }, { 4, 3 }, { 5, 5 }, { 5, 5 }, { 4, 3 }, { 4, 3 }, { 6, 3 }, { 6, 10 }, { 2, 1 } };
+			const std::vector<std::unique_ptr<Atom>>& atoms = translator.atoms(1);
+			Assert::AreEqual(expected.size(), atoms.size());
+			for (unsigned int i = 0; i < atoms.size(); ++i) {
+				Assert::AreEqual(expected[i].first, atoms[i]->position().line);
+				Assert::AreEqual(expected[i].second, atoms[i]->position().column);
+			}
+		}
 	};
-}
\ No newline at end of file
+}
@@ -1,4 +1,41 @@
+#include <algorithm>
 #include "Atom.h"
+#include "..\Runtime\Runtime.h"
+
+std::vector<std::shared_ptr<RValue>> Atom::operands() const
+{
+	return std::vector<std::shared_ptr<RValue>>();
+}
+
+void Atom::setOperand(const unsigned int position, const std::shared_ptr<RValue> operand)
+{
+	position; operand; // remove warning
+}
+
+std::shared_ptr<MemoryOperand> Atom::result() const
+{
+	return nullptr;
+}
+
+std::vector<Register> Atom::clobbers() const
+{
+	return std::vector<Register>();
+}
+
+const SourcePosition& Atom::position() const
+{
+	return _position;
+}
+
+void Atom::setPosition(const SourcePosition& position)
+{
+	_position = position;
+}
+
+std::vector<std::string> Atom::routines() const
+{
+	return std::vector<std::string>();
+}
 
 BinaryOpAtom::BinaryOpAtom(const std::string& name, const std::shared_ptr<RValue> left, const std::shared_ptr<RValue> right, const std::shared_ptr<MemoryOperand> result) :
 	_name(name), _left(left), _right(right), _result(result)
@@ -10,12 +47,17 @@ std::string BinaryOpAtom::toString() const
 	return "(" + _name + ", " + ((_left != nullptr) ? _left->toString() : "") + ", " + ((_right != nullptr) ? _right->toString() : "") + ", " + _result->toString() + ")";
 }
 
-void BinaryOpAtom::generate(std::ostream & stream) const
+void BinaryOpAtom::generate(CodeWriter& stream) const
 {
-	stream << "; " << toString() << std::endl;
+	stream << "; " << toString() << '\n';
+
+	if (isWide()) {
+		_generateWide(stream);
+		return;
+	}
 
 	_right->load(stream);
-	stream << "MOV B, A" << std::endl;
+	stream << "MOV B, A\n";
 	_left->load(stream);
 
 	_generateOperation(stream);
@@ -24,6 +66,45 @@ void BinaryOpAtom::generate(std::ostream & stream) const
 
 }
 
+std::vector<std::shared_ptr<RValue>> BinaryOpAtom::operands() const
+{
+	return { _left, _right };
+}
+
+void BinaryOpAtom::setOperand(const unsigned int position, const std::shared_ptr<RValue> operand)
+{
+	if (position == 0) {
+		_left = operand;
+	}
+	else {
+		_right = operand;
+	}
+}
+
+std::shared_ptr<MemoryOperand> BinaryOpAtom::result() const
+{
+	return _result;
+}
+
+std::vector<Register> BinaryOpAtom::clobbers() const
+{
+	if (isWide()) {
+		return { Register::B, Register::C };
+	}
+
+	return { Register::B };
+}
+
+const std::string & BinaryOpAtom::name() const
+{
+	return _name;
+}
+
+bool BinaryOpAtom::isWide() const
+{
+	return _result->isWide();
+}
+
 UnaryOpAtom::UnaryOpAtom(const std::string& name, const std::shared_ptr<RValue> operand, const std::shared_ptr<MemoryOperand> result) :
 	_name(name), _operand(operand), _result(result)
 {
@@ -34,23 +115,73 @@ std::string UnaryOpAtom::toString() const
 	return "(" + _name + ", " + _operand->toString() + ", , " + _result->toString() + ")";
 }
 
-void UnaryOpAtom::generate(std::ostream & stream) const
+void UnaryOpAtom::generate(CodeWriter& stream) const
 {
-	stream << "; " << toString() << std::endl;
-	if (_name == "MOV") {
+	stream << "; " << toString() << '\n';
+	if (_name == "MOV" && _result->isWide()) {
+		_operand->loadWide(stream);
+		_result->saveWide(stream);
+	}
+	else if (_name == "NOT" && _result->isWide()) {
+		_operand->loadWide(stream);
+		stream << "MOV A, L\n";
+		stream << "CMA\n";
+		stream << "MOV L, A\n";
+		stream << "MOV A, H\n";
+		stream << "CMA\n";
+		stream << "MOV H, A\n";
+		_result->saveWide(stream);
+	}
+	else if (_name == "MOV") {
 		_operand->load(stream);
 		_result->save(stream);
 	}
 	else if (_name == "NOT") {
 		_operand->load(stream);
-		stream << "CMA" << std::endl;
+		stream << "CMA\n";
 		_result->save(stream);
 	}
 	else {
-		stream << "ERROR: UNKNOWN " << _name << std::endl;
+		stream << "ERROR: UNKNOWN " << _name << '\n';
 	}
 }
 
+std::vector<std::shared_ptr<RValue>> UnaryOpAtom::operands() const
+{
+	return { _operand };
+}
+
+void UnaryOpAtom::setOperand(const unsigned int position, const std::shared_ptr<RValue> operand)
+{
+	position; // remove warning
+	_operand = operand;
+}
+
+std::shared_ptr<MemoryOperand> UnaryOpAtom::result() const
+{
+	return _result;
+}
+
+std::vector<Register> UnaryOpAtom::clobbers() const
+{
+	// Saving word keeps value in BC
+	if (_result->isWide()) {
+		return { Register::B, Register::C };
+	}
+
+	// Saving array element keeps value in B
+	if (std::dynamic_pointer_cast<ArrayElementOperand>(_result) != nullptr) {
+		return { Register::B };
+	}
+
+	return std::vector<Register>();
+}
+
+const std::string & UnaryOpAtom::name() const
+{
+	return _name;
+}
+
 ConditionalJumpAtom::ConditionalJumpAtom(const std::string& cond, const std::shared_ptr<RValue> left, const std::shared_ptr<RValue> right, const std::shared_ptr<LabelOperand> label) :
 	_condition(cond), _left(left), _right(right), _label(label)
 {
@@ -61,17 +192,117 @@ std::string ConditionalJumpAtom::toString() const
 	return "(" + _condition + ", " + _left->toString() + ", " + _right->toString() + ", " + _label->toString() + ")";
 }
 
-void ConditionalJumpAtom::generate(std::ostream & stream) const
+void ConditionalJumpAtom::generate(CodeWriter& stream) const
 {
-	stream << "; " << toString() << std::endl;
+	stream << "; " << toString() << '\n';
+
+	if (isWide()) {
+		std::shared_ptr<NumberOperand> number = std::dynamic_pointer_cast<NumberOperand>(_right);
+		std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(_right);
+
+		// Comparison with zero only checks bytes of left
+		if (number != nullptr && number->value() == 0 && (_condition == "EQ" || _condition == "NE")) {
+			_left->loadWide(stream);
+			stream << "MOV A, H\n";
+			_generateWideOperation(stream);
+			return;
+		}
+
+		// Words are signed: with inverted sign bits their order is given by carry, and the
+		// difference stays the same. Word held by DE pair is subtracted as is, others are
+		// taken to BC, inverted high byte of DE is taken to B
+		const bool ordered = _condition != "EQ" && _condition != "NE";
+		Register pair = (memory != nullptr && memory->isWide()) ? memory->reg() : Register::none;
+		Register high = pair;
+		if (number != nullptr) {
+			stream << "LXI B, " << (ordered ? (number->value() & 0xFFFF) ^ 0x8000 : number->value()) << '\n';
+			pair = high = Register::B;
+		}
+		else if (pair == Register::none) {
+			_right->loadWide(stream);
+			if (ordered) {
+				stream << "MOV A, H\n";
+				stream << "XRI 128\n";
+				stream << "MOV B, A\n";
+			}
+			else {
+				stream << "MOV B, H\n";
+			}
+			stream << "MOV C, L\n";
+			pair = high = Register::B;
+		}
+		else if (ordered) {
+			stream << "MOV A, " << registerName(pair) << '\n';
+			stream << "XRI 128\n";
+			stream << "MOV B, A\n";
+			high = Register::B;
+		}
+
+		_left->loadWide(stream);
+
+		// XRI clears carry, so sign of left is inverted before subtraction
+		if (ordered) {
+			stream << "MOV A, H\n";
+			stream << "XRI 128\n";
+			stream << "MOV H, A\n";
+		}
+
+		stream << "MOV A, L\n";
+		stream << "SUB " << registerName(lowRegister(pair)) << '\n';
+		stream << "MOV L, A\n";
+		stream << "MOV A, H\n";
+		stream << "SBB " << registerName(high) << '\n';
+
+		_generateWideOperation(stream);
+		return;
+	}
 
 	_right->load(stream);
-	stream << "MOV B, A" << std::endl;
+	stream << "MOV B, A\n";
 	_left->load(stream);
 
-	stream << "CMP B" << std::endl;
+	stream << "CMP B\n";
 
-	_generateOperation(stream);
+	_generateByteOperation(stream);
+}
+
+std::vector<std::shared_ptr<RValue>> ConditionalJumpAtom::operands() const
+{
+	return { _left, _right };
+}
+
+std::vector<Register> ConditionalJumpAtom::clobbers() const
+{
+	if (isWide()) {
+		return { Register::B, Register::C };
+	}
+
+	return { Register::B };
+}
+
+bool ConditionalJumpAtom::isWide() const
+{
+	return _left->isWide() || _right->isWide();
+}
+
+void ConditionalJumpAtom::setOperand(const unsigned int position, const std::shared_ptr<RValue> operand)
+{
+	if (position == 0) {
+		_left = operand;
+	}
+	else {
+		_right = operand;
+	}
+}
+
+const std::shared_ptr<LabelOperand> ConditionalJumpAtom::label() const
+{
+	return _label;
+}
+
+const std::string & ConditionalJumpAtom::condition() const
+{
+	return _condition;
 }
 
 OutAtom::OutAtom(const std::shared_ptr<Operand> value) : _value(value)
@@ -83,20 +314,65 @@ std::string OutAtom::toString() const
 	return "(OUT, , , " + _value->toString() + ")";
 }
 
-void OutAtom::generate(std::ostream & stream) const
+void OutAtom::generate(CodeWriter& stream) const
 {
-	stream << "; " << toString() << std::endl;
+	stream << "; " << toString() << '\n';
 	RValue* value = dynamic_cast<RValue*>(_value.get());
-	if (value != nullptr) {
+	if (value != nullptr && value->isWide()) {
+		value->loadWide(stream);
+		stream << "CALL " << Runtime::PRINT_NUMBER16 << '\n';
+	}
+	else if (value != nullptr) {
 		value->load(stream);
-		stream << "OUT 1" << std::endl;
+		stream << "CALL " << Runtime::PRINT_NUMBER << '\n';
 
 	}
 	else if (typeid(*_value) == typeid(StringOperand)) {
 		StringOperand* str = dynamic_cast<StringOperand*>(_value.get());
-		stream << "LXI A, str" << str->index() << std::endl;
-		stream << "CALL @PRINT" << std::endl;
+		stream << "LXI H, str" << str->index() << '\n';
+		stream << "CALL " << Runtime::PRINT << '\n';
+	}
+}
+
+std::vector<std::shared_ptr<RValue>> OutAtom::operands() const
+{
+	std::shared_ptr<RValue> value = std::dynamic_pointer_cast<RValue>(_value);
+
+	if (value == nullptr) {
+		return std::vector<std::shared_ptr<RValue>>();
+	}
+
+	return { value };
+}
+
+std::vector<Register> OutAtom::clobbers() const
+{
+	RValue* value = dynamic_cast<RValue*>(_value.get());
+	if (value != nullptr && value->isWide()) {
+		return { Register::B, Register::C };
 	}
+
+	return { Register::B };
+}
+
+std::vector<std::string> OutAtom::routines() const
+{
+	if (typeid(*_value) == typeid(StringOperand)) {
+		return { Runtime::PRINT };
+	}
+
+	return { dynamic_cast<RValue*>(_value.get())->isWide() ? Runtime::PRINT_NUMBER16 : Runtime::PRINT_NUMBER };
+}
+
+const std::shared_ptr<Operand> OutAtom::value() const
+{
+	return _value;
+}
+
+void OutAtom::setOperand(const unsigned int position, const std::shared_ptr<RValue> operand)
+{
+	position; // remove warning
+	_value = operand;
 }
 
 InAtom::InAtom(const std::shared_ptr<MemoryOperand> result) : _result(result)
@@ -108,13 +384,18 @@ std::string InAtom::toString() const
 	return "(IN, , , " + _result->toString() + ")";
 }
 
-void InAtom::generate(std::ostream & stream) const
+void InAtom::generate(CodeWriter& stream) const
 {
-	stream << "; " << toString() << std::endl;
-	stream << "IN 0" << std::endl;
+	stream << "; " << toString() << '\n';
+	stream << "IN 0\n";
 	_result->save(stream);
 }
 
+std::shared_ptr<MemoryOperand> InAtom::result() const
+{
+	return _result;
+}
+
 LabelAtom::LabelAtom(const std::shared_ptr<LabelOperand> label) : _label(label)
 {
 }
@@ -124,11 +405,16 @@ std::string LabelAtom::toString() const
 	return "(LBL, , , " + _label->toString() + ")";
 }
 
-void LabelAtom::generate(std::ostream & stream) const
+void LabelAtom::generate(CodeWriter& stream) const
 {
 	stream << "LBL" << _label->id() << ": ";
 }
 
+const std::shared_ptr<LabelOperand> LabelAtom::label() const
+{
+	return _label;
+}
+
 JumpAtom::JumpAtom(const std::shared_ptr<LabelOperand> label) : _label(label)
 {
 }
@@ -138,10 +424,177 @@ std::string JumpAtom::toString() const
 	return "(JMP, , , " + _label->toString() + ")";
 }
 
-void JumpAtom::generate(std::ostream & stream) const
+void JumpAtom::generate(CodeWriter& stream) const
+{
+	stream << "; " << toString() << '\n';
+	stream << "JMP LBL" << _label->id() << '\n';
+}
+
+const std::shared_ptr<LabelOperand> JumpAtom::label() const
+{
+	return _label;
+}
+
+SwitchAtom::SwitchAtom(const std::shared_ptr<RValue> value, const std::vector<std::pair<int, std::shared_ptr<LabelOperand>>>& cases,
+	const std::shared_ptr<LabelOperand> defaultLabel, const std::shared_ptr<LabelOperand> table)
+	: _value(value), _default(defaultLabel), _table(table)
+{
+	// Values are compared as bytes, so cases out of byte range never match. The first case
+	// with given value wins
+	for (auto it = cases.begin(); it != cases.end(); ++it) {
+		bool duplicate = it->first < 0 || it->first > 255;
+		for (auto other = _cases.begin(); other != _cases.end(); ++other) {
+			duplicate = duplicate || other->first == it->first;
+		}
+
+		if (!duplicate) {
+			_cases.push_back(*it);
+		}
+	}
+
+	std::sort(_cases.begin(), _cases.end(), [](const std::pair<int, std::shared_ptr<LabelOperand>>& a,
+		const std::pair<int, std::shared_ptr<LabelOperand>>& b) { return a.first < b.first; });
+}
+
+std::string SwitchAtom::toString() const
+{
+	std::string cases;
+	for (auto it = _cases.begin(); it != _cases.end(); ++it) {
+		cases += (it == _cases.begin() ? "" : " ") + std::to_string(it->first) + ":" + it->second->toString();
+	}
+
+	return "(SWITCH, " + _value->toString() + ", " + cases + ", " + _default->toString() + ")";
+}
+
+void SwitchAtom::generate(CodeWriter& stream) const
+{
+	stream << "; " << toString() << '\n';
+
+	// Cases are bytes, so words with nonzero high byte go to default
+	if (_value->isWide()) {
+		_value->loadWide(stream);
+		stream << "MOV A, H\n";
+		stream << "ORA A\n";
+		stream << "JNZ LBL" << _default->id() << '\n';
+		stream << "MOV A, L\n";
+	}
+	else {
+		_value->load(stream);
+	}
+
+	if (!isTable()) {
+		unsigned int labels = 0;
+		_generateTree(stream, 0, _cases.size(), labels);
+		return;
+	}
+
+	const int min = _cases.front().first;
+	const int range = _cases.back().first - min + 1;
+
+	// Bounds check, values below min wrap around
+	if (min != 0) {
+		stream << "SUI " << min << '\n';
+	}
+	stream << "CPI " << range << '\n';
+	stream << "JNC LBL" << _default->id() << '\n';
+
+	// HL = table + 2 * index
+	stream << "ADD A\n";
+	stream << "LXI H, TBL" << _table->id() << '\n';
+	stream << "ADD L\n";
+	stream << "MOV L, A\n";
+	stream << "MVI A, 0\n";
+	stream << "ADC H\n";
+	stream << "MOV H, A\n";
+
+	stream << "MOV A, M\n";
+	stream << "INX H\n";
+	stream << "MOV H, M\n";
+	stream << "MOV L, A\n";
+	stream << "PCHL\n";
+}
+
+std::vector<std::shared_ptr<RValue>> SwitchAtom::operands() const
+{
+	return { _value };
+}
+
+void SwitchAtom::setOperand(const unsigned int position, const std::shared_ptr<RValue> operand)
+{
+	position; // remove warning
+	_value = operand;
+}
+
+const std::vector<std::pair<int, std::shared_ptr<LabelOperand>>>& SwitchAtom::cases() const
+{
+	return _cases;
+}
+
+const std::shared_ptr<LabelOperand> SwitchAtom::defaultLabel() const
 {
-	stream << "; " << toString() << std::endl;
-	stream << "JMP LBL" << _label->id() << std::endl;
+	return _default;
+}
+
+const std::shared_ptr<LabelOperand> SwitchAtom::table() const
+{
+	return _table;
+}
+
+bool SwitchAtom::isTable() const
+{
+	if (_cases.size() < MIN_CASES) {
+		return false;
+	}
+
+	// Index is doubled in A, so table can't be longer than 128
+	const int range = _cases.back().first - _cases.front().first + 1;
+	return range <= 128 && range <= 3 * (int)_cases.size();
+}
+
+void SwitchAtom::generateTable(CodeWriter& stream) const
+{
+	if (!isTable()) {
+		return;
+	}
+
+	stream << "TBL" << _table->id() << ": DW ";
+
+	auto it = _cases.begin();
+	for (int value = _cases.front().first; value <= _cases.back().first; ++value) {
+		std::shared_ptr<LabelOperand> target = _default;
+		if (it->first == value) {
+			target = it->second;
+			++it;
+		}
+
+		stream << (value == _cases.front().first ? "" : ", ") << "LBL" << target->id();
+	}
+
+	stream << '\n';
+}
+
+void SwitchAtom::_generateTree(CodeWriter& stream, const unsigned int from, const unsigned int to, unsigned int & labels) const
+{
+	// Short ranges are checked one by one
+	if (to - from <= 3) {
+		for (unsigned int i = from; i < to; ++i) {
+			stream << "CPI " << _cases[i].first << '\n';
+			stream << "JZ LBL" << _cases[i].second->id() << '\n';
+		}
+		stream << "JMP LBL" << _default->id() << '\n';
+		return;
+	}
+
+	const unsigned int middle = (from + to) / 2;
+	const std::string less = "SW" + std::to_string(_table->id()) + "_" + std::to_string(labels++);
+
+	stream << "CPI " << _cases[middle].first << '\n';
+	stream << "JZ LBL" << _cases[middle].second->id() << '\n';
+	stream << "JC " << less << '\n';
+	_generateTree(stream, middle + 1, to, labels);
+
+	stream << less << ": ";
+	_generateTree(stream, from, middle, labels);
 }
 
 CallAtom::CallAtom(const std::shared_ptr<MemoryOperand> function, const std::shared_ptr<MemoryOperand> result, const SymbolTable & table, std::deque<std::shared_ptr<RValue>>& paramList)
@@ -151,63 +604,154 @@ CallAtom::CallAtom(const std::shared_ptr<MemoryOperand> function, const std::sha
 
 std::string CallAtom::toString() const
 {
-	return "(CALL, " + _function->toString() + ", , " + _result->toString() + ")";
+	return "(CALL, " + _function->toString() + ", , " + (_result != nullptr ? _result->toString() : "") + ")";
 }
 
-void CallAtom::generate(std::ostream & stream) const
+void CallAtom::generate(CodeWriter& stream) const
 {
 
-	stream << "; " + toString() << std::endl;
+	stream << "; " + toString() << '\n';
 
 	// Push regs
 	_saveRegs(stream);
 
-	// Result
-	stream << "LXI B, 0" << std::endl;
-	stream << "PUSH B" << std::endl;
+	// Result, value of slot doesn't matter
+	stream << "PUSH PSW\n";
+
+	// PARAMS, the last ParamAtom holds the first param
+	std::vector<unsigned int> params = _table.parametersIds(_function->index());
+	unsigned int shift = 2 * (_savedPairs().size() + 1);
+	unsigned int k = 0;
+	for (auto it = _paramList.rbegin(); it != _paramList.rend(); ++it, shift += 2, ++k) {
+		std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(*it);
+		Register reg = (memory != nullptr) ? memory->reg() : Register::none;
+		const bool wide = k < params.size() && _table[params[k]].type == SymbolTable::TableRecord::RecordType::integer;
 
-	// PARAMS
-	for (auto it = _paramList.begin(); it != _paramList.end(); ++it) {
-		(*it)->load(stream);
-		stream << "MOV C, A" << std::endl;
-		stream << "PUSH B" << std::endl;
+		// Only low byte of char param is read, so C and E can be pushed as is. Words are
+		// held by pairs
+		if (reg == Register::C && !wide) {
+			stream << "PUSH B\n";
+		}
+		else if ((reg == Register::E && !wide) || (reg == Register::D && memory->isWide())) {
+			stream << "PUSH D\n";
+		}
+		else if (wide) {
+			(*it)->loadWide(stream, shift);
+			stream << "PUSH H\n";
+		}
+		else {
+			(*it)->load(stream, shift);
+			stream << "MOV L, A\n";
+			stream << "PUSH H\n";
+		}
 	}
 
-	stream << "CALL " << _table[_function->index()].name << std::endl;
+	stream << "CALL " << _table[_function->index()].name << '\n';
 
 	// Pop params
-	for (auto it = _paramList.begin(); it != _paramList.end(); ++it) {
-		stream << "POP B" << std::endl;
+	if (_paramList.size() >= RetAtom::FRAME_ARITHMETIC_WORDS) {
+		stream << "LXI H, " << 2 * (unsigned int)_paramList.size() << '\n';
+		stream << "DAD SP\n";
+		stream << "SPHL\n";
+	}
+	else {
+		for (unsigned int i = 0; i < _paramList.size(); ++i) {
+			stream << "POP H\n";
+		}
 	}
 
-	// Pop result
-	stream << "POP B" << std::endl;
-	stream << "MOV A, C" << std::endl; // @TODO: who is wrong? C or B?
-
-	// Save result
-	_result->save(stream);
+	// Pop result, char function leaves high byte of slot undefined
+	const bool wideResult = _result != nullptr && _result->isWide();
+	stream << "POP H\n";
+	if (wideResult && _table[_function->index()].type != SymbolTable::TableRecord::RecordType::integer) {
+		stream << "MVI H, 0\n";
+	}
+	else if (_result != nullptr && !wideResult) {
+		stream << "MOV A, L\n";
+	}
 
 	// Pop regs
 	_loadRegs(stream);
 
+	// Save result
+	if (wideResult) {
+		_result->saveWide(stream);
+	}
+	else if (_result != nullptr) {
+		_result->save(stream);
+	}
+
 	_paramList.clear();
 }
 
+std::shared_ptr<MemoryOperand> CallAtom::result() const
+{
+	return _result;
+}
 
-void CallAtom::_saveRegs(std::ostream & stream) const
+std::vector<Register> CallAtom::clobbers() const
 {
-	stream << "PUSH PSW" << std::endl;
-	stream << "PUSH B" << std::endl;
-	stream << "PUSH D" << std::endl;
-	stream << "PUSH H" << std::endl;
+	// Registers changed by callee are saved, but word result is saved through BC
+	if (_result != nullptr && _result->isWide()) {
+		return { Register::B, Register::C };
+	}
+
+	return std::vector<Register>();
 }
 
-void CallAtom::_loadRegs(std::ostream & stream) const
+const std::shared_ptr<MemoryOperand> CallAtom::function() const
 {
-	stream << "POP H" << std::endl;
-	stream << "POP D" << std::endl;
-	stream << "POP B" << std::endl;
-	stream << "POP PSW" << std::endl;
+	return _function;
+}
+
+void CallAtom::setSavedRegisters(const std::vector<Register>& registers)
+{
+	_savedRegisters = registers;
+}
+
+const std::vector<Register>& CallAtom::savedRegisters() const
+{
+	return _savedRegisters;
+}
+
+void CallAtom::discardResult()
+{
+	_result = nullptr;
+}
+
+std::vector<Register> CallAtom::_savedPairs() const
+{
+	std::vector<Register> pairs;
+	auto saved = [this](const Register reg) {
+		return std::find(_savedRegisters.begin(), _savedRegisters.end(), reg) != _savedRegisters.end();
+	};
+
+	if (saved(Register::B) || saved(Register::C)) {
+		pairs.push_back(Register::B);
+	}
+	if (saved(Register::D) || saved(Register::E)) {
+		pairs.push_back(Register::D);
+	}
+
+	return pairs;
+}
+
+void CallAtom::_saveRegs(CodeWriter& stream) const
+{
+	std::vector<Register> pairs = _savedPairs();
+
+	for (auto it = pairs.begin(); it != pairs.end(); ++it) {
+		stream << "PUSH " << registerName(*it) << '\n';
+	}
+}
+
+void CallAtom::_loadRegs(CodeWriter& stream) const
+{
+	std::vector<Register> pairs = _savedPairs();
+
+	for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) {
+		stream << "POP " << registerName(*it) << '\n';
+	}
 }
 
 RetAtom::RetAtom(const std::shared_ptr<RValue> value, const Scope scope, const SymbolTable & table)
@@ -220,22 +764,66 @@ std::string RetAtom::toString() const
 	return "(RET, , , " + _value->toString() + ")";
 }
 
-void RetAtom::generate(std::ostream & stream) const
+void RetAtom::generate(CodeWriter& stream) const
 {
-	stream << "; " << toString() << std::endl;
+	stream << "; " << toString() << '\n';
 	unsigned int offset = _table[_scope].offset;
 
-	_value->load(stream);
+	// Registers are not kept after return, so DE holds word
+	std::shared_ptr<NumberOperand> number = std::dynamic_pointer_cast<NumberOperand>(_value);
+	if (_table[_scope].type == SymbolTable::TableRecord::RecordType::integer) {
+		std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(_value);
+		if (number != nullptr) {
+			stream << "LXI D, " << number->value() << '\n';
+		}
+		else if (memory == nullptr || !memory->isWide() || memory->reg() != Register::D) {
+			_value->loadWide(stream);
+			stream << "XCHG\n";
+		}
+		stream << "LXI H, " << offset << '\n';
+		stream << "DAD SP\n";
+		stream << "MOV M, E\n";
+		stream << "INX H\n";
+		stream << "MOV M, D\n";
+	}
+	else {
+		_value->load(stream);
 
-	stream << "LXI H, " << offset << std::endl;
-	stream << "DAD SP" << std::endl;
-	stream << "MOV M, A" << std::endl;
+		stream << "LXI H, " << offset << '\n';
+		stream << "DAD SP\n";
+		stream << "MOV M, A\n";
+	}
 
-	for (unsigned int i = 0; i < _table.getLocalsCount(_scope) + _table.getArraysSize(_scope); ++i) {
-		stream << "POP B" << std::endl;
+	// Release frame
+	const unsigned int words = _table.getLocalsCount(_scope) + _table.getArraysSize(_scope);
+	if (words >= FRAME_ARITHMETIC_WORDS) {
+		stream << "LXI H, " << 2 * words << '\n';
+		stream << "DAD SP\n";
+		stream << "SPHL\n";
+	}
+	else {
+		for (unsigned int i = 0; i < words; ++i) {
+			stream << "POP B\n";
+		}
 	}
 
-	stream << "RET" << std::endl;
+	stream << "RET\n";
+}
+
+std::vector<std::shared_ptr<RValue>> RetAtom::operands() const
+{
+	return { _value };
+}
+
+void RetAtom::setOperand(const unsigned int position, const std::shared_ptr<RValue> operand)
+{
+	position; // remove warning
+	_value = operand;
+}
+
+Scope RetAtom::scope() const
+{
+	return _scope;
 }
 
 ParamAtom::ParamAtom(const std::shared_ptr<RValue> value, std::deque<std::shared_ptr<RValue>>& paramList) : _value(value), _paramList(paramList)
@@ -247,13 +835,24 @@ std::string ParamAtom::toString() const
 	return "(PARAM, , , " + _value->toString() + ")";
 }
 
-void ParamAtom::generate(std::ostream & stream) const
+void ParamAtom::generate(CodeWriter& stream) const
 {
 	stream; // remove warning
 	_paramList.push_back(_value);
 }
 
-void SimpleBinaryOpAtom::_generateOperation(std::ostream & stream) const
+std::vector<std::shared_ptr<RValue>> ParamAtom::operands() const
+{
+	return { _value };
+}
+
+void ParamAtom::setOperand(const unsigned int position, const std::shared_ptr<RValue> operand)
+{
+	position; // remove warning
+	_value = operand;
+}
+
+void SimpleBinaryOpAtom::_generateOperation(CodeWriter& stream) const
 {
 	std::string name;
 
@@ -270,49 +869,245 @@ void SimpleBinaryOpAtom::_generateOperation(std::ostream & stream) const
 		name = "ERROR: UNKNOWN";
 	}
 
-	stream << name << " B" << std::endl;
+	stream << name << " B\n";
+
+}
+
+void SimpleBinaryOpAtom::_generateWide(CodeWriter& stream) const
+{
+	std::vector<std::shared_ptr<RValue>> args = operands();
+	std::shared_ptr<NumberOperand> number = std::dynamic_pointer_cast<NumberOperand>(args[1]);
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(args[1]);
+	// Step by one is done by INX and DCX
+	if ((_name == "ADD" || _name == "SUB") && number != nullptr && (number->value() == 1 || number->value() == -1)) {
+		args[0]->loadWide(stream);
+		stream << (((_name == "ADD") == (number->value() == 1)) ? "INX H" : "DCX H") << '\n';
+		result()->saveWide(stream);
+		return;
+	}
+
+	// Constant is subtracted by adding its negation
+	Register pair = (memory != nullptr && memory->isWide()) ? memory->reg() : Register::none;
+	if (number != nullptr) {
+		stream << "LXI B, " << ((_name == "SUB") ? -number->value() : number->value()) << '\n';
+	}
+	else if (pair == Register::none) {
+		args[1]->loadWide(stream);
+		stream << "MOV B, H\n";
+		stream << "MOV C, L\n";
+	}
+	pair = (pair == Register::none) ? Register::B : pair;
+
+	args[0]->loadWide(stream);
+
+	if (_name == "ADD" || (_name == "SUB" && number != nullptr)) {
+		stream << "DAD " << registerName(pair) << '\n';
+	}
+	else {
+		const std::string low = (_name == "SUB") ? "SUB" : (_name == "AND") ? "ANA" : "ORA";
+		const std::string high = (_name == "SUB") ? "SBB" : low;
+
+		stream << "MOV A, L\n";
+		stream << low << " " << registerName(lowRegister(pair)) << '\n';
+		stream << "MOV L, A\n";
+		stream << "MOV A, H\n";
+		stream << high << " " << registerName(pair) << '\n';
+		stream << "MOV H, A\n";
+	}
+
+	result()->saveWide(stream);
+}
+
+void FnBinaryOpAtom::generate(CodeWriter& stream) const
+{
+	std::shared_ptr<NumberOperand> factor = _constantFactor();
+
+	if (factor == nullptr) {
+		BinaryOpAtom::generate(stream);
+		return;
+	}
+
+	stream << "; " << toString() << '\n';
+
+	std::vector<std::shared_ptr<RValue>> args = operands();
+	std::shared_ptr<RValue> other = (args[1] == factor) ? args[0] : args[1];
+	const bool wide = isWide();
+	const int value = factor->value() & (wide ? 0xFFFF : 0xFF);
+
+	if (value == 0) {
+		stream << (wide ? "LXI H, 0" : "MVI A, 0") << '\n';
+	}
+	else {
+		if (wide) {
+			other->loadWide(stream);
+		}
+		else {
+			other->load(stream);
+		}
+
+		// Shift and add from the highest bit
+		int bit = wide ? 15 : 7;
+		while (((value >> bit) & 1) == 0) {
+			bit--;
+		}
+
+		if ((value & (value - 1)) != 0) {
+			stream << (wide ? "MOV B, H\nMOV C, L" : "MOV B, A") << '\n';
+		}
+
+		for (bit--; bit >= 0; --bit) {
+			stream << (wide ? "DAD H" : "ADD A") << '\n';
+			if ((value >> bit) & 1) {
+				stream << (wide ? "DAD B" : "ADD B") << '\n';
+			}
+		}
+	}
+
+	if (wide) {
+		result()->saveWide(stream);
+	}
+	else {
+		result()->save(stream);
+	}
+}
+
+std::vector<Register> FnBinaryOpAtom::clobbers() const
+{
+	if (isWide() && _constantFactor() == nullptr) {
+		return { Register::B, Register::C, Register::D, Register::E };
+	}
+
+	return BinaryOpAtom::clobbers();
+}
+
+std::vector<std::string> FnBinaryOpAtom::routines() const
+{
+	if (_name == "MUL" && _constantFactor() != nullptr) {
+		return std::vector<std::string>();
+	}
+
+	if (isWide()) {
+		return { (_name == "MUL") ? Runtime::MUL16 : Runtime::DIV16 };
+	}
+
+	return { (_name == "MUL") ? Runtime::MUL : Runtime::DIV };
+}
 
+bool FnBinaryOpAtom::isWide() const
+{
+	if (_name == "MUL") {
+		return BinaryOpAtom::isWide();
+	}
+
+	std::vector<std::shared_ptr<RValue>> args = operands();
+	return args[0]->isWide() || args[1]->isWide();
+}
+
+std::shared_ptr<NumberOperand> FnBinaryOpAtom::_constantFactor() const
+{
+	if (_name != "MUL") {
+		return nullptr;
+	}
+
+	std::vector<std::shared_ptr<RValue>> args = operands();
+	std::shared_ptr<NumberOperand> factor = std::dynamic_pointer_cast<NumberOperand>(args[1]);
+
+	return (factor != nullptr) ? factor : std::dynamic_pointer_cast<NumberOperand>(args[0]);
+}
+
+void FnBinaryOpAtom::_generateOperation(CodeWriter& stream) const
+{
+	if (_name == "MUL") {
+		stream << "CALL " << Runtime::MUL << '\n';
+	}
+	else if (_name == "DIV") {
+		stream << "CALL " << Runtime::DIV << '\n';
+	}
+	else if (_name == "MOD") {
+		stream << "CALL " << Runtime::DIV << '\n';
+		stream << "MOV A, H\n";
+	}
+	else {
+		stream << "ERROR: UNKNOWN " << _name << '\n';
+	}
 }
 
-void FnBinaryOpAtom::_generateOperation(std::ostream & stream) const
+void FnBinaryOpAtom::_generateWide(CodeWriter& stream) const
 {
+	std::vector<std::shared_ptr<RValue>> args = operands();
+
+	args[1]->loadWide(stream);
+	stream << "XCHG\n";
+	args[0]->loadWide(stream);
+
 	if (_name == "MUL") {
-		stream << "MOV C, A" << std::endl;
-		stream << "MOV D, B" << std::endl;
-		stream << "CALL @MUL" << std::endl;
-		stream << "MOV A, C" << std::endl;
+		stream << "CALL " << Runtime::MUL16 << '\n';
+	}
+	else if (_name == "DIV") {
+		stream << "CALL " << Runtime::DIV16 << '\n';
+	}
+	else if (_name == "MOD") {
+		stream << "CALL " << Runtime::DIV16 << '\n';
+		stream << "MOV H, B\n";
+		stream << "MOV L, C\n";
 	}
 	else {
-		stream << "ERROR: UNKNOWN " << _name << std::endl;
+		stream << "ERROR: UNKNOWN " << _name << '\n';
 	}
+
+	// Narrow result of division keeps low byte
+	result()->saveWide(stream);
 }
 
-void SimpleConditionalJumpAtom::_generateOperation(std::ostream & stream) const
+void SimpleConditionalJumpAtom::_generateWideOperation(CodeWriter& stream) const
+{
+	// Difference is zero only if both bytes are, order is given by carry as for bytes
+	if (_condition == "EQ" || _condition == "NE") {
+		stream << "ORA L\n";
+	}
+
+	_generateByteOperation(stream);
+}
+
+void SimpleConditionalJumpAtom::_generateByteOperation(CodeWriter& stream) const
 {
 	if (_condition == "EQ") {
-		stream << "JZ LBL" << _label->id() << std::endl;
+		stream << "JZ LBL" << _label->id() << '\n';
 	}
 	else if (_condition == "NE") {
-		stream << "JNZ LBL" << _label->id() << std::endl;
+		stream << "JNZ LBL" << _label->id() << '\n';
 	}
 	else if (_condition == "GT") {
-		stream << "JP LBL" << _label->id() << std::endl;
+		stream << "JNC LBL" << _label->id() << '\n';
 	}
 	else if (_condition == "LT") {
-		stream << "JM LBL" << _label->id() << std::endl;
+		stream << "JC LBL" << _label->id() << '\n';
 	}
 	else {
 		stream << "ERROR: UNKNOWN " << _condition;
 	}
 }
 
-void ComplexConditinalJumpAtom::_generateOperation(std::ostream & stream) const
+void ComplexConditinalJumpAtom::_generateByteOperation(CodeWriter& stream) const
 {
 	if (_condition == "LE") {
-		stream << "JZ LBL" << _label->id() << std::endl;
-		stream << "JM LBL" << _label->id() << std::endl;
+		stream << "JZ LBL" << _label->id() << '\n';
+		stream << "JC LBL" << _label->id() << '\n';
 	}
 	else {
 		stream << "ERROR: UNKOWN " << _condition;
 	}
 }
+
+void ComplexConditinalJumpAtom::_generateWideOperation(CodeWriter& stream) const
+{
+	// Carry is checked before zero, ORA L clears it
+	if (_condition == "LE") {
+		stream << "JC LBL" << _label->id() << '\n';
+		stream << "ORA L\n";
+		stream << "JZ LBL" << _label->id() << '\n';
+	}
+	else {
+		stream << "ERROR: UNKOWN " << _condition;
+	}
+}
\ No newline at end of file
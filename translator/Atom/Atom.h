@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <deque>
+#include <vector>
 #include <memory>
 #include "..\Operand\Operand.h"
 #include "..\SymbolTable\SymbolTable.h"
@@ -10,7 +11,29 @@
 class Atom {
 public:
 	virtual std::string toString() const = 0;
-	virtual void generate(std::ostream& stream) const = 0;
+	virtual void generate(CodeWriter& stream) const = 0;
+
+	// Operands read by atom, used by optimizer
+	virtual std::vector<std::shared_ptr<RValue>> operands() const;
+
+	// Replaces operand with given position in operands() list
+	virtual void setOperand(const unsigned int position, const std::shared_ptr<RValue> operand);
+
+	// Operand written by atom, nullptr if there's no one
+	virtual std::shared_ptr<MemoryOperand> result() const;
+
+	// Registers changed by generated code besides A, H and L
+	virtual std::vector<Register> clobbers() const;
+
+	// Runtime library routines called by generated code
+	virtual std::vector<std::string> routines() const;
+
+	// Position of statement in source which atom is generated for
+	const SourcePosition& position() const;
+	void setPosition(const SourcePosition& position);
+
+private:
+	SourcePosition _position;
 };
 
 
@@ -21,15 +44,30 @@ public:
 		const std::shared_ptr<RValue> right, const std::shared_ptr<MemoryOperand> result);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	std::vector<std::shared_ptr<RValue>> operands() const;
+	void setOperand(const unsigned int position, const std::shared_ptr<RValue> operand);
+	std::shared_ptr<MemoryOperand> result() const;
+	std::vector<Register> clobbers() const;
+
+	const std::string& name() const;
+
+	// Checks whether operation is computed on words. Low byte of result depends only on
+	// low bytes of operands, so it's enough to check result by default
+	virtual bool isWide() const;
 
 private:
-	const std::shared_ptr<RValue> _left;
-	const std::shared_ptr<RValue> _right;
+	std::shared_ptr<RValue> _left;
+	std::shared_ptr<RValue> _right;
 
 	const std::shared_ptr<MemoryOperand> _result;
 protected:
-	virtual void _generateOperation(std::ostream& stream) const = 0;
+	virtual void _generateOperation(CodeWriter& stream) const = 0;
+
+	// Generates operation on words in HL, result is saved by it
+	virtual void _generateWide(CodeWriter& stream) const = 0;
+
 	// Operation name, e.g. ADD
 	const std::string _name;
 };
@@ -37,13 +75,30 @@ protected:
 class SimpleBinaryOpAtom : public BinaryOpAtom {
 	using BinaryOpAtom::BinaryOpAtom;
 protected:
-	void _generateOperation(std::ostream& stream) const;
+	void _generateOperation(CodeWriter& stream) const;
+
+	// Right operand is taken in BC (or DE holding it), constants are added by DAD
+	void _generateWide(CodeWriter& stream) const;
 };
 
 class FnBinaryOpAtom : public BinaryOpAtom {
 	using BinaryOpAtom::BinaryOpAtom;
+public:
+	// Multiplication by constant is generated inline as shifts and adds
+	void generate(CodeWriter& stream) const;
+	std::vector<Register> clobbers() const;
+	std::vector<std::string> routines() const;
+
+	// Quotient and remainder depend on high bytes of operands
+	bool isWide() const;
 protected:
-	void _generateOperation(std::ostream& stream) const;
+	void _generateOperation(CodeWriter& stream) const;
+
+	// Right operand is passed to routine in DE
+	void _generateWide(CodeWriter& stream) const;
+
+	// Returns constant factor of multiplication, nullptr if there's no one
+	std::shared_ptr<NumberOperand> _constantFactor() const;
 };
 
 
@@ -54,13 +109,20 @@ public:
 		const std::shared_ptr<MemoryOperand> result);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	std::vector<std::shared_ptr<RValue>> operands() const;
+	void setOperand(const unsigned int position, const std::shared_ptr<RValue> operand);
+	std::shared_ptr<MemoryOperand> result() const;
+	std::vector<Register> clobbers() const;
+
+	const std::string& name() const;
 
 private:
 	// Operation name, e.g. NEG
 	const std::string _name;
 
-	const std::shared_ptr<RValue> _operand;
+	std::shared_ptr<RValue> _operand;
 	const std::shared_ptr<MemoryOperand> _result;
 };
 
@@ -72,30 +134,49 @@ public:
 		const std::shared_ptr<RValue> right, const std::shared_ptr<LabelOperand> label);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	std::vector<std::shared_ptr<RValue>> operands() const;
+	void setOperand(const unsigned int position, const std::shared_ptr<RValue> operand);
+
+	std::vector<Register> clobbers() const;
+
+	const std::shared_ptr<LabelOperand> label() const;
+	const std::string& condition() const;
+
+	// Checks whether operands are compared as words
+	bool isWide() const;
 
 private:
-	const std::shared_ptr<RValue> _left;
-	const std::shared_ptr<RValue> _right;
+	std::shared_ptr<RValue> _left;
+	std::shared_ptr<RValue> _right;
 
 protected:
 	// e.g. EQ
 	const std::string _condition;
 	const std::shared_ptr<LabelOperand> _label;
 
-	virtual void _generateOperation(std::ostream& stream) const = 0;
+	// Generates jumps after subtraction of words: A holds high byte of difference
+	// with its flags, L holds low byte. Ordered words are subtracted with inverted
+	// sign bits, so carry gives their signed order
+	virtual void _generateWideOperation(CodeWriter& stream) const = 0;
+
+	// Generates jumps after CMP of bytes. Bytes are unsigned, so their order is given by carry
+	virtual void _generateByteOperation(CodeWriter& stream) const = 0;
 };
 
 class SimpleConditionalJumpAtom : public ConditionalJumpAtom {
 	using ConditionalJumpAtom::ConditionalJumpAtom;
 protected:
-	void _generateOperation(std::ostream& stream) const;
+	void _generateWideOperation(CodeWriter& stream) const;
+	void _generateByteOperation(CodeWriter& stream) const;
 };
 
 class ComplexConditinalJumpAtom : public ConditionalJumpAtom {
 	using ConditionalJumpAtom::ConditionalJumpAtom;
 protected:
-	void _generateOperation(std::ostream& stream) const;
+	void _generateWideOperation(CodeWriter& stream) const;
+	void _generateByteOperation(CodeWriter& stream) const;
 };
 
 
@@ -104,10 +185,17 @@ public:
 	OutAtom(const std::shared_ptr<Operand> value);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	std::vector<std::shared_ptr<RValue>> operands() const;
+	void setOperand(const unsigned int position, const std::shared_ptr<RValue> operand);
+	std::vector<Register> clobbers() const;
+	std::vector<std::string> routines() const;
+
+	const std::shared_ptr<Operand> value() const;
 
 private:
-	const std::shared_ptr<Operand> _value;
+	std::shared_ptr<Operand> _value;
 };
 
 
@@ -116,7 +204,9 @@ public:
 	InAtom(const std::shared_ptr<MemoryOperand> result);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	std::shared_ptr<MemoryOperand> result() const;
 
 private:
 	const std::shared_ptr<MemoryOperand> _result;
@@ -129,7 +219,9 @@ public:
 	LabelAtom(const std::shared_ptr<LabelOperand> label);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	const std::shared_ptr<LabelOperand> label() const;
 
 private:
 	const std::shared_ptr<LabelOperand> _label;
@@ -142,43 +234,108 @@ public:
 	JumpAtom(const std::shared_ptr<LabelOperand> label);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	const std::shared_ptr<LabelOperand> label() const;
 
 private:
 	const std::shared_ptr<LabelOperand> _label;
 };
 
+// Atom for dispatching switch by value. Dense cases use jump table, sparse ones
+// are found by binary search over compares
+class SwitchAtom : public Atom {
+public:
+	// Switches with fewer cases are lowered into chain of compares by translator
+	static const unsigned int MIN_CASES = 4;
+
+	SwitchAtom(const std::shared_ptr<RValue> value, const std::vector<std::pair<int, std::shared_ptr<LabelOperand>>>& cases,
+		const std::shared_ptr<LabelOperand> defaultLabel, const std::shared_ptr<LabelOperand> table);
+	std::string toString() const;
+
+	void generate(CodeWriter& stream) const;
+
+	std::vector<std::shared_ptr<RValue>> operands() const;
+	void setOperand(const unsigned int position, const std::shared_ptr<RValue> operand);
+
+	const std::vector<std::pair<int, std::shared_ptr<LabelOperand>>>& cases() const;
+	const std::shared_ptr<LabelOperand> defaultLabel() const;
+	const std::shared_ptr<LabelOperand> table() const;
+
+	// Checks whether cases are dense enough for jump table
+	bool isTable() const;
+
+	// Generates jump table for globals section, nothing for compare tree
+	void generateTable(CodeWriter& stream) const;
+
+private:
+	std::shared_ptr<RValue> _value;
+	// Cases sorted by value as unsigned bytes
+	std::vector<std::pair<int, std::shared_ptr<LabelOperand>>> _cases;
+	const std::shared_ptr<LabelOperand> _default;
+	// Names jump table and labels of compare tree
+	const std::shared_ptr<LabelOperand> _table;
+
+	// Generates compare tree for cases in [from, to)
+	void _generateTree(CodeWriter& stream, const unsigned int from, const unsigned int to, unsigned int& labels) const;
+};
+
 // Atom for calling function
 class CallAtom : public Atom {
 public:
 	CallAtom(const std::shared_ptr<MemoryOperand> function, const std::shared_ptr<MemoryOperand> result, const SymbolTable & table, std::deque<std::shared_ptr<RValue>>& paramList);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	std::shared_ptr<MemoryOperand> result() const;
+	std::vector<Register> clobbers() const;
+
+	const std::shared_ptr<MemoryOperand> function() const;
+
+	// Sets registers holding variables which are live after call. Nothing is saved by default
+	void setSavedRegisters(const std::vector<Register>& registers);
+	const std::vector<Register>& savedRegisters() const;
+
+	// Returned value is not stored, result() becomes nullptr
+	void discardResult();
 
 private:
 	const std::shared_ptr<MemoryOperand> _function;
-	const std::shared_ptr<MemoryOperand> _result;
+	std::shared_ptr<MemoryOperand> _result;
 	std::deque<std::shared_ptr<RValue>>& _paramList;
 	const SymbolTable& _table;
+	std::vector<Register> _savedRegisters;
 
+	// Register pairs containing saved registers, e.g. B for C
+	std::vector<Register> _savedPairs() const;
 
 	// Generates code for pushing regs to stack
-	void _saveRegs(std::ostream& stream) const;
+	void _saveRegs(CodeWriter& stream) const;
 
-	// Generates code for poping all regs from stack
-	void _loadRegs(std::ostream& stream) const;
+	// Generates code for poping saved regs from stack
+	void _loadRegs(CodeWriter& stream) const;
 };
 
 // Atom for returning value from function
 class RetAtom : public Atom {
 public:
+	// Frames of at least this count of words are released by SP arithmetic, frames with
+	// arrays of such size are zeroed by loop
+	static const unsigned int FRAME_ARITHMETIC_WORDS = 3;
+
 	RetAtom(const std::shared_ptr<RValue> value, const Scope scope, const SymbolTable& table);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	std::vector<std::shared_ptr<RValue>> operands() const;
+	void setOperand(const unsigned int position, const std::shared_ptr<RValue> operand);
+
+	// Function which atom returns from
+	Scope scope() const;
 private:
-	const std::shared_ptr<RValue> _value;
+	std::shared_ptr<RValue> _value;
 	const Scope _scope;
 	const SymbolTable& _table;
 };
@@ -189,9 +346,12 @@ public:
 	ParamAtom(const std::shared_ptr<RValue> value, std::deque<std::shared_ptr<RValue>>& paramList);
 	std::string toString() const;
 
-	void generate(std::ostream& stream) const;
+	void generate(CodeWriter& stream) const;
+
+	std::vector<std::shared_ptr<RValue>> operands() const;
+	void setOperand(const unsigned int position, const std::shared_ptr<RValue> operand);
 
 private:
-	const std::shared_ptr<RValue> _value;
+	std::shared_ptr<RValue> _value;
 	std::deque<std::shared_ptr<RValue>>& _paramList;
 };
\ No newline at end of file
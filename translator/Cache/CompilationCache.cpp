@@ -0,0 +1,269 @@
+#include <algorithm>
+#include "CompilationCache.h"
+
+namespace {
+	// Prefixes of symbols with numbers in generated code, SW labels of compare trees are
+	// named after jump table
+	const std::vector<std::string> PREFIXES = { "LBL", "TBL", "SW", "str", "VAR", "ARR" };
+
+	bool isNameSymbol(const char c)
+	{
+		return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '_' || c == '@';
+	}
+
+	bool isDigit(const char c)
+	{
+		return '0' <= c && c <= '9';
+	}
+
+	// Finds prefix of symbol starting at given position followed by given symbol
+	const std::string* matchPrefix(const std::string& code, const unsigned int position, const char next)
+	{
+		if (position > 0 && isNameSymbol(code[position - 1])) {
+			return nullptr;
+		}
+
+		for (auto it = PREFIXES.begin(); it != PREFIXES.end(); ++it) {
+			const unsigned int end = position + it->size();
+			bool matches = end < code.size() && code.compare(position, it->size(), *it) == 0;
+			if (matches && (next == 0 ? isDigit(code[end]) : code[end] == next)) {
+				return &*it;
+			}
+		}
+
+		return nullptr;
+	}
+}
+
+const CompilationCache::Entry* CompilationCache::find(const uint64_t key)
+{
+	auto entry = _entries.find(key);
+	if (entry == _entries.end()) {
+		++_misses;
+		return nullptr;
+	}
+
+	++_hits;
+	return &entry->second;
+}
+
+bool CompilationCache::contains(const uint64_t key) const
+{
+	return _entries.count(key) > 0;
+}
+
+void CompilationCache::store(const uint64_t key, const std::string& code, const std::string& tables,
+	const std::set<std::string>& routines, const Symbols& symbols)
+{
+	Entry entry;
+	entry.code = relocate(code, symbols);
+	entry.tables = relocate(tables, symbols);
+	entry.routines = routines;
+
+	// Code which refers to unknown symbols can't be reused
+	if ((!code.empty() && entry.code.empty()) || (!tables.empty() && entry.tables.empty())) {
+		return;
+	}
+
+	_entries[key] = entry;
+}
+
+std::string CompilationCache::relocate(const std::string& code, const Symbols& symbols)
+{
+	std::string result;
+	result.reserve(code.size());
+
+	// Placeholders of labels and strings are their positions in lists
+	std::map<int, unsigned int> labels;
+	std::map<int, unsigned int> strings;
+	for (unsigned int k = 0; k < symbols.labels.size(); ++k) {
+		labels.insert({ symbols.labels[k], k });
+	}
+	for (unsigned int k = 0; k < symbols.strings.size(); ++k) {
+		strings.insert({ symbols.strings[k], k });
+	}
+
+	unsigned int i = 0;
+	while (i < code.size()) {
+		// Comment with its line end, so label before it is joined with the next instruction
+		if (code[i] == ';') {
+			while (i < code.size() && code[i] != '\n') {
+				++i;
+			}
+			++i;
+			continue;
+		}
+
+		const std::string* prefix = matchPrefix(code, i, 0);
+		if (prefix == nullptr) {
+			result += code[i++];
+			continue;
+		}
+
+		i += prefix->size();
+		unsigned int end = i;
+		while (end < code.size() && isDigit(code[end])) {
+			++end;
+		}
+		const int number = std::stoi(code.substr(i, end - i));
+		i = end;
+
+		std::string placeholder;
+		if (*prefix == "VAR" || *prefix == "ARR") {
+			auto global = symbols.globals.find(number);
+			if (global == symbols.globals.end()) {
+				return "";
+			}
+			placeholder = global->second;
+		}
+		else {
+			const std::map<int, unsigned int>& positions = (*prefix == "str") ? strings : labels;
+			auto found = positions.find(number);
+			if (found == positions.end()) {
+				return "";
+			}
+			placeholder = std::to_string(found->second);
+		}
+
+		result += *prefix + "{" + placeholder + "}";
+	}
+
+	return result;
+}
+
+bool CompilationCache::resolve(const std::string& relocatable, const Symbols& symbols, std::string& code)
+{
+	std::map<std::string, int> globals;
+	for (auto it = symbols.globals.begin(); it != symbols.globals.end(); ++it) {
+		globals[it->second] = it->first;
+	}
+
+	code.clear();
+	code.reserve(relocatable.size());
+
+	unsigned int i = 0;
+	while (i < relocatable.size()) {
+		const std::string* prefix = matchPrefix(relocatable, i, '{');
+		if (prefix == nullptr) {
+			code += relocatable[i++];
+			continue;
+		}
+
+		i += prefix->size() + 1;
+		const size_t end = relocatable.find('}', i);
+		if (end == std::string::npos) {
+			return false;
+		}
+		const std::string placeholder = relocatable.substr(i, end - i);
+		i = end + 1;
+
+		int number = 0;
+		if (*prefix == "VAR" || *prefix == "ARR") {
+			auto global = globals.find(placeholder);
+			if (global == globals.end()) {
+				return false;
+			}
+			number = global->second;
+		}
+		else {
+			const std::vector<int>& list = (*prefix == "str") ? symbols.strings : symbols.labels;
+			const unsigned int k = std::stoi(placeholder);
+			if (k >= list.size()) {
+				return false;
+			}
+			number = list[k];
+		}
+
+		code += *prefix + std::to_string(number);
+	}
+
+	return true;
+}
+
+uint64_t CompilationCache::hash(const std::string& data, const uint64_t seed)
+{
+	uint64_t result = seed;
+	for (auto it = data.begin(); it != data.end(); ++it) {
+		result ^= (unsigned char)*it;
+		result *= 1099511628211ULL;
+	}
+
+	// Separator, so that concatenations of different parts differ
+	result ^= 0xFF;
+	result *= 1099511628211ULL;
+
+	return result;
+}
+
+void CompilationCache::load(std::istream& stream)
+{
+	std::string header;
+	unsigned int version = 0;
+	unsigned int count = 0;
+	if (!(stream >> header >> version >> count) || header != "MINIC-CACHE" || version != VERSION) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		uint64_t key = 0;
+		unsigned int routines = 0;
+		if (!(stream >> key >> routines)) {
+			return;
+		}
+
+		Entry entry;
+		for (unsigned int k = 0; k < routines; ++k) {
+			std::string routine;
+			stream >> routine;
+			entry.routines.insert(routine);
+		}
+
+		size_t codeSize = 0;
+		size_t tablesSize = 0;
+		if (!(stream >> codeSize >> tablesSize)) {
+			return;
+		}
+		stream.get();
+
+		entry.code.resize(codeSize);
+		entry.tables.resize(tablesSize);
+		stream.read(&entry.code[0], codeSize);
+		stream.read(&entry.tables[0], tablesSize);
+		if (!stream) {
+			return;
+		}
+
+		_entries[key] = entry;
+	}
+}
+
+void CompilationCache::save(std::ostream& stream) const
+{
+	stream << "MINIC-CACHE " << VERSION << " " << _entries.size() << '\n';
+
+	for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+		stream << it->first << " " << it->second.routines.size();
+		for (auto routine = it->second.routines.begin(); routine != it->second.routines.end(); ++routine) {
+			stream << " " << *routine;
+		}
+		stream << '\n';
+
+		stream << it->second.code.size() << " " << it->second.tables.size() << '\n';
+		stream << it->second.code << it->second.tables << '\n';
+	}
+}
+
+unsigned int CompilationCache::size() const
+{
+	return (unsigned int)_entries.size();
+}
+
+unsigned int CompilationCache::hits() const
+{
+	return _hits;
+}
+
+unsigned int CompilationCache::misses() const
+{
+	return _misses;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+// Code of functions from previous translations. Entry is keyed by hash of function lexems and of
+// everything it depends on, so it can be reused while neither is changed. Code is stored in
+// relocatable form: numbers of labels, strings and globals are replaced with placeholders
+// which are resolved against symbols of function in the current translation
+class CompilationCache {
+public:
+	// Changes whenever format of entries or code generation changes
+	static const unsigned int VERSION = 1;
+
+	// Symbols referenced by code of function. Labels (including jump tables) and strings are
+	// listed in order of appearance in atoms, globals are indexed by record
+	struct Symbols {
+		std::vector<int> labels;
+		std::vector<int> strings;
+		std::map<int, std::string> globals;
+	};
+
+	// Compiled function
+	struct Entry {
+		// Relocatable code of function and its jump tables
+		std::string code;
+		std::string tables;
+
+		// Runtime library routines called by code
+		std::set<std::string> routines;
+	};
+
+	// Returns entry with given key or nullptr, counts hits and misses
+	const Entry* find(const uint64_t key);
+
+	// Checks whether entry exists without counting it
+	bool contains(const uint64_t key) const;
+
+	// Stores code of function generated with given symbols
+	void store(const uint64_t key, const std::string& code, const std::string& tables,
+		const std::set<std::string>& routines, const Symbols& symbols);
+
+	// Resolves relocatable code against symbols of function. Returns false if code refers
+	// to symbol which function doesn't have
+	static bool resolve(const std::string& relocatable, const Symbols& symbols, std::string& code);
+
+	// Replaces symbol numbers in code with placeholders, comments of atoms are removed
+	// as they refer to records of symbol table
+	static std::string relocate(const std::string& code, const Symbols& symbols);
+
+	// FNV-1a hash of data continuing given one
+	static uint64_t hash(const std::string& data, const uint64_t seed = HASH_SEED);
+
+	// Reads entries saved by previous run, entries of other version are ignored
+	void load(std::istream& stream);
+	void save(std::ostream& stream) const;
+
+	unsigned int size() const;
+	unsigned int hits() const;
+	unsigned int misses() const;
+
+private:
+	static const uint64_t HASH_SEED = 14695981039346656037ULL;
+
+	std::map<uint64_t, Entry> _entries;
+	unsigned int _hits = 0;
+	unsigned int _misses = 0;
+};
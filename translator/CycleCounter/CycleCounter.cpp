@@ -0,0 +1,72 @@
+#include <map>
+#include <sstream>
+#include <algorithm>
+#include "CycleCounter.h"
+
+unsigned int CycleCounter::cycles(const std::string & line)
+{
+	// Instructions with the same timing for all operands
+	static const std::map<std::string, unsigned int> fixed = {
+		{ "LXI", 10 }, { "LDA", 13 }, { "STA", 13 }, { "LHLD", 16 }, { "SHLD", 16 },
+		{ "LDAX", 7 }, { "STAX", 7 }, { "XCHG", 4 }, { "XTHL", 18 }, { "SPHL", 5 }, { "PCHL", 5 },
+		{ "ADI", 7 }, { "ACI", 7 }, { "SUI", 7 }, { "SBI", 7 }, { "ANI", 7 }, { "XRI", 7 }, { "ORI", 7 }, { "CPI", 7 },
+		{ "INX", 5 }, { "DCX", 5 }, { "DAD", 10 }, { "DAA", 4 },
+		{ "RLC", 4 }, { "RRC", 4 }, { "RAL", 4 }, { "RAR", 4 }, { "CMA", 4 }, { "CMC", 4 }, { "STC", 4 },
+		{ "JMP", 10 }, { "JZ", 10 }, { "JNZ", 10 }, { "JC", 10 }, { "JNC", 10 },
+		{ "JP", 10 }, { "JM", 10 }, { "JPE", 10 }, { "JPO", 10 },
+		{ "CALL", 17 }, { "CZ", 17 }, { "CNZ", 17 }, { "CC", 17 }, { "CNC", 17 },
+		{ "CP", 17 }, { "CM", 17 }, { "CPE", 17 }, { "CPO", 17 },
+		{ "RET", 10 }, { "RZ", 11 }, { "RNZ", 11 }, { "RC", 11 }, { "RNC", 11 },
+		{ "RP", 11 }, { "RM", 11 }, { "RPE", 11 }, { "RPO", 11 }, { "RST", 11 },
+		{ "PUSH", 11 }, { "POP", 10 }, { "IN", 10 }, { "OUT", 10 },
+		{ "EI", 4 }, { "DI", 4 }, { "HLT", 7 }, { "NOP", 4 }
+	};
+	// Register operations, accessing memory through M takes more
+	static const std::map<std::string, std::pair<unsigned int, unsigned int>> byOperand = {
+		{ "ADD", { 4, 7 } }, { "ADC", { 4, 7 } }, { "SUB", { 4, 7 } }, { "SBB", { 4, 7 } },
+		{ "ANA", { 4, 7 } }, { "XRA", { 4, 7 } }, { "ORA", { 4, 7 } }, { "CMP", { 4, 7 } },
+		{ "INR", { 5, 10 } }, { "DCR", { 5, 10 } }, { "MVI", { 7, 10 } }, { "MOV", { 5, 7 } }
+	};
+
+	std::string code = line.substr(0, line.find(';'));
+
+	// Skip label
+	size_t colon = code.find(':');
+	if (colon != std::string::npos && code.find('\'') > colon) {
+		code = code.substr(colon + 1);
+	}
+
+	std::istringstream stream(code);
+	std::string mnemonic, operands;
+	stream >> mnemonic;
+	std::getline(stream, operands);
+	std::transform(mnemonic.begin(), mnemonic.end(), mnemonic.begin(), ::toupper);
+	operands.erase(std::remove(operands.begin(), operands.end(), ' '), operands.end());
+	std::transform(operands.begin(), operands.end(), operands.begin(), ::toupper);
+
+	auto found = fixed.find(mnemonic);
+	if (found != fixed.end()) {
+		return found->second;
+	}
+
+	auto variable = byOperand.find(mnemonic);
+	if (variable != byOperand.end()) {
+		bool memory = operands == "M" || operands.substr(0, 2) == "M," || (operands.size() > 1 && operands.substr(operands.size() - 2) == ",M");
+		return memory ? variable->second.second : variable->second.first;
+	}
+
+	// Directives, e.g. ORG or DB
+	return 0;
+}
+
+unsigned int CycleCounter::count(std::istream & code)
+{
+	unsigned int result = 0;
+	std::string line;
+
+	while (std::getline(code, line)) {
+		result += cycles(line);
+	}
+
+	return result;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+#include <iostream>
+
+// Static timing of generated i8080 code. Every instruction is counted once,
+// conditional calls and returns are counted as taken
+class CycleCounter {
+public:
+	// Returns cycles of instruction in single line of code, 0 for labels, comments and directives
+	static unsigned int cycles(const std::string& line);
+
+	// Sums cycles of all instructions in code
+	static unsigned int count(std::istream& code);
+};
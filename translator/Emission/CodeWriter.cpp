@@ -0,0 +1,69 @@
+#include "CodeWriter.h"
+
+CodeWriter& CodeWriter::operator<<(const char* text)
+{
+	_data += text;
+	return *this;
+}
+
+CodeWriter& CodeWriter::operator<<(const std::string& text)
+{
+	_data += text;
+	return *this;
+}
+
+CodeWriter& CodeWriter::operator<<(const char symbol)
+{
+	_data += symbol;
+	return *this;
+}
+
+CodeWriter& CodeWriter::operator<<(const int value)
+{
+	if (value < 0) {
+		_data += '-';
+		// Negated in unsigned arithmetic, so the minimal int doesn't overflow
+		return *this << (0u - (unsigned int)value);
+	}
+
+	return *this << (unsigned int)value;
+}
+
+CodeWriter& CodeWriter::operator<<(unsigned int value)
+{
+	// Digits are formed from the end
+	char digits[10];
+	char* begin = digits + sizeof(digits);
+	do {
+		*--begin = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+
+	_data.append(begin, digits + sizeof(digits));
+	return *this;
+}
+
+void CodeWriter::reserve(const size_t size)
+{
+	_data.reserve(size);
+}
+
+const std::string& CodeWriter::str() const
+{
+	return _data;
+}
+
+size_t CodeWriter::size() const
+{
+	return _data.size();
+}
+
+void CodeWriter::clear()
+{
+	_data.clear();
+}
+
+void CodeWriter::flush(std::ostream& stream) const
+{
+	stream.write(_data.data(), _data.size());
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <iostream>
+
+// Growable buffer which generated code is written to. Unlike streams it has no locale, sentries
+// or flushes per line, integers are formatted directly into buffer. Code is written to file
+// by a single call of flush
+class CodeWriter {
+public:
+	CodeWriter& operator<<(const char* text);
+	CodeWriter& operator<<(const std::string& text);
+	CodeWriter& operator<<(const char symbol);
+	CodeWriter& operator<<(const int value);
+	CodeWriter& operator<<(const unsigned int value);
+
+	// Reserves memory for code of given size
+	void reserve(const size_t size);
+
+	const std::string& str() const;
+	size_t size() const;
+	void clear();
+
+	// Writes all code to stream at once
+	void flush(std::ostream& stream) const;
+
+private:
+	std::string _data;
+};
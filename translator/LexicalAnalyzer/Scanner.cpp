@@ -1,8 +1,45 @@
 #include "Scanner.h"
+#include <iterator>
 
-LexicalScanner::LexicalScanner(std::istream& stream) : 	_stream(stream) {}
+LexicalScanner::LexicalScanner(std::istream& stream)
+{
+	reset(stream);
+}
+
+LexicalScanner::LexicalScanner(const char* source, const size_t size)
+{
+	reset(source, size);
+}
+
+void LexicalScanner::reset(std::istream& stream)
+{
+	_buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	reset(_buffer.data(), _buffer.size());
+}
+
+void LexicalScanner::reset(const char* source, const size_t size)
+{
+	_source = source;
+	_size = size;
+	_offset = 0;
+	_previousOffset = 0;
+	_eof = false;
+
+	_position = { 1, 1 };
+	_previous = { 1, 1 };
+	_start = { 1, 1 };
+	_state = 0;
+}
 
 LexicalToken LexicalScanner::getNextToken()
+{
+	LexicalToken token = _scanToken();
+	token.setPosition(_start);
+
+	return token;
+}
+
+LexicalToken LexicalScanner::_scanToken()
 {
 	_value = "";
 	_state = 0;
@@ -11,10 +48,12 @@ LexicalToken LexicalScanner::getNextToken()
 	while (true) {
 		char c = 0;
 
-		_stream >> std::noskipws >> c;
+		_read(c);
 		if (_state == 0) {
+			_start = _previous;
+
 			// End of input stream?
-			if (_stream.eof() || c == '\0') {
+			if (_eof || c == '\0') {
 				return LexicalToken(LexemType::eof);
 			}
 
@@ -90,9 +129,9 @@ LexicalToken LexicalScanner::getNextToken()
 		}
 
 		if (_state == 1) {
-			if (_stream.eof() || !isDigit(c)) {
+			if (_eof || !isDigit(c)) {
 				_state = 0;
-				_stream.putback(c);
+				_putback(c);
 				return LexicalToken(stoi(_value));
 			}
 			_value += c;
@@ -100,7 +139,7 @@ LexicalToken LexicalScanner::getNextToken()
 		}
 
 		if (_state == 2) {
-			if (_stream.eof()) {
+			if (_eof) {
 				return LexicalToken(LexemType::error, "Unclosed char constant at the end of file");
 			}
 
@@ -114,7 +153,7 @@ LexicalToken LexicalScanner::getNextToken()
 		}
 
 		if (_state == 3) {
-			if (_stream.eof()) {
+			if (_eof) {
 				return LexicalToken(LexemType::error, "Unclosed char constant at the end of file");
 			}
 
@@ -122,11 +161,20 @@ LexicalToken LexicalScanner::getNextToken()
 				_state = 0;
 				return LexicalToken((char)_value[0]);
 			}
+
+			// Skip the rest of constant, so its closing quote doesn't start a new one
+			while (!_eof && c != '\'' && c != '\n') {
+				_read(c);
+			}
+			if (c == '\n') {
+				_putback(c);
+			}
+
 			return LexicalToken(LexemType::error, "Char constant has more than one symbol");
 		}
 
 		if (_state == 4) {
-			if (_stream.eof()) {
+			if (_eof) {
 				return LexicalToken(LexemType::error, "Unclosed string constant at the end of file");
 			}
 			if (c == '"') {
@@ -138,13 +186,13 @@ LexicalToken LexicalScanner::getNextToken()
 		}
 
 		if (_state == 5) {
-			if (!(_stream.eof()) && (isLetter(c) || isDigit(c))) {
+			if (!(_eof) && (isLetter(c) || isDigit(c))) {
 				_value += c;
 				continue;
 			}
 
-			if (!(_stream.eof())) {
-				_stream.putback(c);
+			if (!(_eof)) {
+				_putback(c);
 			}
 
 			_state = 0;
@@ -157,13 +205,13 @@ LexicalToken LexicalScanner::getNextToken()
 		}
 
 		if (_state == 6) {
-			if (!_stream.eof() && isDigit(c)) {
+			if (!_eof && isDigit(c)) {
 				_value = "-" + _value + c;
 				_state = 1;
 				continue;
 			}
 
-			_stream.putback(c);
+			_putback(c);
 			_state = 0;
 
 			return LexicalToken(LexemType::opminus);
@@ -176,7 +224,7 @@ LexicalToken LexicalScanner::getNextToken()
 				return LexicalToken(LexemType::opne);
 			}
 
-			_stream.putback(c);
+			_putback(c);
 			return LexicalToken(LexemType::opnot);
 		}
 
@@ -187,7 +235,7 @@ LexicalToken LexicalScanner::getNextToken()
 				return LexicalToken(LexemType::ople);
 			}
 
-			_stream.putback(c);
+			_putback(c);
 			return LexicalToken(LexemType::oplt);
 		}
 
@@ -198,7 +246,7 @@ LexicalToken LexicalScanner::getNextToken()
 				return LexicalToken(LexemType::opeq);
 			}
 
-			_stream.putback(c);
+			_putback(c);
 			return LexicalToken(LexemType::opassign);
 		}
 
@@ -209,7 +257,7 @@ LexicalToken LexicalScanner::getNextToken()
 				return LexicalToken(LexemType::opinc);
 			}
 
-			_stream.putback(c);
+			_putback(c);
 			return LexicalToken(LexemType::opplus);
 		}
 
@@ -239,6 +287,40 @@ LexicalToken LexicalScanner::getNextToken()
 	}
 }
 
+SourcePosition LexicalScanner::position() const
+{
+	return _start;
+}
+
+void LexicalScanner::_read(char& c)
+{
+	_previous = _position;
+	_previousOffset = _offset;
+
+	_eof = _offset >= _size;
+	if (_eof) {
+		return;
+	}
+
+	c = _source[_offset++];
+
+	if (c == '\n') {
+		++_position.line;
+		_position.column = 1;
+	}
+	else {
+		++_position.column;
+	}
+}
+
+void LexicalScanner::_putback(char c)
+{
+	c; // remove warning
+	_offset = _previousOffset;
+	_eof = false;
+	_position = _previous;
+}
+
 bool LexicalScanner::isDigit(char c)
 {
 	return '0' <= c && c <= '9';
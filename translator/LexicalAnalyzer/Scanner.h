@@ -9,13 +9,52 @@
 // Class representing lexical scanner
 class LexicalScanner {
 public:
+	// Whole stream is read into buffer of scanner
 	LexicalScanner(std::istream& stream);
 
-	// Gets next token in the stream
+	// Scans source in memory, it must outlive scanner or be replaced by reset
+	LexicalScanner(const char* source, const size_t size);
+
+	// Starts scanning of other source from its beginning, buffer keeps its capacity
+	void reset(std::istream& stream);
+	void reset(const char* source, const size_t size);
+
+	// Source may point to buffer of scanner
+	LexicalScanner(const LexicalScanner&) = delete;
+	LexicalScanner& operator=(const LexicalScanner&) = delete;
+
+	// Gets next token in the stream, token keeps its position
 	LexicalToken getNextToken();
 
+	// Returns position of the first symbol of the last token
+	SourcePosition position() const;
+
 private:
-	std::istream& _stream;
+	// Copy of stream contents, source points to it or to memory given by user
+	std::string _buffer;
+	const char* _source = nullptr;
+	size_t _size = 0;
+
+	// Offset of the next symbol and of the last read one
+	size_t _offset = 0;
+	size_t _previousOffset = 0;
+
+	// Whether the last read symbol was past the end of source
+	bool _eof = false;
+
+	// Position of the next symbol, of the last read one and of the token start
+	SourcePosition _position = { 1, 1 };
+	SourcePosition _previous = { 1, 1 };
+	SourcePosition _start = { 1, 1 };
+
+	// Runs finite automata from the start state till the end of token
+	LexicalToken _scanToken();
+
+	// Reads symbol and moves position past it
+	void _read(char& c);
+
+	// Returns symbol back to the source and restores position
+	void _putback(char c);
 	
 	// Current state of finite automata
 	int _state = 0;
@@ -26,6 +65,8 @@ private:
 		{ ';', LexemType::semicolon },
 		{ ':', LexemType::colon },
 		{ '*', LexemType::opmult },
+		{ '/', LexemType::opdiv },
+		{ '%', LexemType::opmod },
 		{ '>', LexemType::opgt },
 		{ '(', LexemType::lpar },
 		{ ')', LexemType::rpar },
@@ -61,6 +61,16 @@ std::string LexicalToken::str() const
 	return _str;
 }
 
+const SourcePosition& LexicalToken::position() const
+{
+	return _position;
+}
+
+void LexicalToken::setPosition(const SourcePosition& position)
+{
+	_position = position;
+}
+
 LexicalToken::~LexicalToken()
 {
 }
@@ -119,6 +129,12 @@ std::string LexicalToken::lexemName(LexemType _type)
 	case LexemType::opmult:
 		return "opmult";
 		break;
+	case LexemType::opdiv:
+		return "opdiv";
+		break;
+	case LexemType::opmod:
+		return "opmod";
+		break;
 	case LexemType::opinc:
 		return "opinc";
 		break;
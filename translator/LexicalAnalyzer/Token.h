@@ -4,11 +4,17 @@
 
 enum class LexemType {
 	num, chr, str, id, lpar, rpar, lbrace, rbrace, lbracket, rbracket,
-	semicolon, comma, colon, opassign, opplus, opminus, opmult, opinc, opeq, opne, oplt,
+	semicolon, comma, colon, opassign, opplus, opminus, opmult, opdiv, opmod, opinc, opeq, opne, oplt,
 	opgt, ople, opnot, opor, opand, kwint, kwchar, kwif, kwelse, kwswitch, kwcase, kwdefault, kwwhile,
 	kwfor, kwreturn, kwin, kwout, eof, error
 };
 
+// Position in source text, lines and columns start from 1
+struct SourcePosition {
+	unsigned int line = 0;
+	unsigned int column = 0;
+};
+
 // Class represents tokens got during lexical analysis
 class LexicalToken {
 public:
@@ -32,6 +38,10 @@ public:
 	// Returns string value of given lexem
 	std::string str() const;
 
+	// Returns position of the first symbol of lexem in source
+	const SourcePosition& position() const;
+	void setPosition(const SourcePosition& position);
+
 	~LexicalToken();
 
 	static std::string lexemName(LexemType type);
@@ -45,4 +55,6 @@ private:
 
 	// String value of lexem
 	const std::string _str = "";
+
+	SourcePosition _position;
 };
\ No newline at end of file
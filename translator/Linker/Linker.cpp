@@ -0,0 +1,248 @@
+#include "Linker.h"
+#include "..\Cache\CompilationCache.h"
+#include "..\StringTable\StringTable.h"
+#include "..\Runtime\Runtime.h"
+
+namespace {
+	const std::string OBJECT_MAGIC = "MINIC-OBJECT";
+
+	void saveFunctions(BinaryWriter& writer, const std::vector<ModuleObject::Function>& functions)
+	{
+		writer.writeUnsigned(functions.size());
+		for (auto it = functions.begin(); it != functions.end(); ++it) {
+			writer.writeString(it->name);
+			writer.writeUnsigned((unsigned int)it->type);
+			writer.writeUnsigned(it->params.size());
+			for (auto param = it->params.begin(); param != it->params.end(); ++param) {
+				writer.writeUnsigned((unsigned int)*param);
+			}
+		}
+	}
+
+	std::vector<ModuleObject::Function> loadFunctions(BinaryReader& reader)
+	{
+		std::vector<ModuleObject::Function> functions;
+		const uint64_t count = reader.readUnsigned();
+
+		for (uint64_t i = 0; i < count; ++i) {
+			ModuleObject::Function function;
+			function.name = reader.readString();
+			function.type = (SymbolTable::TableRecord::RecordType)reader.readBounded(3, "type");
+			const uint64_t params = reader.readUnsigned();
+			for (uint64_t k = 0; k < params; ++k) {
+				function.params.push_back((SymbolTable::TableRecord::RecordType)reader.readBounded(3, "type"));
+			}
+			functions.push_back(function);
+		}
+
+		return functions;
+	}
+
+	bool sameSignature(const ModuleObject::Function& left, const ModuleObject::Function& right)
+	{
+		return left.type == right.type && left.params == right.params;
+	}
+}
+
+void ModuleObject::save(std::ostream& stream) const
+{
+	BinaryWriter writer;
+	writer.writeString(OBJECT_MAGIC);
+	writer.writeUnsigned(VERSION);
+	writer.writeString(name);
+
+	saveFunctions(writer, exports);
+	saveFunctions(writer, imports);
+
+	writer.writeUnsigned(globals.size());
+	for (auto it = globals.begin(); it != globals.end(); ++it) {
+		writer.writeString(it->name);
+		writer.writeUnsigned((unsigned int)it->kind);
+		writer.writeUnsigned((unsigned int)it->type);
+		writer.writeInt(it->len);
+		writer.writeInt(it->init);
+	}
+
+	writer.writeUnsigned(strings.size());
+	for (auto it = strings.begin(); it != strings.end(); ++it) {
+		writer.writeString(*it);
+	}
+
+	writer.writeUnsigned(labels);
+	writer.writeString(code);
+	writer.writeString(tables);
+
+	writer.writeUnsigned(routines.size());
+	for (auto it = routines.begin(); it != routines.end(); ++it) {
+		writer.writeString(*it);
+	}
+
+	writer.flush(stream);
+}
+
+void ModuleObject::load(std::istream& stream)
+{
+	BinaryReader reader(stream);
+	if (reader.readString() != OBJECT_MAGIC) {
+		throw FormatError("Data is not module object");
+	}
+	const uint64_t version = reader.readUnsigned();
+	if (version != VERSION) {
+		throw FormatError("Unsupported version " + std::to_string(version));
+	}
+
+	ModuleObject object;
+	object.name = reader.readString();
+	object.exports = loadFunctions(reader);
+	object.imports = loadFunctions(reader);
+
+	uint64_t count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		Global global;
+		global.name = reader.readString();
+		global.kind = (SymbolTable::TableRecord::RecordKind)reader.readBounded(4, "record kind");
+		global.type = (SymbolTable::TableRecord::RecordType)reader.readBounded(3, "type");
+		global.len = (int)reader.readInt();
+		global.init = (int)reader.readInt();
+		object.globals.push_back(global);
+	}
+
+	count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		object.strings.push_back(reader.readString());
+	}
+
+	object.labels = (unsigned int)reader.readUnsigned();
+	object.code = reader.readString();
+	object.tables = reader.readString();
+
+	count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		object.routines.insert(reader.readString());
+	}
+
+	if (!reader.atEnd()) {
+		throw FormatError("Excess data after module object");
+	}
+
+	*this = object;
+}
+
+void Linker::add(const ModuleObject& module)
+{
+	_modules[module.name] = module;
+}
+
+void Linker::remove(const std::string& name)
+{
+	_modules.erase(name);
+}
+
+void Linker::link(std::ostream& stream) const
+{
+	_checkFunctions();
+
+	// Globals and strings of all modules are placed by tables, names of globals are
+	// qualified by module, equal strings are shared
+	SymbolTable globals;
+	StringTable strings;
+	std::vector<CompilationCache::Symbols> symbols;
+	std::set<std::string> routines;
+	int labels = 0;
+
+	for (auto module = _modules.begin(); module != _modules.end(); ++module) {
+		const ModuleObject& object = module->second;
+		CompilationCache::Symbols moduleSymbols;
+
+		for (auto it = object.globals.begin(); it != object.globals.end(); ++it) {
+			const std::string name = object.name + "::" + it->name;
+			std::shared_ptr<MemoryOperand> record = (it->kind == SymbolTable::TableRecord::RecordKind::array)
+				? globals.insertArray(name, SymbolTable::GLOBAL_SCOPE, it->type, it->len)
+				: globals.insertVar(name, SymbolTable::GLOBAL_SCOPE, it->type, it->init);
+			if (record == nullptr) {
+				throw LinkError("Global " + it->name + " is defined twice in module " + object.name);
+			}
+			moduleSymbols.globals[record->index()] = it->name;
+		}
+
+		for (auto it = object.strings.begin(); it != object.strings.end(); ++it) {
+			moduleSymbols.strings.push_back(strings.insert(*it)->index());
+		}
+
+		for (unsigned int i = 0; i < object.labels; ++i) {
+			moduleSymbols.labels.push_back(labels++);
+		}
+
+		routines.insert(object.routines.begin(), object.routines.end());
+		symbols.push_back(moduleSymbols);
+	}
+
+	std::vector<std::string> code;
+	std::vector<std::string> tables;
+	size_t size = 0;
+	unsigned int k = 0;
+	for (auto module = _modules.begin(); module != _modules.end(); ++module, ++k) {
+		code.push_back("");
+		tables.push_back("");
+		if (!CompilationCache::resolve(module->second.code, symbols[k], code.back())
+			|| !CompilationCache::resolve(module->second.tables, symbols[k], tables.back())) {
+			throw LinkError("Module " + module->first + " refers to unknown symbol");
+		}
+		size += code.back().size() + tables.back().size();
+	}
+
+	CodeWriter program;
+	program.reserve(size);
+	program << "ORG 8000H\n";
+	globals.generateGlobalsSection(program);
+	strings.generateGlobalsSection(program);
+
+	for (auto it = tables.begin(); it != tables.end(); ++it) {
+		program << *it;
+	}
+
+	Runtime::generateEntry(program, routines);
+
+	for (auto it = code.begin(); it != code.end(); ++it) {
+		program << *it;
+	}
+
+	program.flush(stream);
+}
+
+void Linker::_checkFunctions() const
+{
+	// Defining module of every function
+	std::map<std::string, const ModuleObject*> owners;
+	std::map<std::string, const ModuleObject::Function*> functions;
+
+	for (auto module = _modules.begin(); module != _modules.end(); ++module) {
+		const ModuleObject& object = module->second;
+		for (auto it = object.exports.begin(); it != object.exports.end(); ++it) {
+			if (owners.count(it->name) > 0) {
+				throw LinkError("Function " + it->name + " is defined in modules " + owners[it->name]->name + " and " + object.name);
+			}
+			owners[it->name] = &object;
+			functions[it->name] = &*it;
+		}
+	}
+
+	auto main = functions.find("main");
+	if (main == functions.end() || !main->second->params.empty()) {
+		throw LinkError("No entry point for given program");
+	}
+
+	for (auto module = _modules.begin(); module != _modules.end(); ++module) {
+		const ModuleObject& object = module->second;
+		for (auto it = object.imports.begin(); it != object.imports.end(); ++it) {
+			auto function = functions.find(it->name);
+			if (function == functions.end()) {
+				throw LinkError("Function " + it->name + " called by module " + object.name + " is not defined");
+			}
+			if (!sameSignature(*it, *function->second)) {
+				throw LinkError("Function " + it->name + " is declared by module " + object.name +
+					" differently than defined by module " + owners[it->name]->name);
+			}
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <exception>
+#include <iostream>
+#include "..\SymbolTable\SymbolTable.h"
+
+// Thrown when modules can't be linked into program
+class LinkError : public std::exception {
+public:
+	LinkError(const std::string text) : _text(text) {
+		_message = std::string("Link error: " + _text);
+	};
+
+	virtual const char* what() const throw() {
+		return _message.c_str();
+	}
+
+private:
+	const std::string _text;
+	std::string _message;
+};
+
+// Separately compiled module. Code is relocatable: labels and strings are numbered within
+// module, globals are referred by name, so linker can place them after other modules
+struct ModuleObject {
+	// Changes whenever format of objects or code generation changes
+	static const unsigned int VERSION = 1;
+
+	// Function defined or called by module
+	struct Function {
+		std::string name;
+		SymbolTable::TableRecord::RecordType type;
+		std::vector<SymbolTable::TableRecord::RecordType> params;
+	};
+
+	// Global variable or array of module
+	struct Global {
+		std::string name;
+		SymbolTable::TableRecord::RecordKind kind;
+		SymbolTable::TableRecord::RecordType type;
+		int len;
+		int init;
+	};
+
+	std::string name;
+
+	// Functions defined by module and functions declared, but defined by other modules
+	std::vector<Function> exports;
+	std::vector<Function> imports;
+
+	std::vector<Global> globals;
+	std::vector<std::string> strings;
+
+	// Count of labels used by code
+	unsigned int labels = 0;
+
+	// Relocatable code of functions and their jump tables
+	std::string code;
+	std::string tables;
+
+	// Runtime library routines called by code
+	std::set<std::string> routines;
+
+	// Binary form of object, load throws FormatError if data is truncated or of other version
+	void save(std::ostream& stream) const;
+	void load(std::istream& stream);
+};
+
+// Links modules into program: resolves calls between modules, places globals and strings
+// of all modules and numbers their labels so they don't clash
+class Linker {
+public:
+	// Adds module, module with the same name is replaced, so only changed ones are added again
+	void add(const ModuleObject& module);
+
+	// Removes module with given name
+	void remove(const std::string& name);
+
+	// Generates program, throws LinkError if called function is not defined, function is
+	// defined by several modules or there's no main
+	void link(std::ostream& stream) const;
+
+private:
+	std::map<std::string, ModuleObject> _modules;
+
+	// Checks that imports of modules are exported with the same signature
+	void _checkFunctions() const;
+};
@@ -3,6 +3,29 @@
 #include "..\SymbolTable\SymbolTable.h"
 
 
+std::string registerName(const Register reg)
+{
+	switch (reg) {
+	case Register::B: return "B";
+	case Register::C: return "C";
+	case Register::D: return "D";
+	case Register::E: return "E";
+	case Register::H: return "H";
+	case Register::L: return "L";
+	default: return "";
+	}
+}
+
+Register lowRegister(const Register pair)
+{
+	switch (pair) {
+	case Register::B: return Register::C;
+	case Register::D: return Register::E;
+	case Register::H: return Register::L;
+	default: return Register::none;
+	}
+}
+
 MemoryOperand::MemoryOperand(const int index, const SymbolTable * symbolTable) : _index(index),
 _symbolTable(symbolTable) {}
 
@@ -33,32 +56,121 @@ bool MemoryOperand::operator==(MemoryOperand & other)
 	return _index == other._index && _symbolTable == other._symbolTable;
 }
 
-void MemoryOperand::save(std::ostream & stream) const
+bool MemoryOperand::isWide() const
+{
+	return (*_symbolTable)[_index].type == SymbolTable::TableRecord::RecordType::integer;
+}
+
+Register MemoryOperand::reg() const
 {
-	if ((*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE) {
-		stream << "STA VAR" << _index << std::endl;
+	return (*_symbolTable)[_index].reg;
+}
+
+void MemoryOperand::save(CodeWriter& stream) const
+{
+	const bool wide = isWide();
+
+	if (reg() != Register::none) {
+		stream << "MOV " << registerName(wide ? lowRegister(reg()) : reg()) << ", A\n";
+		if (wide) {
+			stream << "MVI " << registerName(reg()) << ", 0\n";
+		}
+	}
+	else if ((*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE) {
+		if (wide) {
+			stream << "MOV L, A\n";
+			stream << "MVI H, 0\n";
+			stream << "SHLD VAR" << _index << '\n';
+		}
+		else {
+			stream << "STA VAR" << _index << '\n';
+		}
 	}
 	else {
 		unsigned int offset = (*_symbolTable)[_index].offset;
 
-		stream << "LXI H, " << offset << std::endl;
-		stream << "DAD SP" << std::endl;
-		stream << "MOV M, A" << std::endl;
+		stream << "LXI H, " << offset << '\n';
+		stream << "DAD SP\n";
+		stream << "MOV M, A\n";
+		if (wide) {
+			stream << "INX H\n";
+			stream << "MVI M, 0\n";
+		}
 	}
 }
 
-void MemoryOperand::load(std::ostream & stream) const
+void MemoryOperand::saveWide(CodeWriter& stream) const
 {
-	if ((*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE) {
-		stream << "LDA VAR" << _index << std::endl;
+	if (!isWide()) {
+		stream << "MOV A, L\n";
+		save(stream);
+	}
+	else if (reg() != Register::none) {
+		stream << "MOV " << registerName(lowRegister(reg())) << ", L\n";
+		stream << "MOV " << registerName(reg()) << ", H\n";
+	}
+	else if ((*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE) {
+		stream << "SHLD VAR" << _index << '\n';
 	}
 	else {
 		unsigned int offset = (*_symbolTable)[_index].offset;
 
-		stream << "LXI H, " << offset << std::endl;
-		stream << "DAD SP" << std::endl;
+		// HL is needed for address, value is kept in BC
+		stream << "MOV B, H\n";
+		stream << "MOV C, L\n";
+		stream << "LXI H, " << offset << '\n';
+		stream << "DAD SP\n";
+		stream << "MOV M, C\n";
+		stream << "INX H\n";
+		stream << "MOV M, B\n";
+	}
+}
 
-		stream << "MOV A, M" << std::endl;
+void MemoryOperand::load(CodeWriter& stream, const unsigned int stackShift) const
+{
+	if (reg() != Register::none) {
+		stream << "MOV A, " << registerName(isWide() ? lowRegister(reg()) : reg()) << '\n';
+	}
+	else if ((*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE) {
+		stream << "LDA VAR" << _index << '\n';
+	}
+	else {
+		unsigned int offset = (*_symbolTable)[_index].offset + stackShift;
+
+		stream << "LXI H, " << offset << '\n';
+		stream << "DAD SP\n";
+
+		stream << "MOV A, M\n";
+	}
+}
+
+void MemoryOperand::loadWide(CodeWriter& stream, const unsigned int stackShift) const
+{
+	if (!isWide() && reg() != Register::none) {
+		stream << "MOV L, " << registerName(reg()) << '\n';
+		stream << "MVI H, 0\n";
+	}
+	else if (!isWide()) {
+		load(stream, stackShift);
+		stream << "MOV L, A\n";
+		stream << "MVI H, 0\n";
+	}
+	else if (reg() != Register::none) {
+		stream << "MOV L, " << registerName(lowRegister(reg())) << '\n';
+		stream << "MOV H, " << registerName(reg()) << '\n';
+	}
+	else if ((*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE) {
+		stream << "LHLD VAR" << _index << '\n';
+	}
+	else {
+		unsigned int offset = (*_symbolTable)[_index].offset + stackShift;
+
+		stream << "LXI H, " << offset << '\n';
+		stream << "DAD SP\n";
+		stream << "MOV A, M\n";
+		stream << "INX H\n";
+		stream << "MOV H, M\n";
+		stream << "MOV L, A\n";
 	}
 }
 
@@ -77,9 +189,26 @@ std::string NumberOperand::toString(bool expanded) const
 	return str;
 }
 
-void NumberOperand::load(std::ostream & stream) const
+int NumberOperand::value() const
+{
+	return _value;
+}
+
+bool NumberOperand::isWide() const
 {
-	stream << "MVI A, " << std::to_string(_value) << std::endl;
+	return _value < 0 || _value > 255;
+}
+
+void NumberOperand::load(CodeWriter& stream, const unsigned int stackShift) const
+{
+	stackShift; // remove warning
+	stream << "MVI A, " << std::to_string(isWide() ? (_value & 0xFF) : _value) << '\n';
+}
+
+void NumberOperand::loadWide(CodeWriter& stream, const unsigned int stackShift) const
+{
+	stackShift; // remove warning
+	stream << "LXI H, " << std::to_string(_value) << '\n';
 }
 
 std::string StringOperand::toString(bool expanded) const
@@ -138,68 +267,195 @@ const std::shared_ptr<RValue> ArrayElementOperand::elementIndex() const
 	return _elementIndex;
 }
 
-void ArrayElementOperand::save(std::ostream & stream) const
+Register ArrayElementOperand::reg() const
 {
-	stream << "MOV C, A" << std::endl;
-	if ((*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE) {
-		_elementIndex->load(stream);
+	return Register::none;
+}
 
-		stream << "LXI H, ARR" << _index << std::endl;
-		stream << "LXI D, 0" << std::endl;
-		stream << "MOV E, A" << std::endl;
-		stream << "ADD E" << std::endl;
-		stream << "MOV E, A" << std::endl;
+void ArrayElementOperand::save(CodeWriter& stream) const
+{
+	std::string address = _directAddress();
+	if (!address.empty()) {
+		if (isWide()) {
+			stream << "MOV L, A\n";
+			stream << "MVI H, 0\n";
+			stream << "SHLD " << address << '\n';
+		}
+		else {
+			stream << "STA " << address << '\n';
+		}
+		return;
+	}
 
-		stream << "DAD D" << std::endl;
+	if (_constantOffset() >= 0) {
+		_generateAddress(stream);
+		stream << "MOV M, A\n";
 	}
 	else {
-		unsigned int offset = (*_symbolTable)[_index].offset;
+		stream << "MOV B, A\n";
 
-		_elementIndex->load(stream);
+		_loadIndex(stream);
+		_generateAddress(stream);
 
-		stream << "LXI H, " << offset << std::endl;
+		stream << "MOV M, B\n";
+	}
+
+	if (isWide()) {
+		stream << "INX H\n";
+		stream << "MVI M, 0\n";
+	}
+}
 
-		stream << "LXI D, 0" << std::endl;
-		stream << "MOV E, A" << std::endl;
-		stream << "ADD E" << std::endl;
-		stream << "MOV E, A" << std::endl;
+void ArrayElementOperand::saveWide(CodeWriter& stream) const
+{
+	if (!isWide()) {
+		stream << "MOV A, L\n";
+		save(stream);
+		return;
+	}
 
-		stream << "DAD SP" << std::endl;
-		stream << "DAD D" << std::endl;
+	std::string address = _directAddress();
+	if (!address.empty()) {
+		stream << "SHLD " << address << '\n';
+		return;
 	}
 
-	stream << "MOV A, C" << std::endl;
-	stream << "MOV M, A" << std::endl;
+	stream << "MOV B, H\n";
+	stream << "MOV C, L\n";
 
+	_loadIndex(stream);
+	_generateAddress(stream);
+
+	stream << "MOV M, C\n";
+	stream << "INX H\n";
+	stream << "MOV M, B\n";
 }
 
-void ArrayElementOperand::load(std::ostream & stream) const
+void ArrayElementOperand::load(CodeWriter& stream, const unsigned int stackShift) const
 {
-	if ((*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE) {
-		_elementIndex->load(stream);
-		stream << "LXI H, ARR" << _index << std::endl;
-		stream << "LXI D, 0" << std::endl;
-		stream << "MOV E, A" << std::endl;
-		stream << "ADD E" << std::endl;
-		stream << "MOV E, A" << std::endl;
+	std::string address = _directAddress();
+	if (!address.empty()) {
+		stream << "LDA " << address << '\n';
+		return;
+	}
+
+	_loadIndex(stream, stackShift);
+	_generateAddress(stream, stackShift);
 
-		stream << "DAD D" << std::endl;
+	stream << "MOV A, M\n";
+}
+
+void ArrayElementOperand::loadWide(CodeWriter& stream, const unsigned int stackShift) const
+{
+	if (!isWide()) {
+		load(stream, stackShift);
+		stream << "MOV L, A\n";
+		stream << "MVI H, 0\n";
+		return;
+	}
+
+	std::string address = _directAddress();
+	if (!address.empty()) {
+		stream << "LHLD " << address << '\n';
+		return;
+	}
+
+	_loadIndex(stream, stackShift);
+	_generateAddress(stream, stackShift);
+
+	stream << "MOV A, M\n";
+	stream << "INX H\n";
+	stream << "MOV H, M\n";
+	stream << "MOV L, A\n";
+}
+
+int ArrayElementOperand::_constantOffset() const
+{
+	std::shared_ptr<NumberOperand> number = std::dynamic_pointer_cast<NumberOperand>(_elementIndex);
+	if (number == nullptr) {
+		return -1;
+	}
+
+	return number->value() < 0 ? -1 : 2 * number->value();
+}
+
+bool ArrayElementOperand::_isWideIndex() const
+{
+	// Doubled index of element above 127 doesn't fit byte
+	return (*_symbolTable)[_index].len > 128;
+}
+
+void ArrayElementOperand::_loadIndex(CodeWriter& stream, const unsigned int stackShift) const
+{
+	if (_constantOffset() >= 0) {
+		return;
+	}
+
+	if (_isWideIndex()) {
+		_elementIndex->loadWide(stream, stackShift);
 	}
 	else {
-		unsigned int offset = (*_symbolTable)[_index].offset;
+		_elementIndex->load(stream, stackShift);
+	}
+}
 
-		_elementIndex->load(stream);
+void ArrayElementOperand::_generateAddress(CodeWriter& stream, const unsigned int stackShift) const
+{
+	int offset = _constantOffset();
+	bool global = (*_symbolTable)[_index].scope == SymbolTable::GLOBAL_SCOPE;
+
+	if (offset >= 0) {
+		if (global) {
+			stream << "LXI H, " << _directAddress() << '\n';
+		}
+		else {
+			stream << "LXI H, " << (*_symbolTable)[_index].offset + stackShift + offset << '\n';
+			stream << "DAD SP\n";
+		}
+		return;
+	}
 
-		stream << "LXI H, " << offset << std::endl;
+	// HL = 2 * HL + address, DE is saved as it usually holds variable
+	if (_isWideIndex()) {
+		const int address = (*_symbolTable)[_index].offset + stackShift;
+
+		stream << "DAD H\n";
+		if (!global) {
+			stream << "DAD SP\n";
+		}
+		if (global || address != 0) {
+			stream << "PUSH D\n";
+			stream << "LXI D, " << (global ? "ARR" + std::to_string(_index) : std::to_string(address)) << '\n';
+			stream << "DAD D\n";
+			stream << "POP D\n";
+		}
+		return;
+	}
 
-		stream << "LXI D, 0" << std::endl;
-		stream << "MOV E, A" << std::endl;
-		stream << "ADD E" << std::endl;
-		stream << "MOV E, A" << std::endl;
+	if (global) {
+		stream << "LXI H, ARR" << _index << '\n';
+	}
+	else {
+		stream << "LXI H, " << (*_symbolTable)[_index].offset + stackShift << '\n';
+		stream << "DAD SP\n";
+	}
 
-		stream << "DAD SP" << std::endl;
-		stream << "DAD D" << std::endl;
+	// HL += 2 * A, only A is used as scratch. Index of short array is below 128, so
+	// doubled index fits byte
+	stream << "ADD A\n";
+	stream << "ADD L\n";
+	stream << "MOV L, A\n";
+	stream << "MVI A, 0\n";
+	stream << "ADC H\n";
+	stream << "MOV H, A\n";
+}
+
+std::string ArrayElementOperand::_directAddress() const
+{
+	int offset = _constantOffset();
+	if (offset < 0 || (*_symbolTable)[_index].scope != SymbolTable::GLOBAL_SCOPE) {
+		return "";
 	}
 
-	stream << "MOV A, M" << std::endl;
+	return "ARR" + std::to_string(_index) + (offset > 0 ? "+" + std::to_string(offset) : "");
 }
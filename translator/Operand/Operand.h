@@ -1,10 +1,20 @@
 #pragma once
 #include <string>
 #include <memory>
+#include "..\Emission\CodeWriter.h"
 
 class SymbolTable;
 class StringTable;
 
+// i8080 registers which can hold variables
+enum class Register { none, B, C, D, E, H, L };
+
+// Returns name of register used in assembly
+std::string registerName(const Register reg);
+
+// Returns register holding low byte of pair named by its high register, e.g. E for D
+Register lowRegister(const Register pair);
+
 // Base class for all operands
 class Operand {
 	// Represents operand as string
@@ -16,17 +26,28 @@ public:
 class SavebleOperandInterface {
 public:
 	// Generates i8080 code to load given operand to A reg
-	virtual void save(std::ostream& stream) const = 0;
+	virtual void save(CodeWriter& stream) const = 0;
+
+	// Generates i8080 code to save HL pair to given place, clobbers A, B and C
+	virtual void saveWide(CodeWriter& stream) const = 0;
 };
 
 class LoadableOperandInterface {
 public:
-	// Generates i8080 code to load given operand to A reg
-	virtual void load(std::ostream& stream) const = 0;
+	// Generates i8080 code to load given operand to A reg. stackShift is count of bytes
+	// pushed to stack after function frame, e.g. while passing params. Words give low byte
+	virtual void load(CodeWriter& stream, const unsigned int stackShift = 0) const = 0;
+
+	// Generates i8080 code to load given operand to HL pair, bytes are zero extended
+	virtual void loadWide(CodeWriter& stream, const unsigned int stackShift = 0) const = 0;
 };
 
 // Base class for all math operands
-class RValue : public Operand, public LoadableOperandInterface {};
+class RValue : public Operand, public LoadableOperandInterface {
+public:
+	// Checks whether operand takes 16 bit word (int) instead of byte (char)
+	virtual bool isWide() const = 0;
+};
 
 
 // Operands stored in memory
@@ -39,9 +60,16 @@ public:
 
 	bool operator==(MemoryOperand& other);
 
-	// Generates i8080 code to save A reg to given place
-	void save(std::ostream& stream) const;
-	void load(std::ostream& stream) const;
+	bool isWide() const;
+
+	// Register holding variable (high one of pair for words), Register::none if it's in memory
+	virtual Register reg() const;
+
+	// Generates i8080 code to save A reg to given place, words are zero extended
+	void save(CodeWriter& stream) const;
+	void saveWide(CodeWriter& stream) const;
+	void load(CodeWriter& stream, const unsigned int stackShift = 0) const;
+	void loadWide(CodeWriter& stream, const unsigned int stackShift = 0) const;
 protected:
 	const int _index;
 	const SymbolTable* _symbolTable;
@@ -57,12 +85,34 @@ public:
 
 	const std::shared_ptr<RValue> elementIndex() const;
 
+	Register reg() const;
+
 	// Generates i8080 code to save A reg to given place
-	void save(std::ostream& stream) const;
-	void load(std::ostream& stream) const;
+	void save(CodeWriter& stream) const;
+	void saveWide(CodeWriter& stream) const;
+	void load(CodeWriter& stream, const unsigned int stackShift = 0) const;
+	void loadWide(CodeWriter& stream, const unsigned int stackShift = 0) const;
 
 protected:
 	const std::shared_ptr<RValue> _elementIndex;
+
+	// Returns offset of element from array start if index is constant, -1 otherwise
+	int _constantOffset() const;
+
+	// Checks whether array is longer than 128 elements, so its variable index is doubled as word
+	bool _isWideIndex() const;
+
+	// Loads index into A (into HL for long array), constant index is added to address
+	// at compile time
+	void _loadIndex(CodeWriter& stream, const unsigned int stackShift = 0) const;
+
+	// Generates code computing element address into HL, variable index is expected in A
+	// (in HL for long array). Address of element with constant index is computed without A
+	void _generateAddress(CodeWriter& stream, const unsigned int stackShift = 0) const;
+
+	// Returns label expression of global element with constant index, e.g. ARR3+4.
+	// Empty if element address isn't known at compile time
+	std::string _directAddress() const;
 };
 
 
@@ -72,7 +122,14 @@ public:
 	NumberOperand(const int value);
 	std::string toString(bool expanded = false) const;
 
-	void load(std::ostream& stream) const;
+	int value() const;
+
+	// Bytes are unsigned and words are signed, so negative values need word as well as
+	// values above byte range
+	bool isWide() const;
+
+	void load(CodeWriter& stream, const unsigned int stackShift = 0) const;
+	void loadWide(CodeWriter& stream, const unsigned int stackShift = 0) const;
 private:
 	const int _value;
 };
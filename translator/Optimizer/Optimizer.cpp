@@ -0,0 +1,1634 @@
+#include <algorithm>
+#include <cstdlib>
+#include "Optimizer.h"
+
+Optimizer::Optimizer(std::map<Scope, std::vector<std::unique_ptr<Atom>>>& atoms, SymbolTable & symbolTable) :
+	_atoms(atoms), _symbolTable(symbolTable)
+{
+}
+
+void Optimizer::eliminateTailRecursion(const Scope scope, const std::function<std::shared_ptr<LabelOperand>()>& newLabel)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	std::vector<unsigned int> params = _symbolTable.parametersIds(scope);
+	std::shared_ptr<LabelOperand> entry = nullptr;
+
+	// Locals read before write rely on zeroed frame
+	std::set<int> live = _liveOnEntry(scope);
+	for (auto it = live.begin(); it != live.end(); ++it) {
+		if (std::find(params.begin(), params.end(), (unsigned int)*it) == params.end()) {
+			return;
+		}
+	}
+
+	for (unsigned int i = 0; i + 1 < atoms.size(); ++i) {
+		CallAtom* call = dynamic_cast<CallAtom*>(atoms[i].get());
+		RetAtom* ret = dynamic_cast<RetAtom*>(atoms[i + 1].get());
+
+		if (call == nullptr || ret == nullptr || call->function()->index() != scope
+			|| !sameOperand(ret->operands()[0], call->result())) {
+			continue;
+		}
+
+		// Collect args, the last ParamAtom holds the first param
+		std::vector<std::shared_ptr<RValue>> args;
+		unsigned int position = i;
+		for (unsigned int k = i; k-- > 0 && dynamic_cast<CallAtom*>(atoms[k].get()) == nullptr;) {
+			if (dynamic_cast<ParamAtom*>(atoms[k].get()) != nullptr) {
+				args.push_back(atoms[k]->operands()[0]);
+				atoms.erase(atoms.begin() + k);
+				position--;
+			}
+		}
+
+		// Args reading params are copied before params are changed
+		std::vector<std::unique_ptr<Atom>> moves;
+		for (unsigned int k = 0; k < args.size(); ++k) {
+			bool readsParam = false;
+			for (auto it = params.begin(); it != params.end(); ++it) {
+				readsParam = readsParam || refersTo(args[k], *it);
+			}
+
+			if (readsParam && !sameOperand(args[k], std::make_shared<MemoryOperand>(params[k], &_symbolTable))) {
+				std::shared_ptr<MemoryOperand> t = _symbolTable.alloc(scope, _symbolTable[params[k]].type);
+				moves.push_back(std::make_unique<UnaryOpAtom>("MOV", args[k], t));
+				args[k] = t;
+			}
+		}
+		for (unsigned int k = 0; k < args.size(); ++k) {
+			std::shared_ptr<MemoryOperand> param = std::make_shared<MemoryOperand>(params[k], &_symbolTable);
+			if (!sameOperand(args[k], param)) {
+				moves.push_back(std::make_unique<UnaryOpAtom>("MOV", args[k], param));
+			}
+		}
+
+		if (entry == nullptr) {
+			entry = newLabel();
+		}
+		moves.push_back(std::make_unique<JumpAtom>(entry));
+
+		// Replace call and return
+		atoms.erase(atoms.begin() + position, atoms.begin() + position + 2);
+		atoms.insert(atoms.begin() + position, std::make_move_iterator(moves.begin()), std::make_move_iterator(moves.end()));
+		i = position + moves.size() - 1;
+
+		_statistics["tail calls"]++;
+	}
+
+	if (entry != nullptr) {
+		atoms.insert(atoms.begin(), std::make_unique<LabelAtom>(entry));
+	}
+}
+
+void Optimizer::inlineCalls(const Scope scope, const std::function<std::shared_ptr<LabelOperand>()>& newLabel, const unsigned int threshold)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	std::vector<std::unique_ptr<Atom>> out;
+	std::vector<std::shared_ptr<RValue>> args;
+
+	for (unsigned int i = 0; i < atoms.size(); ++i) {
+		CallAtom* call = dynamic_cast<CallAtom*>(atoms[i].get());
+
+		// Params of calls which are kept stay in place
+		if (dynamic_cast<ParamAtom*>(atoms[i].get()) != nullptr) {
+			args.insert(args.begin(), atoms[i]->operands()[0]);
+			out.push_back(std::move(atoms[i]));
+			continue;
+		}
+
+		if (call == nullptr || call->function()->index() == scope || !_isInlinable(call->function()->index(), threshold)) {
+			if (call != nullptr) {
+				args.clear();
+			}
+			out.push_back(std::move(atoms[i]));
+			continue;
+		}
+
+		const Scope callee = call->function()->index();
+		std::map<int, std::shared_ptr<MemoryOperand>> records;
+		std::map<int, std::shared_ptr<LabelOperand>> labels;
+
+		// Drop ParamAtoms of this call and pass values through temporaries
+		for (unsigned int k = out.size(); k-- > 0 && dynamic_cast<CallAtom*>(out[k].get()) == nullptr;) {
+			if (dynamic_cast<ParamAtom*>(out[k].get()) != nullptr) {
+				out.erase(out.begin() + k);
+			}
+		}
+
+		std::vector<unsigned int> params = _symbolTable.parametersIds(callee);
+		for (unsigned int k = 0; k < params.size(); ++k) {
+			records[params[k]] = _symbolTable.alloc(scope, _symbolTable[params[k]].type);
+			out.push_back(std::make_unique<UnaryOpAtom>("MOV", args[k], records[params[k]]));
+		}
+		args.clear();
+
+		std::shared_ptr<LabelOperand> end = newLabel();
+		const std::vector<std::unique_ptr<Atom>>& body = _atoms[callee];
+		bool reachable = true;
+
+		for (unsigned int k = 0; k < body.size(); ++k) {
+			const Atom* atom = body[k].get();
+
+			if (dynamic_cast<const LabelAtom*>(atom) != nullptr) {
+				reachable = true;
+			}
+			if (!reachable) {
+				continue;
+			}
+
+			// Callee locals become caller temporaries
+			std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+			std::vector<int> locals;
+			for (auto it = operands.begin(); it != operands.end(); ++it) {
+				_collectLocals(*it, locals);
+			}
+			_collectLocals(atom->result(), locals);
+			for (auto it = locals.begin(); it != locals.end(); ++it) {
+				if (records.find(*it) == records.end()) {
+					records[*it] = _symbolTable.alloc(scope, _symbolTable[*it].type);
+				}
+			}
+
+			const RetAtom* ret = dynamic_cast<const RetAtom*>(atom);
+			if (ret != nullptr) {
+				// Function returning char passes only low byte of value, as return does
+				std::shared_ptr<RValue> value = _remap(operands[0], records);
+				if (_symbolTable[callee].type == SymbolTable::TableRecord::RecordType::chr) {
+					std::shared_ptr<MemoryOperand> low = _symbolTable.alloc(scope, SymbolTable::TableRecord::RecordType::chr);
+					out.push_back(std::make_unique<UnaryOpAtom>("MOV", value, low));
+					out.back()->setPosition(atom->position());
+					value = low;
+				}
+
+				out.push_back(std::make_unique<UnaryOpAtom>("MOV", value, call->result()));
+				out.back()->setPosition(atom->position());
+				out.push_back(std::make_unique<JumpAtom>(end));
+			}
+			else {
+				// Inlined atoms keep positions in callee
+				out.push_back(_copyAtom(atom, records, labels, newLabel));
+				out.back()->setPosition(atom->position());
+			}
+
+			reachable = dynamic_cast<const RetAtom*>(atom) == nullptr && dynamic_cast<const JumpAtom*>(atom) == nullptr
+				&& dynamic_cast<const SwitchAtom*>(atom) == nullptr;
+		}
+
+		// Jump to the next atom is useless
+		JumpAtom* last = dynamic_cast<JumpAtom*>(out.back().get());
+		if (last != nullptr && last->label() == end) {
+			out.pop_back();
+		}
+
+		out.push_back(std::make_unique<LabelAtom>(end));
+		_statistics["inline: calls"]++;
+	}
+
+	atoms = std::move(out);
+}
+
+void Optimizer::hoistLoopInvariants(const Scope scope)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	bool changed = true;
+
+	// Hoisted atom may make others invariant, so loops and liveness are found again
+	while (changed) {
+		changed = false;
+		std::vector<std::pair<unsigned int, unsigned int>> loops = findLoops(atoms);
+		std::vector<std::set<int>> live = liveVariables(scope);
+
+		for (auto loop = loops.begin(); loop != loops.end() && !changed; ++loop) {
+			for (unsigned int i = loop->first; i <= loop->second && !changed; ++i) {
+				if (!_isLoopInvariant(atoms, *loop, i, live)) {
+					continue;
+				}
+
+				// Preheader falls through into header, so atom is moved to its end
+				const unsigned int preheader = loop->first;
+				std::unique_ptr<Atom> atom = std::move(atoms[i]);
+				atoms.erase(atoms.begin() + i);
+				atoms.insert(atoms.begin() + preheader, std::move(atom));
+
+				_statistics["licm: atoms"]++;
+				changed = true;
+			}
+		}
+	}
+}
+
+void Optimizer::reduceInductionMultiplications(const Scope scope)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	bool changed = true;
+
+	// Positions move after every replacement, so loops are searched again
+	while (changed) {
+		changed = false;
+		std::vector<std::pair<unsigned int, unsigned int>> loops = findLoops(atoms);
+
+		for (auto loop = loops.begin(); loop != loops.end() && !changed; ++loop) {
+			for (unsigned int i = loop->first; i <= loop->second && !changed; ++i) {
+				FnBinaryOpAtom* mul = dynamic_cast<FnBinaryOpAtom*>(atoms[i].get());
+				if (mul == nullptr || mul->name() != "MUL") {
+					continue;
+				}
+
+				std::vector<std::shared_ptr<RValue>> operands = mul->operands();
+				std::shared_ptr<NumberOperand> factor = std::dynamic_pointer_cast<NumberOperand>(operands[1]);
+				std::shared_ptr<RValue> variable = operands[0];
+				if (factor == nullptr) {
+					factor = std::dynamic_pointer_cast<NumberOperand>(operands[0]);
+					variable = operands[1];
+				}
+
+				int step = 0;
+				int update = (factor != nullptr) ? _inductionUpdate(atoms, *loop, variable, step) : -1;
+				if (update < 0) {
+					continue;
+				}
+
+				// Sum is initialized before the loop and follows the variable
+				std::shared_ptr<MemoryOperand> sum = _symbolTable.alloc(scope);
+				std::shared_ptr<NumberOperand> increment = std::make_shared<NumberOperand>(std::abs(step) * factor->value());
+
+				const SourcePosition position = atoms[i]->position();
+				atoms[i] = std::make_unique<UnaryOpAtom>("MOV", sum, mul->result());
+				atoms[i]->setPosition(position);
+				atoms.insert(atoms.begin() + update + 1,
+					std::make_unique<SimpleBinaryOpAtom>(step > 0 ? "ADD" : "SUB", sum, increment, sum));
+				atoms[update + 1]->setPosition(atoms[update]->position());
+				// Preheader falls through into header, so initializer is placed at its end
+				const unsigned int preheader = loop->first;
+				atoms.insert(atoms.begin() + preheader, std::make_unique<FnBinaryOpAtom>("MUL", variable, factor, sum));
+				atoms[preheader]->setPosition(position);
+
+				_statistics["strength reduction: multiplications"]++;
+				changed = true;
+			}
+		}
+	}
+}
+
+void Optimizer::eliminateCommonSubexpressions(const Scope scope)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	std::vector<unsigned int> leaders = findLeaders(atoms);
+	std::vector<std::unique_ptr<Atom>> out;
+	AvailableValues values;
+
+	for (unsigned int i = 0, block = 0; i < atoms.size(); ++i) {
+		// New basic block, forget everything
+		if (block < leaders.size() && leaders[block] == i) {
+			values = AvailableValues();
+			++block;
+		}
+
+		std::unique_ptr<Atom> atom = std::move(atoms[i]);
+
+		// Reuse array elements loaded before
+		std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+		for (unsigned int k = 0; k < operands.size(); ++k) {
+			std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operands[k]);
+
+			if (element == nullptr) {
+				continue;
+			}
+
+			auto load = values.loads.begin();
+			for (; load != values.loads.end(); ++load) {
+				if (_equivalent(load->element, element, values)) {
+					break;
+				}
+			}
+
+			if (load == values.loads.end()) {
+				values.loads.push_back({ element, nullptr, (unsigned int)out.size() });
+				continue;
+			}
+
+			if (load->holder == nullptr) {
+				// Second read: move first load to a temporary
+				std::shared_ptr<MemoryOperand> t = _symbolTable.alloc(scope, _symbolTable[load->element->index()].type);
+				unsigned int position = load->position;
+
+				out.insert(out.begin() + position, std::make_unique<UnaryOpAtom>("MOV", load->element, t));
+				for (auto it = values.loads.begin(); it != values.loads.end(); ++it) {
+					if (it->holder == nullptr && it->position >= position) {
+						it->position++;
+					}
+				}
+
+				Atom* reader = (position + 1 < out.size()) ? out[position + 1].get() : atom.get();
+				std::vector<std::shared_ptr<RValue>> readerOperands = reader->operands();
+				for (unsigned int j = 0; j < readerOperands.size(); ++j) {
+					if (reader != atom.get() || j < k) {
+						if (_equivalent(readerOperands[j], load->element, values)) {
+							reader->setOperand(j, t);
+						}
+					}
+				}
+
+				for (auto it = values.expressions.begin(); it != values.expressions.end(); ++it) {
+					if (_equivalent(it->left, load->element, values)) {
+						it->left = t;
+					}
+					if (it->right != nullptr && _equivalent(it->right, load->element, values)) {
+						it->right = t;
+					}
+				}
+
+				load->holder = t;
+			}
+
+			atom->setOperand(k, load->holder);
+			_statistics["cse: array loads"]++;
+		}
+
+		// Replace recomputed expression with copy of the first result
+		BinaryOpAtom* binary = dynamic_cast<BinaryOpAtom*>(atom.get());
+		UnaryOpAtom* unary = dynamic_cast<UnaryOpAtom*>(atom.get());
+		bool isExpression = binary != nullptr || (unary != nullptr && unary->name() != "MOV");
+		bool replaced = false;
+
+		if (isExpression) {
+			const std::string name = (binary != nullptr) ? binary->name() : unary->name();
+			operands = atom->operands();
+			std::shared_ptr<RValue> left = operands[0];
+			std::shared_ptr<RValue> right = (operands.size() > 1) ? operands[1] : nullptr;
+			bool commutative = name == "ADD" || name == "AND" || name == "OR" || name == "MUL";
+
+			for (auto it = values.expressions.begin(); it != values.expressions.end(); ++it) {
+				if (it->name != name) {
+					continue;
+				}
+
+				bool same = _equivalent(it->left, left, values) && (right == nullptr || _equivalent(it->right, right, values));
+				bool swapped = commutative && _equivalent(it->left, right, values) && _equivalent(it->right, left, values);
+
+				// Char holder keeps only low byte of value
+				if ((same || swapped) && !_truncates(atom->result(), it->holder)) {
+					if (!sameOperand(it->holder, atom->result())) {
+						const SourcePosition position = atom->position();
+						atom = std::make_unique<UnaryOpAtom>("MOV", it->holder, atom->result());
+						atom->setPosition(position);
+						_statistics["cse: expressions"]++;
+					}
+					replaced = true;
+					break;
+				}
+			}
+		}
+
+		// Invalidate values changed by atom
+		if (dynamic_cast<CallAtom*>(atom.get()) != nullptr) {
+			_killGlobals(values);
+		}
+
+		std::shared_ptr<MemoryOperand> result = atom->result();
+		if (result != nullptr) {
+			_kill(result, values);
+		}
+
+		// Remember values computed by atom
+		operands = atom->operands();
+		bool isArrayResult = std::dynamic_pointer_cast<ArrayElementOperand>(result) != nullptr;
+		bool selfReferring = false;
+		for (auto it = operands.begin(); it != operands.end(); ++it) {
+			selfReferring = selfReferring || (result != nullptr && refersTo(*it, result->index()));
+		}
+
+		if (isExpression && !replaced && !isArrayResult && !selfReferring) {
+			values.expressions.push_back({ binary != nullptr ? binary->name() : unary->name(),
+				operands[0], operands.size() > 1 ? operands[1] : nullptr, result });
+		}
+
+		unary = dynamic_cast<UnaryOpAtom*>(atom.get());
+		if (unary != nullptr && unary->name() == "MOV" && !selfReferring) {
+			std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operands[0]);
+			bool stable = std::dynamic_pointer_cast<ArrayElementOperand>(operands[0]) == nullptr;
+
+			if (element != nullptr && !isArrayResult) {
+				// Loaded element is kept in result
+				for (auto it = values.loads.begin(); it != values.loads.end(); ++it) {
+					if (_equivalent(it->element, element, values) && !_truncates(element, result)) {
+						it->holder = result;
+					}
+				}
+			}
+			else if (isArrayResult && stable && !refersTo(operands[0], result->index()) && !_truncates(operands[0], result)) {
+				// Stored value can be read back without memory access
+				values.loads.push_back({ std::dynamic_pointer_cast<ArrayElementOperand>(result), operands[0], 0 });
+			}
+			else if (!isArrayResult && stable && !_truncates(operands[0], result)) {
+				values.copies[result->index()] = _canonical(operands[0], values);
+			}
+		}
+
+		out.push_back(std::move(atom));
+	}
+
+	atoms = std::move(out);
+}
+
+void Optimizer::propagateCopies(const Scope scope)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	std::vector<unsigned int> leaders = findLeaders(atoms);
+	std::map<int, std::shared_ptr<RValue>> copies;
+
+	for (unsigned int i = 0, block = 0; i < atoms.size(); ++i) {
+		if (block < leaders.size() && leaders[block] == i) {
+			copies.clear();
+			++block;
+		}
+
+		Atom* atom = atoms[i].get();
+
+		// Params are read by call, source may change before it
+		std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+		for (unsigned int k = 0; k < operands.size() && dynamic_cast<ParamAtom*>(atom) == nullptr; ++k) {
+			std::shared_ptr<RValue> source = _propagate(operands[k], copies);
+
+			if (source != operands[k]) {
+				atom->setOperand(k, source);
+				operands[k] = source;
+				_statistics["copies: propagated"]++;
+			}
+		}
+
+		// Forget copies of changed variable and copies from it
+		std::shared_ptr<MemoryOperand> result = atom->result();
+		if (result != nullptr && std::dynamic_pointer_cast<ArrayElementOperand>(result) == nullptr) {
+			copies.erase(result->index());
+
+			for (auto it = copies.begin(); it != copies.end();) {
+				it = refersTo(it->second, result->index()) ? copies.erase(it) : std::next(it);
+			}
+		}
+
+		// Called function may change globals
+		if (dynamic_cast<CallAtom*>(atom) != nullptr) {
+			for (auto it = copies.begin(); it != copies.end();) {
+				it = (_symbolTable[it->first].scope == SymbolTable::GLOBAL_SCOPE) ? copies.erase(it) : std::next(it);
+			}
+		}
+
+		// Only locals and numbers are copied, reading globals instead of register costs more
+		UnaryOpAtom* move = dynamic_cast<UnaryOpAtom*>(atom);
+		std::vector<int> source;
+		if (move != nullptr && move->name() == "MOV" && result != nullptr && !operands.empty()
+			&& std::dynamic_pointer_cast<ArrayElementOperand>(result) == nullptr
+			&& std::dynamic_pointer_cast<ArrayElementOperand>(operands[0]) == nullptr) {
+			_collectLocals(operands[0], source);
+
+			bool isNumber = std::dynamic_pointer_cast<NumberOperand>(operands[0]) != nullptr;
+			if ((isNumber || !source.empty()) && !sameOperand(operands[0], result) && !_truncates(operands[0], result)) {
+				copies[result->index()] = operands[0];
+			}
+		}
+	}
+
+	_coalesceMoves(scope);
+}
+
+void Optimizer::eliminateDeadCode(const Scope scope)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	bool changed = true;
+
+	// Removed atom may be the only reader of others
+	while (changed) {
+		changed = false;
+		std::vector<std::set<int>> live = liveVariables(scope);
+
+		for (unsigned int i = atoms.size(); i-- > 0;) {
+			std::shared_ptr<MemoryOperand> result = atoms[i]->result();
+			std::vector<int> written;
+			if (std::dynamic_pointer_cast<ArrayElementOperand>(result) == nullptr) {
+				_collectLocals(result, written);
+			}
+
+			if (written.empty() || live[i].count(written[0]) > 0) {
+				continue;
+			}
+
+			CallAtom* call = dynamic_cast<CallAtom*>(atoms[i].get());
+			if (call != nullptr) {
+				call->discardResult();
+				_statistics["dead code: call results"]++;
+			}
+			else if (dynamic_cast<BinaryOpAtom*>(atoms[i].get()) != nullptr || dynamic_cast<UnaryOpAtom*>(atoms[i].get()) != nullptr) {
+				atoms.erase(atoms.begin() + i);
+				_statistics["dead code: atoms"]++;
+				changed = true;
+			}
+		}
+	}
+}
+
+void Optimizer::inferTypes(const Scope scope)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	const std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+
+	// Only temporaries get their type from code, declared variables keep theirs
+	std::set<int> candidates;
+	for (auto it = atoms.begin(); it != atoms.end(); ++it) {
+		std::shared_ptr<MemoryOperand> result = (*it)->result();
+		if (result == nullptr || std::dynamic_pointer_cast<ArrayElementOperand>(result) != nullptr) {
+			continue;
+		}
+
+		const SymbolTable::TableRecord& record = _symbolTable[result->index()];
+		if (record.name.compare(0, 4, "[tmp") == 0 && record.type == SymbolTable::TableRecord::RecordType::integer) {
+			candidates.insert(result->index());
+		}
+	}
+
+	// Temporaries which never hold value out of byte range
+	std::set<int> fitting = candidates;
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (auto it = atoms.begin(); it != atoms.end(); ++it) {
+			std::shared_ptr<MemoryOperand> result = (*it)->result();
+			if (result == nullptr || std::dynamic_pointer_cast<ArrayElementOperand>(result) != nullptr
+				|| fitting.count(result->index()) == 0) {
+				continue;
+			}
+
+			if (!_producesByte(it->get(), fitting)) {
+				fitting.erase(result->index());
+				changed = true;
+			}
+		}
+	}
+
+	// Temporaries whose high byte is never read, e.g. sums of chars stored into char
+	std::set<int> narrow = candidates;
+	changed = true;
+	while (changed) {
+		changed = false;
+		for (auto index = narrow.begin(); index != narrow.end();) {
+			bool lowByte = true;
+			if (fitting.count(*index) == 0) {
+				for (auto it = atoms.begin(); it != atoms.end() && lowByte; ++it) {
+					lowByte = _readsLowByte(it->get(), *index, narrow);
+				}
+			}
+
+			if (lowByte) {
+				++index;
+			}
+			else {
+				index = narrow.erase(index);
+				changed = true;
+			}
+		}
+	}
+
+	for (auto it = narrow.begin(); it != narrow.end(); ++it) {
+		_symbolTable.setType(*it, SymbolTable::TableRecord::RecordType::chr);
+		_statistics["types: narrowed temporaries"]++;
+	}
+}
+
+void Optimizer::allocateRegisters(const Scope scope)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	const std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	std::vector<Register> pool = { Register::C, Register::D, Register::E };
+
+	for (auto it = atoms.begin(); it != atoms.end(); ++it) {
+		std::vector<Register> clobbers = (*it)->clobbers();
+		for (auto reg = clobbers.begin(); reg != clobbers.end(); ++reg) {
+			pool.erase(std::remove(pool.begin(), pool.end(), *reg), pool.end());
+		}
+	}
+
+	if (pool.empty()) {
+		return;
+	}
+
+	std::vector<std::set<int>> live = liveVariables(scope);
+	std::vector<unsigned int> depths = loopDepths(atoms);
+	std::vector<unsigned int> params = _symbolTable.parametersIds(scope);
+	std::set<int> excluded;
+	std::map<int, unsigned int> weights;
+	std::map<int, std::set<int>> interference;
+
+	// Variables read before any write rely on zeroed frame slots
+	std::set<int> entry = _liveOnEntry(scope);
+	for (auto it = entry.begin(); it != entry.end(); ++it) {
+		if (std::find(params.begin(), params.end(), (unsigned int)*it) == params.end()) {
+			excluded.insert(*it);
+		}
+	}
+
+	// Params are loaded on entry, so they interfere with each other
+	std::set<int> loaded(entry.begin(), entry.end());
+	loaded.insert(params.begin(), params.end());
+	for (auto a = loaded.begin(); a != loaded.end(); ++a) {
+		for (auto b = loaded.begin(); b != loaded.end(); ++b) {
+			if (*a != *b) {
+				interference[*a].insert(*b);
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < atoms.size(); ++i) {
+		// Every use inside loop is ten times more valuable
+		unsigned int weight = 1;
+		for (unsigned int d = 0; d < depths[i] && d < 4; ++d) {
+			weight *= 10;
+		}
+
+		std::vector<int> locals;
+		std::vector<std::shared_ptr<RValue>> operands = atoms[i]->operands();
+		for (auto it = operands.begin(); it != operands.end(); ++it) {
+			_collectLocals(*it, locals);
+		}
+		_collectLocals(atoms[i]->result(), locals);
+		for (auto it = locals.begin(); it != locals.end(); ++it) {
+			weights[*it] += weight;
+		}
+
+		std::set<int> uses, defs;
+		_usesAndDefs(atoms, i, uses, defs);
+		for (auto d = defs.begin(); d != defs.end(); ++d) {
+			for (auto v = live[i].begin(); v != live[i].end(); ++v) {
+				if (*d != *v) {
+					interference[*d].insert(*v);
+					interference[*v].insert(*d);
+				}
+			}
+		}
+	}
+
+	std::vector<std::pair<unsigned int, int>> candidates;
+	for (auto it = weights.begin(); it != weights.end(); ++it) {
+		if (excluded.find(it->first) == excluded.end()) {
+			candidates.push_back({ it->second, -it->first });
+		}
+	}
+	std::sort(candidates.rbegin(), candidates.rend());
+
+	// Words take DE pair named by D, chars take single registers
+	auto isWide = [this](const int index) {
+		return _symbolTable[index].type == SymbolTable::TableRecord::RecordType::integer;
+	};
+	auto taken = [&isWide](const int index, const Register reg) {
+		return isWide(index) ? std::vector<Register>{ reg, lowRegister(reg) } : std::vector<Register>{ reg };
+	};
+	const bool hasPair = std::find(pool.begin(), pool.end(), Register::D) != pool.end()
+		&& std::find(pool.begin(), pool.end(), Register::E) != pool.end();
+
+	std::map<int, Register> assigned;
+	for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+		const int index = -it->second;
+		std::vector<Register> regs = pool;
+		if (isWide(index)) {
+			regs = hasPair ? std::vector<Register>{ Register::D } : std::vector<Register>();
+		}
+
+		for (auto reg = regs.begin(); reg != regs.end(); ++reg) {
+			std::vector<Register> needed = taken(index, *reg);
+			bool isFree = true;
+			for (auto other = interference[index].begin(); other != interference[index].end(); ++other) {
+				auto found = assigned.find(*other);
+				if (found == assigned.end()) {
+					continue;
+				}
+
+				std::vector<Register> used = taken(found->first, found->second);
+				for (auto r = needed.begin(); r != needed.end(); ++r) {
+					isFree = isFree && std::find(used.begin(), used.end(), *r) == used.end();
+				}
+			}
+
+			if (isFree) {
+				assigned[index] = *reg;
+				_symbolTable.setRegister(index, *reg);
+				_statistics["registers: variables"]++;
+				break;
+			}
+		}
+	}
+
+	// Callee may change any register, so calls save registers of variables live after them
+	for (unsigned int i = 0; i < atoms.size(); ++i) {
+		CallAtom* call = dynamic_cast<CallAtom*>(atoms[i].get());
+
+		if (call == nullptr) {
+			continue;
+		}
+
+		std::vector<Register> saved;
+		for (auto it = live[i].begin(); it != live[i].end(); ++it) {
+			auto found = assigned.find(*it);
+			bool isResult = call->result() != nullptr && *it == call->result()->index();
+			if (!isResult && found != assigned.end()) {
+				saved.push_back(found->second);
+			}
+		}
+
+		call->setSavedRegisters(saved);
+	}
+}
+
+void Optimizer::releaseFrameSlots(const Scope scope)
+{
+	if (_atoms.find(scope) == _atoms.end()) {
+		return;
+	}
+
+	const std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	std::vector<unsigned int> params = _symbolTable.parametersIds(scope);
+	std::vector<unsigned int> locals = _symbolTable.localsIds(scope);
+	std::vector<int> accessed;
+
+	for (auto it = atoms.begin(); it != atoms.end(); ++it) {
+		std::vector<std::shared_ptr<RValue>> operands = (*it)->operands();
+		for (auto operand = operands.begin(); operand != operands.end(); ++operand) {
+			_collectLocals(*operand, accessed);
+		}
+		_collectLocals((*it)->result(), accessed);
+	}
+
+	// Params are pushed by caller
+	for (auto it = locals.begin(); it != locals.end(); ++it) {
+		bool isParam = std::find(params.begin(), params.end(), *it) != params.end();
+		bool isAccessed = std::find(accessed.begin(), accessed.end(), (int)*it) != accessed.end();
+
+		if (!isParam && (!isAccessed || _symbolTable[*it].reg != Register::none)) {
+			_symbolTable.releaseSlot(*it);
+			_statistics["frame: released slots"]++;
+		}
+	}
+}
+
+std::vector<std::set<int>> Optimizer::liveVariables(const Scope scope) const
+{
+	const std::vector<std::unique_ptr<Atom>>& atoms = _atoms.at(scope);
+	std::vector<std::set<int>> uses(atoms.size()), defs(atoms.size());
+	std::vector<std::set<int>> liveIn(atoms.size()), liveOut(atoms.size());
+	std::vector<std::vector<unsigned int>> next(atoms.size());
+
+	for (unsigned int i = 0; i < atoms.size(); ++i) {
+		_usesAndDefs(atoms, i, uses[i], defs[i]);
+		next[i] = successors(atoms, i);
+	}
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+
+		for (unsigned int i = atoms.size(); i-- > 0;) {
+			std::set<int> out;
+			for (auto it = next[i].begin(); it != next[i].end(); ++it) {
+				out.insert(liveIn[*it].begin(), liveIn[*it].end());
+			}
+
+			std::set<int> in = uses[i];
+			for (auto it = out.begin(); it != out.end(); ++it) {
+				if (defs[i].find(*it) == defs[i].end()) {
+					in.insert(*it);
+				}
+			}
+
+			if (in != liveIn[i] || out != liveOut[i]) {
+				liveIn[i] = in;
+				liveOut[i] = out;
+				changed = true;
+			}
+		}
+	}
+
+	return liveOut;
+}
+
+const std::map<std::string, unsigned int>& Optimizer::statistics() const
+{
+	return _statistics;
+}
+
+bool Optimizer::sameOperand(const std::shared_ptr<RValue> a, const std::shared_ptr<RValue> b)
+{
+	if (a == nullptr || b == nullptr) {
+		return a == b;
+	}
+
+	std::shared_ptr<NumberOperand> numA = std::dynamic_pointer_cast<NumberOperand>(a);
+	std::shared_ptr<NumberOperand> numB = std::dynamic_pointer_cast<NumberOperand>(b);
+	if (numA != nullptr || numB != nullptr) {
+		return numA != nullptr && numB != nullptr && numA->value() == numB->value();
+	}
+
+	std::shared_ptr<ArrayElementOperand> elA = std::dynamic_pointer_cast<ArrayElementOperand>(a);
+	std::shared_ptr<ArrayElementOperand> elB = std::dynamic_pointer_cast<ArrayElementOperand>(b);
+	if (elA != nullptr || elB != nullptr) {
+		return elA != nullptr && elB != nullptr && elA->index() == elB->index()
+			&& sameOperand(elA->elementIndex(), elB->elementIndex());
+	}
+
+	std::shared_ptr<MemoryOperand> memA = std::dynamic_pointer_cast<MemoryOperand>(a);
+	std::shared_ptr<MemoryOperand> memB = std::dynamic_pointer_cast<MemoryOperand>(b);
+	return memA != nullptr && memB != nullptr && memA->index() == memB->index();
+}
+
+bool Optimizer::refersTo(const std::shared_ptr<RValue> operand, const int index)
+{
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+
+	if (memory == nullptr) {
+		return false;
+	}
+
+	std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+	if (element != nullptr) {
+		return element->index() == index || refersTo(element->elementIndex(), index);
+	}
+
+	return memory->index() == index;
+}
+
+std::vector<unsigned int> Optimizer::findLeaders(const std::vector<std::unique_ptr<Atom>>& atoms)
+{
+	std::vector<unsigned int> leaders;
+
+	for (unsigned int i = 0; i < atoms.size(); ++i) {
+		Atom* atom = atoms[i].get();
+		bool isLabel = dynamic_cast<LabelAtom*>(atom) != nullptr;
+		bool afterJump = i > 0 && (dynamic_cast<JumpAtom*>(atoms[i - 1].get()) != nullptr
+			|| dynamic_cast<ConditionalJumpAtom*>(atoms[i - 1].get()) != nullptr
+			|| dynamic_cast<SwitchAtom*>(atoms[i - 1].get()) != nullptr
+			|| dynamic_cast<RetAtom*>(atoms[i - 1].get()) != nullptr);
+
+		if (i == 0 || isLabel || afterJump) {
+			leaders.push_back(i);
+		}
+	}
+
+	return leaders;
+}
+
+std::vector<unsigned int> Optimizer::loopDepths(const std::vector<std::unique_ptr<Atom>>& atoms)
+{
+	std::vector<unsigned int> depths(atoms.size(), 0);
+
+	for (unsigned int i = 0; i < atoms.size(); ++i) {
+		std::vector<unsigned int> next = successors(atoms, i);
+
+		for (auto it = next.begin(); it != next.end(); ++it) {
+			for (unsigned int j = *it; j <= i; ++j) {
+				depths[j]++;
+			}
+		}
+	}
+
+	return depths;
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> Optimizer::findLoops(const std::vector<std::unique_ptr<Atom>>& atoms)
+{
+	std::vector<std::pair<unsigned int, unsigned int>> loops;
+	std::vector<std::vector<unsigned int>> next(atoms.size());
+
+	for (unsigned int i = 0; i < atoms.size(); ++i) {
+		next[i] = successors(atoms, i);
+
+		for (auto it = next[i].begin(); it != next[i].end(); ++it) {
+			if (*it <= i) {
+				loops.push_back(std::make_pair(*it, i));
+			}
+		}
+	}
+
+	// Merge ranges which overlap without nesting or share header
+	bool merged = true;
+	while (merged) {
+		merged = false;
+
+		for (unsigned int a = 0; a < loops.size() && !merged; ++a) {
+			for (unsigned int b = 0; b < loops.size() && !merged; ++b) {
+				bool overlaps = loops[a].first < loops[b].first && loops[b].first <= loops[a].second
+					&& loops[a].second < loops[b].second;
+				bool sameHeader = a != b && loops[a].first == loops[b].first;
+
+				if (overlaps || sameHeader) {
+					loops[a].second = std::max(loops[a].second, loops[b].second);
+					loops.erase(loops.begin() + b);
+					merged = true;
+				}
+			}
+		}
+	}
+
+	// Only natural loops with preheader are kept: the range is entered only through its header,
+	// so header dominates back jumps, and header is entered from outside only by falling through
+	// from the previous atom. Atoms inserted right before header run once before the loop then.
+	// Other backward jumps (e.g. to default of switch placed before cases) are not loops
+	loops.erase(std::remove_if(loops.begin(), loops.end(), [&atoms, &next](const std::pair<unsigned int, unsigned int>& loop) {
+		if (loop.first > 0) {
+			const Atom* preheader = atoms[loop.first - 1].get();
+			const std::vector<unsigned int>& entries = next[loop.first - 1];
+			bool fallsThrough = dynamic_cast<const JumpAtom*>(preheader) == nullptr && dynamic_cast<const RetAtom*>(preheader) == nullptr
+				&& dynamic_cast<const SwitchAtom*>(preheader) == nullptr;
+
+			// Conditional jump to header would skip atoms inserted before it
+			if (!fallsThrough || std::count(entries.begin(), entries.end(), loop.first) != 1) {
+				return true;
+			}
+		}
+
+		for (unsigned int i = 0; i < atoms.size(); ++i) {
+			if (i >= loop.first && i <= loop.second) {
+				continue;
+			}
+
+			for (auto it = next[i].begin(); it != next[i].end(); ++it) {
+				bool intoBody = *it > loop.first && *it <= loop.second;
+				bool intoHeader = *it == loop.first && i + 1 != loop.first;
+				if (intoBody || intoHeader) {
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}), loops.end());
+
+	std::sort(loops.begin(), loops.end());
+	return loops;
+}
+
+std::vector<unsigned int> Optimizer::successors(const std::vector<std::unique_ptr<Atom>>& atoms, const unsigned int position)
+{
+	std::vector<unsigned int> result;
+	std::vector<std::shared_ptr<LabelOperand>> targets;
+	Atom* atom = atoms[position].get();
+	SwitchAtom* switchAtom = dynamic_cast<SwitchAtom*>(atom);
+
+	if (dynamic_cast<JumpAtom*>(atom) != nullptr) {
+		targets.push_back(dynamic_cast<JumpAtom*>(atom)->label());
+	}
+	else if (dynamic_cast<ConditionalJumpAtom*>(atom) != nullptr) {
+		targets.push_back(dynamic_cast<ConditionalJumpAtom*>(atom)->label());
+	}
+	else if (switchAtom != nullptr) {
+		for (auto it = switchAtom->cases().begin(); it != switchAtom->cases().end(); ++it) {
+			targets.push_back(it->second);
+		}
+		targets.push_back(switchAtom->defaultLabel());
+	}
+
+	for (unsigned int i = 0; i < atoms.size(); ++i) {
+		LabelAtom* label = dynamic_cast<LabelAtom*>(atoms[i].get());
+
+		for (auto it = targets.begin(); it != targets.end() && label != nullptr; ++it) {
+			if (label->label()->id() == (*it)->id() && std::find(result.begin(), result.end(), i) == result.end()) {
+				result.push_back(i);
+			}
+		}
+	}
+
+	bool fallsThrough = dynamic_cast<JumpAtom*>(atom) == nullptr && dynamic_cast<RetAtom*>(atom) == nullptr
+		&& switchAtom == nullptr;
+	if (fallsThrough && position + 1 < atoms.size()) {
+		result.push_back(position + 1);
+	}
+
+	return result;
+}
+
+std::shared_ptr<RValue> Optimizer::_canonical(const std::shared_ptr<RValue> operand, const AvailableValues & values) const
+{
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+
+	if (memory == nullptr || std::dynamic_pointer_cast<ArrayElementOperand>(operand) != nullptr) {
+		return operand;
+	}
+
+	auto copy = values.copies.find(memory->index());
+	return (copy != values.copies.end()) ? copy->second : operand;
+}
+
+bool Optimizer::_equivalent(const std::shared_ptr<RValue> a, const std::shared_ptr<RValue> b, const AvailableValues & values) const
+{
+	std::shared_ptr<ArrayElementOperand> elA = std::dynamic_pointer_cast<ArrayElementOperand>(a);
+	std::shared_ptr<ArrayElementOperand> elB = std::dynamic_pointer_cast<ArrayElementOperand>(b);
+
+	if (elA != nullptr && elB != nullptr) {
+		return elA->index() == elB->index() && _equivalent(elA->elementIndex(), elB->elementIndex(), values);
+	}
+
+	return sameOperand(_canonical(a, values), _canonical(b, values));
+}
+
+void Optimizer::_kill(const std::shared_ptr<MemoryOperand> written, AvailableValues & values) const
+{
+	std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(written);
+	const int index = written->index();
+
+	// Writing to array element invalidates all elements of given array
+	auto depends = [index, &element](const std::shared_ptr<RValue> operand) {
+		if (element != nullptr) {
+			std::shared_ptr<ArrayElementOperand> other = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+			return other != nullptr && other->index() == index;
+		}
+		return refersTo(operand, index);
+	};
+
+	for (auto it = values.expressions.begin(); it != values.expressions.end();) {
+		if (depends(it->left) || depends(it->right) || depends(it->holder)) {
+			it = values.expressions.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	for (auto it = values.loads.begin(); it != values.loads.end();) {
+		if (depends(it->element) || depends(it->holder)) {
+			it = values.loads.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	for (auto it = values.copies.begin(); it != values.copies.end();) {
+		if (element == nullptr && (it->first == index || depends(it->second))) {
+			it = values.copies.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void Optimizer::_killGlobals(AvailableValues & values) const
+{
+	for (auto it = values.expressions.begin(); it != values.expressions.end();) {
+		if (_refersToGlobal(it->left) || _refersToGlobal(it->right) || _refersToGlobal(it->holder)) {
+			it = values.expressions.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	for (auto it = values.loads.begin(); it != values.loads.end();) {
+		if (_refersToGlobal(it->element) || _refersToGlobal(it->holder)) {
+			it = values.loads.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	for (auto it = values.copies.begin(); it != values.copies.end();) {
+		if (_symbolTable[it->first].scope == SymbolTable::GLOBAL_SCOPE || _refersToGlobal(it->second)) {
+			it = values.copies.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+bool Optimizer::_refersToGlobal(const std::shared_ptr<RValue> operand) const
+{
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+
+	if (memory == nullptr) {
+		return false;
+	}
+
+	std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+	if (element != nullptr && _refersToGlobal(element->elementIndex())) {
+		return true;
+	}
+
+	return _symbolTable[memory->index()].scope == SymbolTable::GLOBAL_SCOPE;
+}
+
+bool Optimizer::_truncates(const std::shared_ptr<RValue> value, const std::shared_ptr<RValue> holder)
+{
+	return value->isWide() && !holder->isWide();
+}
+
+bool Optimizer::_fitsByte(const std::shared_ptr<RValue> operand, const std::set<int>& fitting) const
+{
+	std::shared_ptr<NumberOperand> number = std::dynamic_pointer_cast<NumberOperand>(operand);
+	if (number != nullptr) {
+		return number->value() >= 0 && number->value() <= 255;
+	}
+
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+	if (memory == nullptr) {
+		return false;
+	}
+
+	// Chars are zero extended
+	return _symbolTable[memory->index()].type == SymbolTable::TableRecord::RecordType::chr
+		|| (std::dynamic_pointer_cast<ArrayElementOperand>(operand) == nullptr && fitting.count(memory->index()) > 0);
+}
+
+bool Optimizer::_producesByte(const Atom* atom, const std::set<int>& fitting) const
+{
+	if (dynamic_cast<const InAtom*>(atom) != nullptr) {
+		return true;
+	}
+
+	const CallAtom* call = dynamic_cast<const CallAtom*>(atom);
+	if (call != nullptr) {
+		return _symbolTable[call->function()->index()].type == SymbolTable::TableRecord::RecordType::chr;
+	}
+
+	std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+
+	const UnaryOpAtom* unary = dynamic_cast<const UnaryOpAtom*>(atom);
+	if (unary != nullptr) {
+		return unary->name() == "MOV" && _fitsByte(operands[0], fitting);
+	}
+
+	const BinaryOpAtom* binary = dynamic_cast<const BinaryOpAtom*>(atom);
+	if (binary == nullptr) {
+		return false;
+	}
+
+	// Division is signed: quotient of non-negative operands isn't greater than dividend,
+	// remainder takes sign of dividend and isn't greater than it
+	const std::string& name = binary->name();
+	bool left = _fitsByte(operands[0], fitting);
+	bool right = _fitsByte(operands[1], fitting);
+	return (name == "AND" && (left || right)) || (name == "OR" && left && right)
+		|| (name == "DIV" && left && right) || (name == "MOD" && left);
+}
+
+bool Optimizer::_readsLowByte(const Atom* atom, const int index, const std::set<int>& narrow) const
+{
+	std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+	std::shared_ptr<MemoryOperand> result = atom->result();
+
+	bool reads = false;
+	for (auto it = operands.begin(); it != operands.end(); ++it) {
+		reads = reads || refersTo(*it, index);
+	}
+	if (result != nullptr && std::dynamic_pointer_cast<ArrayElementOperand>(result) != nullptr && refersTo(result, index)) {
+		return false;
+	}
+	if (!reads) {
+		return true;
+	}
+
+	// Element indexes are read as whole words
+	for (auto it = operands.begin(); it != operands.end(); ++it) {
+		if (refersTo(*it, index) && std::dynamic_pointer_cast<ArrayElementOperand>(*it) != nullptr) {
+			return false;
+		}
+	}
+
+	// Low byte of these operations depends only on low bytes of operands
+	const UnaryOpAtom* unary = dynamic_cast<const UnaryOpAtom*>(atom);
+	const BinaryOpAtom* binary = dynamic_cast<const BinaryOpAtom*>(atom);
+	const std::string name = unary != nullptr ? unary->name() : (binary != nullptr ? binary->name() : "");
+	if (name != "MOV" && name != "NOT" && name != "ADD" && name != "SUB" && name != "MUL" && name != "AND" && name != "OR") {
+		return false;
+	}
+
+	if (std::dynamic_pointer_cast<ArrayElementOperand>(result) == nullptr && narrow.count(result->index()) > 0) {
+		return true;
+	}
+	return _symbolTable[result->index()].type == SymbolTable::TableRecord::RecordType::chr;
+}
+
+bool Optimizer::_isInlinable(const Scope function, const unsigned int threshold)
+{
+	if (_atoms.find(function) == _atoms.end() || _atoms[function].size() > threshold
+		|| _symbolTable.getArraysSize(function) > 0) {
+		return false;
+	}
+
+	const std::vector<std::unique_ptr<Atom>>& body = _atoms[function];
+	for (auto it = body.begin(); it != body.end(); ++it) {
+		if (dynamic_cast<CallAtom*>(it->get()) != nullptr) {
+			return false;
+		}
+	}
+
+	// Locals read before write rely on zeroed frame of callee
+	std::set<int> entry = _liveOnEntry(function);
+	std::vector<unsigned int> params = _symbolTable.parametersIds(function);
+
+	for (auto it = entry.begin(); it != entry.end(); ++it) {
+		if (std::find(params.begin(), params.end(), (unsigned int)*it) == params.end()) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::shared_ptr<RValue> Optimizer::_propagate(const std::shared_ptr<RValue> operand, const std::map<int, std::shared_ptr<RValue>>& copies) const
+{
+	std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+	if (element != nullptr) {
+		std::shared_ptr<RValue> index = _propagate(element->elementIndex(), copies);
+
+		return (index != element->elementIndex()) ?
+			std::make_shared<ArrayElementOperand>(element->index(), index, &_symbolTable) : operand;
+	}
+
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+	if (memory != nullptr && copies.find(memory->index()) != copies.end()) {
+		return copies.at(memory->index());
+	}
+
+	return operand;
+}
+
+void Optimizer::_coalesceMoves(const Scope scope)
+{
+	std::vector<std::unique_ptr<Atom>>& atoms = _atoms[scope];
+	std::vector<std::set<int>> live = liveVariables(scope);
+
+	for (unsigned int i = 0; i + 1 < atoms.size(); ++i) {
+		const Atom* atom = atoms[i].get();
+		UnaryOpAtom* move = dynamic_cast<UnaryOpAtom*>(atoms[i + 1].get());
+		std::shared_ptr<MemoryOperand> temporary = atom->result();
+
+		if (move == nullptr || move->name() != "MOV" || temporary == nullptr) {
+			continue;
+		}
+
+		std::vector<int> written;
+		if (std::dynamic_pointer_cast<ArrayElementOperand>(temporary) == nullptr) {
+			_collectLocals(temporary, written);
+		}
+
+		// Temporary is read only by the MOV
+		std::shared_ptr<MemoryOperand> destination = move->result();
+		if (written.empty() || !sameOperand(move->operands()[0], temporary) || live[i + 1].count(written[0]) > 0
+			|| refersTo(destination, written[0]) || _truncates(destination, temporary)) {
+			continue;
+		}
+
+		std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+		bool readsTemporary = false;
+		for (auto it = operands.begin(); it != operands.end(); ++it) {
+			readsTemporary = readsTemporary || refersTo(*it, written[0]);
+		}
+		if (readsTemporary) {
+			continue;
+		}
+
+		std::unique_ptr<Atom> coalesced;
+		if (typeid(*atom) == typeid(SimpleBinaryOpAtom)) {
+			coalesced = std::make_unique<SimpleBinaryOpAtom>(dynamic_cast<const BinaryOpAtom*>(atom)->name(), operands[0], operands[1], destination);
+		}
+		else if (typeid(*atom) == typeid(FnBinaryOpAtom)) {
+			coalesced = std::make_unique<FnBinaryOpAtom>(dynamic_cast<const BinaryOpAtom*>(atom)->name(), operands[0], operands[1], destination);
+		}
+		else if (typeid(*atom) == typeid(UnaryOpAtom)) {
+			coalesced = std::make_unique<UnaryOpAtom>(dynamic_cast<const UnaryOpAtom*>(atom)->name(), operands[0], destination);
+		}
+		else {
+			continue;
+		}
+
+		coalesced->setPosition(atom->position());
+		atoms[i] = std::move(coalesced);
+		atoms.erase(atoms.begin() + i + 1);
+		live.erase(live.begin() + i + 1);
+		_statistics["copies: coalesced"]++;
+	}
+}
+
+bool Optimizer::_isLoopInvariant(const std::vector<std::unique_ptr<Atom>>& atoms, const std::pair<unsigned int, unsigned int>& loop,
+	const unsigned int position, const std::vector<std::set<int>>& live) const
+{
+	const Atom* atom = atoms[position].get();
+
+	if (dynamic_cast<const BinaryOpAtom*>(atom) == nullptr && dynamic_cast<const UnaryOpAtom*>(atom) == nullptr) {
+		return false;
+	}
+
+	// Only local scalars, globals may be read by called functions
+	std::shared_ptr<MemoryOperand> result = atom->result();
+	std::vector<int> written;
+	if (std::dynamic_pointer_cast<ArrayElementOperand>(result) == nullptr) {
+		_collectLocals(result, written);
+	}
+	if (written.empty()) {
+		return false;
+	}
+
+	bool hasCalls = false;
+	for (unsigned int i = loop.first; i <= loop.second; ++i) {
+		hasCalls = hasCalls || dynamic_cast<const CallAtom*>(atoms[i].get()) != nullptr;
+	}
+
+	std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+	for (auto it = operands.begin(); it != operands.end(); ++it) {
+		if (!_isInvariantOperand(atoms, loop, *it, hasCalls)) {
+			return false;
+		}
+	}
+
+	// Result is written only here
+	for (unsigned int i = loop.first; i <= loop.second; ++i) {
+		std::shared_ptr<MemoryOperand> other = atoms[i]->result();
+		if (i != position && other != nullptr && other->index() == written[0]) {
+			return false;
+		}
+	}
+
+	// Previous value isn't read in the loop or after leaving it
+	if (live[loop.first].count(written[0]) > 0) {
+		return false;
+	}
+	for (unsigned int i = loop.first; i <= loop.second; ++i) {
+		std::vector<unsigned int> next = successors(atoms, i);
+
+		for (auto it = next.begin(); it != next.end(); ++it) {
+			if ((*it < loop.first || *it > loop.second) && live[i].count(written[0]) > 0) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Optimizer::_isInvariantOperand(const std::vector<std::unique_ptr<Atom>>& atoms, const std::pair<unsigned int, unsigned int>& loop,
+	const std::shared_ptr<RValue> operand, const bool hasCalls) const
+{
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+
+	if (memory == nullptr) {
+		return std::dynamic_pointer_cast<NumberOperand>(operand) != nullptr;
+	}
+
+	// Called function may change globals
+	if (hasCalls && _symbolTable[memory->index()].scope == SymbolTable::GLOBAL_SCOPE) {
+		return false;
+	}
+
+	for (unsigned int i = loop.first; i <= loop.second; ++i) {
+		std::shared_ptr<MemoryOperand> result = atoms[i]->result();
+		if (result != nullptr && result->index() == memory->index()) {
+			return false;
+		}
+	}
+
+	std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+	return element == nullptr || _isInvariantOperand(atoms, loop, element->elementIndex(), hasCalls);
+}
+
+int Optimizer::_inductionUpdate(const std::vector<std::unique_ptr<Atom>>& atoms, const std::pair<unsigned int, unsigned int>& loop,
+	const std::shared_ptr<RValue> variable, int & step) const
+{
+	std::vector<int> locals;
+	if (std::dynamic_pointer_cast<ArrayElementOperand>(variable) == nullptr) {
+		_collectLocals(variable, locals);
+	}
+	if (locals.empty()) {
+		return -1;
+	}
+
+	int update = -1;
+	for (unsigned int i = loop.first; i <= loop.second; ++i) {
+		std::shared_ptr<MemoryOperand> result = atoms[i]->result();
+		if (result == nullptr || std::dynamic_pointer_cast<ArrayElementOperand>(result) != nullptr
+			|| result->index() != locals[0]) {
+			continue;
+		}
+
+		// Variable is written more than once
+		if (update >= 0) {
+			return -1;
+		}
+		update = i;
+	}
+
+	if (update < 0) {
+		return -1;
+	}
+
+	// Operation may write temporary which is moved to variable
+	const Atom* operation = atoms[update].get();
+	const UnaryOpAtom* move = dynamic_cast<const UnaryOpAtom*>(operation);
+	if (move != nullptr && move->name() == "MOV" && update > (int)loop.first) {
+		operation = atoms[update - 1].get();
+		if (!sameOperand(operation->result(), move->operands()[0])) {
+			return -1;
+		}
+	}
+
+	const SimpleBinaryOpAtom* binary = dynamic_cast<const SimpleBinaryOpAtom*>(operation);
+	if (binary == nullptr || (binary->name() != "ADD" && binary->name() != "SUB")) {
+		return -1;
+	}
+
+	std::vector<std::shared_ptr<RValue>> operands = binary->operands();
+	std::shared_ptr<NumberOperand> left = std::dynamic_pointer_cast<NumberOperand>(operands[0]);
+	std::shared_ptr<NumberOperand> right = std::dynamic_pointer_cast<NumberOperand>(operands[1]);
+
+	if (right != nullptr && sameOperand(operands[0], variable)) {
+		step = (binary->name() == "ADD") ? right->value() : -right->value();
+	}
+	else if (left != nullptr && binary->name() == "ADD" && sameOperand(operands[1], variable)) {
+		step = left->value();
+	}
+	else {
+		return -1;
+	}
+
+	return (step != 0) ? update : -1;
+}
+
+std::set<int> Optimizer::_liveOnEntry(const Scope scope) const
+{
+	const std::vector<std::unique_ptr<Atom>>& atoms = _atoms.at(scope);
+	std::set<int> entry;
+
+	if (atoms.empty()) {
+		return entry;
+	}
+
+	std::set<int> uses, defs;
+	_usesAndDefs(atoms, 0, uses, defs);
+	entry = liveVariables(scope)[0];
+	for (auto it = defs.begin(); it != defs.end(); ++it) {
+		entry.erase(*it);
+	}
+	entry.insert(uses.begin(), uses.end());
+
+	return entry;
+}
+
+std::shared_ptr<RValue> Optimizer::_remap(const std::shared_ptr<RValue> operand, const std::map<int, std::shared_ptr<MemoryOperand>>& records) const
+{
+	std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+	if (element != nullptr) {
+		return std::make_shared<ArrayElementOperand>(element->index(), _remap(element->elementIndex(), records), &_symbolTable);
+	}
+
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+	if (memory != nullptr && records.find(memory->index()) != records.end()) {
+		return records.at(memory->index());
+	}
+
+	return operand;
+}
+
+std::unique_ptr<Atom> Optimizer::_copyAtom(const Atom * atom, const std::map<int, std::shared_ptr<MemoryOperand>>& records,
+	std::map<int, std::shared_ptr<LabelOperand>>& labels, const std::function<std::shared_ptr<LabelOperand>()>& newLabel) const
+{
+	auto label = [&labels, &newLabel](const std::shared_ptr<LabelOperand> old) {
+		if (labels.find(old->id()) == labels.end()) {
+			labels[old->id()] = newLabel();
+		}
+		return labels[old->id()];
+	};
+
+	std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+	for (auto it = operands.begin(); it != operands.end(); ++it) {
+		*it = _remap(*it, records);
+	}
+	std::shared_ptr<MemoryOperand> result = std::dynamic_pointer_cast<MemoryOperand>(_remap(atom->result(), records));
+
+	if (typeid(*atom) == typeid(SimpleBinaryOpAtom)) {
+		return std::make_unique<SimpleBinaryOpAtom>(dynamic_cast<const BinaryOpAtom*>(atom)->name(), operands[0], operands[1], result);
+	}
+	else if (typeid(*atom) == typeid(FnBinaryOpAtom)) {
+		return std::make_unique<FnBinaryOpAtom>(dynamic_cast<const BinaryOpAtom*>(atom)->name(), operands[0], operands[1], result);
+	}
+	else if (typeid(*atom) == typeid(UnaryOpAtom)) {
+		return std::make_unique<UnaryOpAtom>(dynamic_cast<const UnaryOpAtom*>(atom)->name(), operands[0], result);
+	}
+	else if (typeid(*atom) == typeid(SimpleConditionalJumpAtom)) {
+		const ConditionalJumpAtom* jump = dynamic_cast<const ConditionalJumpAtom*>(atom);
+		return std::make_unique<SimpleConditionalJumpAtom>(jump->condition(), operands[0], operands[1], label(jump->label()));
+	}
+	else if (typeid(*atom) == typeid(ComplexConditinalJumpAtom)) {
+		const ConditionalJumpAtom* jump = dynamic_cast<const ConditionalJumpAtom*>(atom);
+		return std::make_unique<ComplexConditinalJumpAtom>(jump->condition(), operands[0], operands[1], label(jump->label()));
+	}
+	else if (typeid(*atom) == typeid(OutAtom)) {
+		if (operands.empty()) {
+			return std::make_unique<OutAtom>(dynamic_cast<const OutAtom*>(atom)->value());
+		}
+		return std::make_unique<OutAtom>(operands[0]);
+	}
+	else if (typeid(*atom) == typeid(InAtom)) {
+		return std::make_unique<InAtom>(result);
+	}
+	else if (typeid(*atom) == typeid(SwitchAtom)) {
+		const SwitchAtom* switchAtom = dynamic_cast<const SwitchAtom*>(atom);
+		std::vector<std::pair<int, std::shared_ptr<LabelOperand>>> cases;
+		for (auto it = switchAtom->cases().begin(); it != switchAtom->cases().end(); ++it) {
+			cases.push_back({ it->first, label(it->second) });
+		}
+		return std::make_unique<SwitchAtom>(operands[0], cases, label(switchAtom->defaultLabel()), newLabel());
+	}
+	else if (typeid(*atom) == typeid(LabelAtom)) {
+		return std::make_unique<LabelAtom>(label(dynamic_cast<const LabelAtom*>(atom)->label()));
+	}
+
+	return std::make_unique<JumpAtom>(label(dynamic_cast<const JumpAtom*>(atom)->label()));
+}
+
+void Optimizer::_collectLocals(const std::shared_ptr<RValue> operand, std::vector<int>& locals) const
+{
+	std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+
+	if (memory == nullptr) {
+		return;
+	}
+
+	std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+	if (element != nullptr) {
+		_collectLocals(element->elementIndex(), locals);
+		return;
+	}
+
+	const SymbolTable::TableRecord& record = _symbolTable[memory->index()];
+	if (record.kind == SymbolTable::TableRecord::RecordKind::var && record.scope != SymbolTable::GLOBAL_SCOPE) {
+		locals.push_back(memory->index());
+	}
+}
+
+void Optimizer::_usesAndDefs(const std::vector<std::unique_ptr<Atom>>& atoms, const unsigned int position,
+	std::set<int>& uses, std::set<int>& defs) const
+{
+	Atom* atom = atoms[position].get();
+	std::vector<int> read;
+
+	if (dynamic_cast<ParamAtom*>(atom) != nullptr) {
+		return;
+	}
+
+	std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+	for (auto it = operands.begin(); it != operands.end(); ++it) {
+		_collectLocals(*it, read);
+	}
+
+	// Params are loaded by call
+	if (dynamic_cast<CallAtom*>(atom) != nullptr) {
+		for (unsigned int i = position; i-- > 0 && dynamic_cast<CallAtom*>(atoms[i].get()) == nullptr;) {
+			if (dynamic_cast<ParamAtom*>(atoms[i].get()) != nullptr) {
+				_collectLocals(atoms[i]->operands()[0], read);
+			}
+		}
+	}
+
+	std::shared_ptr<MemoryOperand> result = atom->result();
+	if (std::dynamic_pointer_cast<ArrayElementOperand>(result) != nullptr) {
+		_collectLocals(result, read);
+	}
+	else if (result != nullptr) {
+		std::vector<int> written;
+		_collectLocals(result, written);
+		defs.insert(written.begin(), written.end());
+	}
+
+	uses.insert(read.begin(), read.end());
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include "..\Atom\Atom.h"
+#include "..\SymbolTable\SymbolTable.h"
+
+// Machine independent optimizations over atoms of functions
+class Optimizer {
+public:
+	// Functions with at most this count of atoms are inlined by default
+	static const unsigned int INLINE_THRESHOLD = 16;
+
+	Optimizer(std::map<Scope, std::vector<std::unique_ptr<Atom>>>& atoms, SymbolTable& symbolTable);
+
+	// Replaces self calls whose result is returned right away with reassignment of params
+	// and jump to the function start, so recursion reuses the frame
+	void eliminateTailRecursion(const Scope scope, const std::function<std::shared_ptr<LabelOperand>()>& newLabel);
+
+	// Replaces calls of small leaf functions with copies of their atoms. Callee locals and
+	// temporaries become temporaries of caller, returns become moves to call result and jumps
+	void inlineCalls(const Scope scope, const std::function<std::shared_ptr<LabelOperand>()>& newLabel,
+		const unsigned int threshold = INLINE_THRESHOLD);
+
+	// Moves atoms whose operands are not changed inside loop to preheader of the loop
+	void hoistLoopInvariants(const Scope scope);
+
+	// Replaces multiplications of loop induction variable by constant with running sum
+	// computed before the loop and increased together with the variable
+	void reduceInductionMultiplications(const Scope scope);
+
+	// Local (per basic block) common subexpression elimination. Repeated expressions are replaced
+	// with MOV from the first result, repeated array element loads reuse the first loaded value
+	void eliminateCommonSubexpressions(const Scope scope);
+
+	// Replaces reads of variables copied by MOV with their sources (locals and numbers) inside
+	// basic blocks. Operation into temporary followed by MOV of the temporary writes destination
+	// directly. MOVs left unused are removed by dead code elimination
+	void propagateCopies(const Scope scope);
+
+	// Removes operations whose results are never read. Calls are kept, but their unused
+	// results are not stored
+	void eliminateDeadCode(const Scope scope);
+
+	// Narrows int temporaries to char when all their values fit into byte or when only their
+	// low byte is read, so the operations on them use 8-bit code
+	void inferTypes(const Scope scope);
+
+	// Places locals and temporaries of function into registers which are not used by its code.
+	// Variables with more uses inside loops are placed first, variables which are never live
+	// at the same time share register. Others stay in their frame slots
+	void allocateRegisters(const Scope scope);
+
+	// Releases frame slots of locals and temporaries which are not accessed through frame:
+	// removed by optimizations or placed into registers
+	void releaseFrameSlots(const Scope scope);
+
+	// Returns local variables live after every atom of function
+	std::vector<std::set<int>> liveVariables(const Scope scope) const;
+
+	// Returns counters of applied transformations
+	const std::map<std::string, unsigned int>& statistics() const;
+
+	// Checks whether both operands denote the same value
+	static bool sameOperand(const std::shared_ptr<RValue> a, const std::shared_ptr<RValue> b);
+
+	// Checks whether operand reads record with given index (including array element index)
+	static bool refersTo(const std::shared_ptr<RValue> operand, const int index);
+
+	// Returns indexes of atoms starting basic blocks
+	static std::vector<unsigned int> findLeaders(const std::vector<std::unique_ptr<Atom>>& atoms);
+
+	// Returns loop nesting depth of every atom, loops are found by backward jumps
+	static std::vector<unsigned int> loopDepths(const std::vector<std::unique_ptr<Atom>>& atoms);
+
+	// Returns [header, last atom] ranges of loops. Back jumps into the middle of a loop
+	// (e.g. to the step of for) extend it, nested loops are returned separately. Only loops
+	// entered through header, which is preceded by preheader falling through into it, are returned
+	static std::vector<std::pair<unsigned int, unsigned int>> findLoops(const std::vector<std::unique_ptr<Atom>>& atoms);
+
+	// Returns indexes of atoms which can be executed right after given one
+	static std::vector<unsigned int> successors(const std::vector<std::unique_ptr<Atom>>& atoms, const unsigned int position);
+
+private:
+	std::map<Scope, std::vector<std::unique_ptr<Atom>>>& _atoms;
+	SymbolTable& _symbolTable;
+	std::map<std::string, unsigned int> _statistics;
+
+	// Expression available in basic block
+	struct Expression {
+		std::string name;
+		std::shared_ptr<RValue> left;
+		std::shared_ptr<RValue> right;
+		std::shared_ptr<MemoryOperand> holder;
+	};
+
+	// Array element loaded in basic block. Until second read holder is nullptr and position
+	// points to the first reader, so load can be moved to a temporary on demand
+	struct Load {
+		std::shared_ptr<ArrayElementOperand> element;
+		std::shared_ptr<RValue> holder;
+		unsigned int position;
+	};
+
+	// State of local CSE for single basic block
+	struct AvailableValues {
+		std::vector<Expression> expressions;
+		std::vector<Load> loads;
+		std::map<int, std::shared_ptr<RValue>> copies;
+	};
+
+	// Replaces copied variable with its source
+	std::shared_ptr<RValue> _canonical(const std::shared_ptr<RValue> operand, const AvailableValues& values) const;
+	bool _equivalent(const std::shared_ptr<RValue> a, const std::shared_ptr<RValue> b, const AvailableValues& values) const;
+
+	// Removes values invalidated by write to given operand
+	void _kill(const std::shared_ptr<MemoryOperand> written, AvailableValues& values) const;
+
+	// Removes values which depend on global records (e.g. after function call)
+	void _killGlobals(AvailableValues& values) const;
+
+	bool _refersToGlobal(const std::shared_ptr<RValue> operand) const;
+
+	// Checks whether holder keeps only low byte of value, so they can't replace each other
+	static bool _truncates(const std::shared_ptr<RValue> value, const std::shared_ptr<RValue> holder);
+
+	// Checks whether value of operand is in [0, 255]. Temporaries from given set are known to fit
+	bool _fitsByte(const std::shared_ptr<RValue> operand, const std::set<int>& fitting) const;
+
+	// Checks whether every value written by atom fits into byte
+	bool _producesByte(const Atom* atom, const std::set<int>& fitting) const;
+
+	// Checks whether atom reads only low byte of given variable. Records from narrow set
+	// are treated as chars
+	bool _readsLowByte(const Atom* atom, const int index, const std::set<int>& narrow) const;
+
+	// Checks whether calls of given function can be replaced with its atoms
+	bool _isInlinable(const Scope function, const unsigned int threshold);
+
+	// Replaces callee records with caller ones, globals are kept
+	std::shared_ptr<RValue> _remap(const std::shared_ptr<RValue> operand, const std::map<int, std::shared_ptr<MemoryOperand>>& records) const;
+
+	// Copies atom of inlined function, labels are replaced with new ones
+	std::unique_ptr<Atom> _copyAtom(const Atom* atom, const std::map<int, std::shared_ptr<MemoryOperand>>& records,
+		std::map<int, std::shared_ptr<LabelOperand>>& labels, const std::function<std::shared_ptr<LabelOperand>()>& newLabel) const;
+
+	// Replaces copied variable (also inside array element index) with its source
+	std::shared_ptr<RValue> _propagate(const std::shared_ptr<RValue> operand, const std::map<int, std::shared_ptr<RValue>>& copies) const;
+
+	// Writes result of MOV of temporary right by the operation computing it
+	void _coalesceMoves(const Scope scope);
+
+	// Checks whether atom computes the same value on every iteration and can be executed
+	// once before the loop
+	bool _isLoopInvariant(const std::vector<std::unique_ptr<Atom>>& atoms, const std::pair<unsigned int, unsigned int>& loop,
+		const unsigned int position, const std::vector<std::set<int>>& live) const;
+
+	// Checks whether operand isn't written inside loop
+	bool _isInvariantOperand(const std::vector<std::unique_ptr<Atom>>& atoms, const std::pair<unsigned int, unsigned int>& loop,
+		const std::shared_ptr<RValue> operand, const bool hasCalls) const;
+
+	// Finds the only update of induction variable inside loop: `i = i +- c` as single atom
+	// or as operation into temporary and MOV. Returns position of the last atom of update or -1
+	int _inductionUpdate(const std::vector<std::unique_ptr<Atom>>& atoms, const std::pair<unsigned int, unsigned int>& loop,
+		const std::shared_ptr<RValue> variable, int& step) const;
+
+	// Local variables which are read before written
+	std::set<int> _liveOnEntry(const Scope scope) const;
+
+	// Adds local scalar variables read by operand
+	void _collectLocals(const std::shared_ptr<RValue> operand, std::vector<int>& locals) const;
+
+	// Local variables read and written by atom. Params are read by call, not by ParamAtom
+	void _usesAndDefs(const std::vector<std::unique_ptr<Atom>>& atoms, const unsigned int position,
+		std::set<int>& uses, std::set<int>& defs) const;
+};
@@ -0,0 +1,321 @@
+#include <vector>
+#include "Runtime.h"
+
+const std::string Runtime::MUL = "@MUL";
+const std::string Runtime::MUL16 = "@MUL16";
+const std::string Runtime::DIV = "@DIV";
+const std::string Runtime::DIV16 = "@DIV16";
+const std::string Runtime::PRINT_NUMBER = "@OUTD";
+const std::string Runtime::PRINT_NUMBER16 = "@OUTD16";
+const std::string Runtime::PRINT = "@PRINT";
+
+void Runtime::generate(CodeWriter& stream, const std::set<std::string>& routines)
+{
+	if (routines.count(MUL) > 0) {
+		_generateMul(stream);
+	}
+	if (routines.count(MUL16) > 0) {
+		_generateMul16(stream);
+	}
+	if (routines.count(DIV) > 0) {
+		_generateDiv(stream);
+	}
+	if (routines.count(DIV16) > 0) {
+		_generateDiv16(stream);
+	}
+	if (routines.count(PRINT_NUMBER) > 0) {
+		_generatePrintNumber(stream);
+	}
+	if (routines.count(PRINT_NUMBER16) > 0) {
+		_generatePrintNumber16(stream);
+	}
+	if (routines.count(PRINT) > 0) {
+		_generatePrint(stream);
+	}
+}
+
+void Runtime::generateEntry(CodeWriter& stream, const std::set<std::string>& routines)
+{
+	stream << "ORG 0\n";
+	stream << "LXI H, 0\n";
+	stream << "SPHL\n";
+	stream << "CALL main\n";
+	stream << "END\n";
+
+	// Only routines called by program are linked
+	generate(stream, routines);
+}
+
+unsigned int Runtime::worstCase(const std::string & routine)
+{
+	static const std::map<std::string, unsigned int> cycles = {
+		{ MUL, 304 }, { MUL16, 798 }, { DIV, 451 }, { DIV16, 2014 },
+		{ PRINT_NUMBER, 365 }, { PRINT_NUMBER16, 1331 }, { PRINT, 47 }
+	};
+
+	return cycles.at(routine);
+}
+
+void Runtime::_generateMul(CodeWriter& stream)
+{
+	// Multiplier is shifted out of H from the highest bit, product in L is doubled
+	// by the same DAD H. Bits moved from L to H never reach its top
+	stream << MUL << ":\n";
+	stream << "MOV H, B\n";
+	stream << "MOV B, A\n";
+	stream << "MVI L, 0\n";
+
+	for (unsigned int bit = 1; bit <= 8; ++bit) {
+		stream << "DAD H\n";
+		stream << "JNC " << MUL << "S" << bit << '\n';
+		stream << "MOV A, L\n";
+		stream << "ADD B\n";
+		stream << "MOV L, A\n";
+		stream << MUL << "S" << bit << ":\n";
+	}
+
+	stream << "MOV A, L\n";
+	stream << "RET\n";
+}
+
+void Runtime::_generateMul16(CodeWriter& stream)
+{
+	// Product in HL is doubled, multiplier in DE is shifted out from the highest bit
+	stream << MUL16 << ":\n";
+	stream << "MOV B, H\n";
+	stream << "MOV C, L\n";
+	stream << "LXI H, 0\n";
+
+	for (unsigned int bit = 1; bit <= 16; ++bit) {
+		stream << "DAD H\n";
+		stream << "XCHG\n";
+		stream << "DAD H\n";
+		stream << "XCHG\n";
+		stream << "JNC " << MUL16 << "S" << bit << '\n';
+		stream << "DAD B\n";
+		stream << MUL16 << "S" << bit << ":\n";
+	}
+
+	stream << "RET\n";
+}
+
+void Runtime::_generateDiv(CodeWriter& stream)
+{
+	// Restoring division: dividend is shifted from L to remainder in H, quotient bits
+	// take freed bits of L. Carry out of H means remainder is greater than divisor
+	stream << DIV << ":\n";
+	stream << "MOV L, A\n";
+	stream << "MVI H, 0\n";
+
+	for (unsigned int bit = 1; bit <= 8; ++bit) {
+		stream << "DAD H\n";
+		stream << "MOV A, H\n";
+		stream << "JC " << DIV << "T" << bit << '\n';
+		stream << "CMP B\n";
+		stream << "JC " << DIV << "S" << bit << '\n';
+		stream << DIV << "T" << bit << ":\n";
+		stream << "SUB B\n";
+		stream << "MOV H, A\n";
+		stream << "INR L\n";
+		stream << DIV << "S" << bit << ":\n";
+	}
+
+	stream << "MOV A, L\n";
+	stream << "RET\n";
+}
+
+void Runtime::_generateDiv16(CodeWriter& stream)
+{
+	// Operands are divided as unsigned magnitudes. Sign of remainder is sign of dividend,
+	// it's saved on stack with sign of quotient
+	stream << DIV16 << ":\n";
+	stream << "MOV A, H\n";
+	stream << "PUSH PSW\n";
+	stream << "XRA D\n";
+	stream << "PUSH PSW\n";
+
+	stream << "MOV A, H\n";
+	stream << "ORA A\n";
+	stream << "JP " << DIV16 << "X\n";
+	_generateNegate(stream, "H", "L");
+	stream << DIV16 << "X:\n";
+	stream << "MOV A, D\n";
+	stream << "ORA A\n";
+	stream << "JP " << DIV16 << "Y\n";
+	_generateNegate(stream, "D", "E");
+	stream << DIV16 << "Y:\n";
+
+	// Restoring division: dividend is shifted from HL to remainder in BC, quotient bits
+	// take freed bits of L. Carry out of B means remainder is greater than divisor
+	stream << "LXI B, 0\n";
+
+	for (unsigned int bit = 1; bit <= 16; ++bit) {
+		stream << "DAD H\n";
+		stream << "MOV A, C\n";
+		stream << "RAL\n";
+		stream << "MOV C, A\n";
+		stream << "MOV A, B\n";
+		stream << "RAL\n";
+		stream << "MOV B, A\n";
+		stream << "JC " << DIV16 << "T" << bit << '\n';
+		stream << "MOV A, C\n";
+		stream << "SUB E\n";
+		stream << "MOV A, B\n";
+		stream << "SBB D\n";
+		stream << "JC " << DIV16 << "S" << bit << '\n';
+		stream << DIV16 << "T" << bit << ":\n";
+		stream << "MOV A, C\n";
+		stream << "SUB E\n";
+		stream << "MOV C, A\n";
+		stream << "MOV A, B\n";
+		stream << "SBB D\n";
+		stream << "MOV B, A\n";
+		stream << "INR L\n";
+		stream << DIV16 << "S" << bit << ":\n";
+	}
+
+	stream << "POP PSW\n";
+	stream << "ORA A\n";
+	stream << "JP " << DIV16 << "Q\n";
+	_generateNegate(stream, "H", "L");
+	stream << DIV16 << "Q:\n";
+	stream << "POP PSW\n";
+	stream << "ORA A\n";
+	stream << "RP\n";
+	_generateNegate(stream, "B", "C");
+	stream << "RET\n";
+}
+
+void Runtime::_generatePrintNumber(CodeWriter& stream)
+{
+	const std::string& name = PRINT_NUMBER;
+
+	stream << name << ":\n";
+	stream << "CPI 10\n";
+	stream << "JC " << name << "1\n";
+	stream << "CPI 100\n";
+	stream << "JC " << name << "10\n";
+
+	// Hundreds are 1 or 2
+	stream << "MVI B, '1'\n";
+	stream << "SUI 100\n";
+	stream << "CPI 100\n";
+	stream << "JC " << name << "100\n";
+	stream << "INR B\n";
+	stream << "SUI 100\n";
+	stream << name << "100:\n";
+	stream << "MOV L, A\n";
+	stream << "MOV A, B\n";
+	stream << "OUT " << CONSOLE_PORT << '\n';
+	stream << "MOV A, L\n";
+
+	// Tens digit is collected from 80, 40, 20 and 10
+	stream << name << "10:\n";
+	stream << "MVI B, '0'\n";
+
+	for (unsigned int weight = 8; weight > 0; weight /= 2) {
+		stream << "CPI " << weight * 10 << '\n';
+		stream << "JC " << name << "T" << weight << '\n';
+		stream << "SUI " << weight * 10 << '\n';
+		stream << "MOV L, A\n";
+		stream << "MOV A, B\n";
+		stream << "ADI " << weight << '\n';
+		stream << "MOV B, A\n";
+		stream << "MOV A, L\n";
+		stream << name << "T" << weight << ":\n";
+	}
+
+	stream << "MOV L, A\n";
+	stream << "MOV A, B\n";
+	stream << "OUT " << CONSOLE_PORT << '\n';
+	stream << "MOV A, L\n";
+
+	stream << name << "1:\n";
+	stream << "ADI '0'\n";
+	stream << "OUT " << CONSOLE_PORT << '\n';
+	stream << "RET\n";
+}
+
+void Runtime::_generatePrintNumber16(CodeWriter& stream)
+{
+	const std::string& name = PRINT_NUMBER16;
+
+	// Negative number is printed as minus and its magnitude
+	stream << name << ":\n";
+	stream << "MOV A, H\n";
+	stream << "ORA A\n";
+	stream << "JP " << name << "P\n";
+	stream << "MVI A, '-'\n";
+	stream << "OUT " << CONSOLE_PORT << '\n';
+	_generateNegate(stream, "H", "L");
+	stream << name << "P:\n";
+
+	// Digits are collected in B from binary weights of powers of ten, C becomes
+	// nonzero after the first printed digit, so leading zeros are skipped. E keeps
+	// low byte of difference, DE is saved as it usually holds variable
+	stream << "PUSH D\n";
+	stream << "MVI C, 0\n";
+
+	const std::vector<unsigned int> powers = { 10000, 1000, 100, 10 };
+	for (auto power = powers.begin(); power != powers.end(); ++power) {
+		stream << "MVI B, 0\n";
+
+		// The highest digit of word is 6
+		for (unsigned int weight = (*power == 10000) ? 4 : 8; weight > 0; weight /= 2) {
+			const unsigned int value = weight * *power;
+			const std::string skip = name + "S" + std::to_string(value);
+
+			stream << "MOV A, L\n";
+			stream << "SUI " << (value & 0xFF) << '\n';
+			stream << "MOV E, A\n";
+			stream << "MOV A, H\n";
+			stream << "SBI " << (value >> 8) << '\n';
+			stream << "JC " << skip << '\n';
+			stream << "MOV H, A\n";
+			stream << "MOV L, E\n";
+			stream << "MOV A, B\n";
+			stream << "ADI " << weight << '\n';
+			stream << "MOV B, A\n";
+			stream << skip << ":\n";
+		}
+
+		const std::string skip = name + "Z" + std::to_string(*power);
+		stream << "MOV A, B\n";
+		stream << "ORA C\n";
+		stream << "JZ " << skip << '\n';
+		stream << "MOV A, B\n";
+		stream << "ADI '0'\n";
+		stream << "OUT " << CONSOLE_PORT << '\n';
+		stream << "MOV C, A\n";
+		stream << skip << ":\n";
+	}
+
+	stream << "MOV A, L\n";
+	stream << "ADI '0'\n";
+	stream << "OUT " << CONSOLE_PORT << '\n';
+	stream << "POP D\n";
+	stream << "RET\n";
+}
+
+void Runtime::_generateNegate(CodeWriter& stream, const std::string& high, const std::string& low)
+{
+	// Two's complement: bits are inverted and one is added
+	stream << "MOV A, " << low << '\n';
+	stream << "CMA\n";
+	stream << "MOV " << low << ", A\n";
+	stream << "MOV A, " << high << '\n';
+	stream << "CMA\n";
+	stream << "MOV " << high << ", A\n";
+	stream << "INX " << high << '\n';
+}
+
+void Runtime::_generatePrint(CodeWriter& stream)
+{
+	stream << PRINT << ":\n";
+	stream << "MOV A, M\n";
+	stream << "ORA A\n";
+	stream << "RZ\n";
+	stream << "OUT " << CONSOLE_PORT << '\n';
+	stream << "INX H\n";
+	stream << "JMP " << PRINT << '\n';
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <map>
+#include <set>
+#include <string>
+#include "..\Emission\CodeWriter.h"
+
+// i8080 runtime library linked into generated code. Routines except @PRINT have no loops,
+// so documented cycles are static upper bounds: sum of all instructions of routine, with
+// conditional ones taken at their longest. No run takes every branch, so the bounds are
+// conservative. Cycles of CALL are not included
+class Runtime {
+public:
+	// A = A * B, clobbers B, H, L. At most 304 cycles
+	static const std::string MUL;
+
+	// HL = HL * DE, clobbers A, B, C, D, E. At most 798 cycles
+	static const std::string MUL16;
+
+	// A = A / B, H = A % B, unsigned. Division by zero gives 255 and dividend.
+	// Clobbers B, H, L. At most 451 cycles
+	static const std::string DIV;
+
+	// HL = HL / DE, BC = HL % DE, signed, quotient is truncated toward zero. Division by
+	// zero gives -1 (1 for negative dividend) and dividend. Clobbers A, D, E. At most 2014 cycles
+	static const std::string DIV16;
+
+	// Prints A as unsigned decimal number, clobbers B, H, L. At most 365 cycles
+	static const std::string PRINT_NUMBER;
+
+	// Prints HL as signed decimal number, clobbers B, C, H, L. At most 1331 cycles
+	static const std::string PRINT_NUMBER16;
+
+	// Prints zero terminated string at HL, clobbers A, H, L. At most 47 cycles per character
+	// (including terminator)
+	static const std::string PRINT;
+
+	// Port of console output
+	static const unsigned int CONSOLE_PORT = 1;
+
+	// Generates code of given routines
+	static void generate(CodeWriter& stream, const std::set<std::string>& routines);
+
+	// Generates entry point which sets up stack and calls main, followed by given routines
+	static void generateEntry(CodeWriter& stream, const std::set<std::string>& routines);
+
+	// Returns documented upper bound of cycles of routine (of single character for @PRINT)
+	static unsigned int worstCase(const std::string& routine);
+
+private:
+	static void _generateMul(CodeWriter& stream);
+	static void _generateMul16(CodeWriter& stream);
+	static void _generateDiv(CodeWriter& stream);
+	static void _generateDiv16(CodeWriter& stream);
+	static void _generatePrintNumber(CodeWriter& stream);
+	static void _generatePrintNumber16(CodeWriter& stream);
+	static void _generatePrint(CodeWriter& stream);
+
+	// Negates word in given pair, clobbers A
+	static void _generateNegate(CodeWriter& stream, const std::string& high, const std::string& low);
+};
@@ -0,0 +1,114 @@
+#include <iterator>
+#include "BinaryStream.h"
+
+void BinaryWriter::writeUnsigned(uint64_t value)
+{
+	while (value >= 0x80) {
+		_data += (char)((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	_data += (char)value;
+}
+
+void BinaryWriter::writeInt(const int64_t value)
+{
+	writeUnsigned(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void BinaryWriter::writeBool(const bool value)
+{
+	_data += (char)(value ? 1 : 0);
+}
+
+void BinaryWriter::writeString(const std::string& value)
+{
+	writeUnsigned(value.size());
+	_data += value;
+}
+
+const std::string& BinaryWriter::data() const
+{
+	return _data;
+}
+
+void BinaryWriter::flush(std::ostream& stream) const
+{
+	stream.write(_data.data(), _data.size());
+}
+
+BinaryReader::BinaryReader(std::istream& stream)
+{
+	// Size of seekable streams is known, so data is read by one call
+	std::streampos start = stream.tellg();
+	if (start != std::streampos(-1) && stream.seekg(0, std::ios::end)) {
+		std::streamoff size = stream.tellg() - start;
+		stream.seekg(start);
+		_data.resize((size_t)size);
+		stream.read(&_data[0], size);
+		_data.resize((size_t)stream.gcount());
+		return;
+	}
+
+	stream.clear();
+	_data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+BinaryReader::BinaryReader(const std::string& data) : _data(data)
+{
+}
+
+uint64_t BinaryReader::readUnsigned()
+{
+	uint64_t value = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		if (_position >= _data.size()) {
+			throw FormatError("Unexpected end of data");
+		}
+
+		const unsigned char byte = _data[_position++];
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return value;
+		}
+	}
+
+	throw FormatError("Number is too long");
+}
+
+int64_t BinaryReader::readInt()
+{
+	const uint64_t value = readUnsigned();
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+bool BinaryReader::readBool()
+{
+	return readBounded(2, "boolean") != 0;
+}
+
+std::string BinaryReader::readString()
+{
+	const uint64_t size = readUnsigned();
+	if (size > _data.size() - _position) {
+		throw FormatError("Unexpected end of data");
+	}
+
+	std::string value = _data.substr(_position, (size_t)size);
+	_position += (size_t)size;
+	return value;
+}
+
+unsigned int BinaryReader::readBounded(const uint64_t limit, const std::string& what)
+{
+	const uint64_t value = readUnsigned();
+	if (value >= limit) {
+		throw FormatError("Invalid " + what + " " + std::to_string(value));
+	}
+
+	return (unsigned int)value;
+}
+
+bool BinaryReader::atEnd() const
+{
+	return _position == _data.size();
+}
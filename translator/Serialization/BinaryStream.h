@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+// Thrown when binary data is truncated, corrupted or of other version
+class FormatError : public std::exception {
+public:
+	FormatError(const std::string text) : _text(text) {
+		_message = std::string("Format error: " + _text);
+	};
+
+	virtual const char* what() const throw() {
+		return _message.c_str();
+	}
+
+private:
+	const std::string _text;
+	std::string _message;
+};
+
+// Writes compact binary data to memory. Unsigned numbers are written as LEB128, so small ones
+// take a single byte, signed ones are zigzag encoded first
+class BinaryWriter {
+public:
+	void writeUnsigned(uint64_t value);
+	void writeInt(const int64_t value);
+	void writeBool(const bool value);
+
+	// Writes length followed by bytes of string
+	void writeString(const std::string& value);
+
+	const std::string& data() const;
+
+	// Writes all data to stream at once
+	void flush(std::ostream& stream) const;
+
+private:
+	std::string _data;
+};
+
+// Reads data written by BinaryWriter, throws FormatError if there's not enough of it
+class BinaryReader {
+public:
+	// Whole stream is read at once
+	BinaryReader(std::istream& stream);
+	BinaryReader(const std::string& data);
+
+	uint64_t readUnsigned();
+	int64_t readInt();
+	bool readBool();
+	std::string readString();
+
+	// Reads unsigned number which must be less than given limit, e.g. count or index
+	unsigned int readBounded(const uint64_t limit, const std::string& what);
+
+	bool atEnd() const;
+
+private:
+	std::string _data;
+	size_t _position = 0;
+};
@@ -0,0 +1,216 @@
+#include "TranslationServer.h"
+#include "..\Serialization\BinaryStream.h"
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <sstream>
+#include <exception>
+#include <condition_variable>
+
+TranslationServer::TranslationServer(const unsigned int workers) : _workers(workers > 0 ? workers : 1)
+{
+}
+
+unsigned int TranslationServer::serve(std::istream& input, std::ostream& output)
+{
+	// Requests waiting for worker, reading stops while workers are busy with enough of them
+	std::deque<Request> queue;
+	const size_t queueLimit = 2 * _workers;
+	bool finished = false;
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::mutex outputMutex;
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < _workers; ++i) {
+		workers.push_back(std::thread([&]() {
+			// Translator is created once and reset for every request
+			std::ostringstream errors;
+			Translator translator(nullptr, 0, errors);
+
+			while (true) {
+				Request request;
+				{
+					std::unique_lock<std::mutex> lock(queueMutex);
+					queueChanged.wait(lock, [&]() { return finished || !queue.empty(); });
+					if (queue.empty()) {
+						return;
+					}
+					request = std::move(queue.front());
+					queue.pop_front();
+				}
+				queueChanged.notify_all();
+
+				errors.str("");
+				const std::string payload = encodeResponse(translate(translator, request));
+
+				std::lock_guard<std::mutex> lock(outputMutex);
+				writeMessage(output, payload);
+				output.flush();
+			}
+		}));
+	}
+
+	unsigned int count = 0;
+	std::exception_ptr error;
+	try {
+		std::string payload;
+		while (readMessage(input, payload)) {
+			Request request = decodeRequest(payload);
+
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueChanged.wait(lock, [&]() { return queue.size() < queueLimit; });
+			queue.push_back(std::move(request));
+			++count;
+			lock.unlock();
+			queueChanged.notify_all();
+		}
+	}
+	catch (const FormatError&) {
+		error = std::current_exception();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		finished = true;
+	}
+	queueChanged.notify_all();
+
+	for (auto it = workers.begin(); it != workers.end(); ++it) {
+		it->join();
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	return count;
+}
+
+TranslationServer::Response TranslationServer::translate(Translator& translator, const Request& request)
+{
+	Response response;
+	response.id = request.id;
+
+	translator.reset(request.source.data(), request.source.size());
+	response.translated = translator.translate();
+
+	if (response.translated) {
+		if (request.optimize) {
+			translator.optimize();
+		}
+
+		std::ostringstream atoms;
+		translator.printAtoms(atoms);
+		response.atoms = atoms.str();
+
+		std::ostringstream code;
+		translator.generateCode(code);
+		response.code = code.str();
+	}
+
+	response.diagnostics = translator.diagnostics();
+	return response;
+}
+
+bool TranslationServer::readMessage(std::istream& stream, std::string& payload)
+{
+	unsigned char header[4];
+	stream.read((char*)header, sizeof(header));
+	if (stream.gcount() == 0 && stream.eof()) {
+		return false;
+	}
+	if (stream.gcount() != sizeof(header)) {
+		throw FormatError("Unexpected end of message header");
+	}
+
+	const uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+	if (size > MAX_MESSAGE_SIZE) {
+		throw FormatError("Message of " + std::to_string(size) + " bytes is too large");
+	}
+
+	payload.resize(size);
+	stream.read(&payload[0], size);
+	if ((uint32_t)stream.gcount() != size) {
+		throw FormatError("Unexpected end of message");
+	}
+
+	return true;
+}
+
+void TranslationServer::writeMessage(std::ostream& stream, const std::string& payload)
+{
+	const uint32_t size = (uint32_t)payload.size();
+	const char header[4] = { (char)(size & 0xFF), (char)((size >> 8) & 0xFF), (char)((size >> 16) & 0xFF), (char)(size >> 24) };
+
+	stream.write(header, sizeof(header));
+	stream.write(payload.data(), payload.size());
+}
+
+std::string TranslationServer::encodeRequest(const Request& request)
+{
+	BinaryWriter writer;
+	writer.writeUnsigned(request.id);
+	writer.writeBool(request.optimize);
+	writer.writeString(request.source);
+	return writer.data();
+}
+
+TranslationServer::Request TranslationServer::decodeRequest(const std::string& payload)
+{
+	BinaryReader reader(payload);
+	Request request;
+	request.id = reader.readUnsigned();
+	request.optimize = reader.readBool();
+	request.source = reader.readString();
+
+	if (!reader.atEnd()) {
+		throw FormatError("Excess data after request");
+	}
+
+	return request;
+}
+
+std::string TranslationServer::encodeResponse(const Response& response)
+{
+	BinaryWriter writer;
+	writer.writeUnsigned(response.id);
+	writer.writeBool(response.translated);
+
+	writer.writeUnsigned(response.diagnostics.size());
+	for (auto it = response.diagnostics.begin(); it != response.diagnostics.end(); ++it) {
+		writer.writeUnsigned(it->position.line);
+		writer.writeUnsigned(it->position.column);
+		writer.writeString(it->message);
+	}
+
+	writer.writeString(response.atoms);
+	writer.writeString(response.code);
+	return writer.data();
+}
+
+TranslationServer::Response TranslationServer::decodeResponse(const std::string& payload)
+{
+	BinaryReader reader(payload);
+	Response response;
+	response.id = reader.readUnsigned();
+	response.translated = reader.readBool();
+
+	const uint64_t count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		Translator::Diagnostic diagnostic;
+		diagnostic.position.line = (unsigned int)reader.readUnsigned();
+		diagnostic.position.column = (unsigned int)reader.readUnsigned();
+		diagnostic.message = reader.readString();
+		response.diagnostics.push_back(diagnostic);
+	}
+
+	response.atoms = reader.readString();
+	response.code = reader.readString();
+
+	if (!reader.atEnd()) {
+		throw FormatError("Excess data after response");
+	}
+
+	return response;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include "..\Translator\Translator.h"
+
+// Serves translation requests read from stream. Every message is 4 byte little-endian length
+// followed by payload in binary form. Requests are processed concurrently by pool of workers,
+// every worker reuses its translator, so responses may come in other order than requests
+class TranslationServer {
+public:
+	// Source to translate, id is returned in response
+	struct Request {
+		uint64_t id = 0;
+		bool optimize = true;
+		std::string source;
+	};
+
+	// Result of translation, atoms and code are empty if translation failed
+	struct Response {
+		uint64_t id = 0;
+		bool translated = false;
+		std::vector<Translator::Diagnostic> diagnostics;
+		std::string atoms;
+		std::string code;
+	};
+
+	// Messages larger than this are rejected
+	static const uint32_t MAX_MESSAGE_SIZE = 64 * 1024 * 1024;
+
+	TranslationServer(const unsigned int workers);
+
+	// Serves requests till the end of input, returns count of them. Throws FormatError if
+	// message is malformed, requests read before it are served
+	unsigned int serve(std::istream& input, std::ostream& output);
+
+	// Translates single request by given translator
+	static Response translate(Translator& translator, const Request& request);
+
+	// Reads message, returns false at the end of input
+	static bool readMessage(std::istream& stream, std::string& payload);
+	static void writeMessage(std::ostream& stream, const std::string& payload);
+
+	static std::string encodeRequest(const Request& request);
+	static Request decodeRequest(const std::string& payload);
+	static std::string encodeResponse(const Response& response);
+	static Response decodeResponse(const std::string& payload);
+
+private:
+	const unsigned int _workers;
+};
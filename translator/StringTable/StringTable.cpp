@@ -14,13 +14,43 @@ std::shared_ptr<StringOperand> StringTable::insert(const std::string& str)
 	return std::make_shared<StringOperand>(_strings.size() - 1, this);
 }
 
-void StringTable::generateGlobalsSection(std::ostream & stream) const
+void StringTable::generateGlobalsSection(CodeWriter& stream) const
 {
 	for (unsigned int i = 0; i < _strings.size(); ++i) {
-		stream << "str" << i << ": DB '" << _strings[i] << "', 0" << std::endl;
+		stream << "str" << i << ": DB '" << _strings[i] << "', 0\n";
 	}
 }
 
+unsigned int StringTable::size() const
+{
+	return (unsigned int)_strings.size();
+}
+
+void StringTable::clear()
+{
+	_strings.clear();
+}
+
+void StringTable::save(BinaryWriter& writer) const
+{
+	writer.writeUnsigned(_strings.size());
+	for (auto it = _strings.begin(); it != _strings.end(); ++it) {
+		writer.writeString(*it);
+	}
+}
+
+void StringTable::load(BinaryReader& reader)
+{
+	std::vector<std::string> strings;
+	const uint64_t count = reader.readUnsigned();
+
+	for (uint64_t i = 0; i < count; ++i) {
+		strings.push_back(reader.readString());
+	}
+
+	_strings = std::move(strings);
+}
+
 const std::string& StringTable::operator[](const int index) const {
 	return _strings[index];
 }
@@ -3,6 +3,7 @@
 #include <vector>
 #include <memory>
 #include "..\Operand\Operand.h"
+#include "..\Serialization\BinaryStream.h"
 
 // Stores info about all string entities
 class StringTable {
@@ -11,7 +12,17 @@ public:
 	std::shared_ptr<StringOperand> insert(const std::string& str);
 
 	// Generates globals section with i8080 init code
-	void generateGlobalsSection(std::ostream& stream) const;
+	void generateGlobalsSection(CodeWriter& stream) const;
+
+	// Returns count of strings
+	unsigned int size() const;
+
+	// Removes all strings, memory is kept for the next translation
+	void clear();
+
+	// Writes all strings, load replaces strings of table with read ones
+	void save(BinaryWriter& writer) const;
+	void load(BinaryReader& reader);
 
 	const std::string& operator[](const int index) const;
 	friend std::ostream& operator<<(std::ostream& stream, const StringTable& table);
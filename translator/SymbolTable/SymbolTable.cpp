@@ -2,7 +2,7 @@
 #include <map>
 #include "SymbolTable.h"
 
-std::shared_ptr<MemoryOperand> SymbolTable::insertVar(const std::string & name, const Scope scope, const TableRecord::RecordType type, const unsigned int init)
+std::shared_ptr<MemoryOperand> SymbolTable::insertVar(const std::string & name, const Scope scope, const TableRecord::RecordType type, const unsigned int init, const SourcePosition& position)
 {
 	// Check if record exists in table
 	for (unsigned int i = 0; i < _records.size(); ++i) {
@@ -13,12 +13,13 @@ std::shared_ptr<MemoryOperand> SymbolTable::insertVar(const std::string & name,
 
 	// Record not found, insert
 	TableRecord record(name, TableRecord::RecordKind::var, type, -1, init, scope, 0);
+	record.position = position;
 
 	_records.push_back(record);
 	return std::make_shared<MemoryOperand>(_records.size() - 1, this);
 }
 
-std::shared_ptr<MemoryOperand> SymbolTable::insertArray(const std::string & name, const Scope scope, const TableRecord::RecordType type, const unsigned int len)
+std::shared_ptr<MemoryOperand> SymbolTable::insertArray(const std::string & name, const Scope scope, const TableRecord::RecordType type, const unsigned int len, const SourcePosition& position)
 {
 	// Check if record exists in table
 	for (unsigned int i = 0; i < _records.size(); ++i) {
@@ -29,12 +30,13 @@ std::shared_ptr<MemoryOperand> SymbolTable::insertArray(const std::string & name
 
 	// Record not found, insert
 	TableRecord record(name, TableRecord::RecordKind::array, type, len, 0, scope, 0);
+	record.position = position;
 
 	_records.push_back(record);
 	return std::make_shared<MemoryOperand>(_records.size() - 1, this);
 }
 
-std::shared_ptr<MemoryOperand> SymbolTable::insertFunc(const std::string & name, const TableRecord::RecordType type, const int len)
+std::shared_ptr<MemoryOperand> SymbolTable::insertFunc(const std::string & name, const TableRecord::RecordType type, const int len, const SourcePosition& position)
 {
 	// Check if record exists in table
 	for (unsigned int i = 0; i < _records.size(); ++i) {
@@ -45,6 +47,7 @@ std::shared_ptr<MemoryOperand> SymbolTable::insertFunc(const std::string & name,
 
 	// Record not found, insert
 	TableRecord record(name, TableRecord::RecordKind::func, type, len, 0, SymbolTable::GLOBAL_SCOPE, 0);
+	record.position = position;
 
 	_records.push_back(record);
 	return std::make_shared<MemoryOperand>(_records.size() - 1, this);
@@ -119,11 +122,11 @@ bool SymbolTable::changeArgsCount(const int index, const int len)
 	return true;
 }
 
-std::shared_ptr<MemoryOperand> SymbolTable::alloc(Scope scope)
+std::shared_ptr<MemoryOperand> SymbolTable::alloc(Scope scope, const TableRecord::RecordType type)
 {
 	_records.push_back(TableRecord("[tmp" + std::to_string(_records.size()) + "]",
 		TableRecord::RecordKind::var,
-		TableRecord::RecordType::integer,
+		type,
 		-1, 0, scope));
 	return std::make_shared<MemoryOperand>(_records.size() - 1, this);
 }
@@ -133,7 +136,7 @@ unsigned int SymbolTable::getLocalsCount(const Scope scope) const
 	unsigned int vars = 0;
 
 	for (auto it = _records.begin(); it != _records.end(); ++it) {
-		if (it->scope == scope && it->kind == TableRecord::RecordKind::var){
+		if (it->scope == scope && it->kind == TableRecord::RecordKind::var && it->hasSlot){
 			vars++;
 		}
 	}
@@ -145,13 +148,30 @@ void SymbolTable::calculateOffset()
 {
 	std::map<const Scope, unsigned int> counts;
 	std::map<const Scope, unsigned int> arraysOffsets;
+
+	// Parts of frames are counted once, so long functions don't take quadratic time
+	std::map<const Scope, unsigned int> slots;
+	std::map<const Scope, unsigned int> arraysSizes;
+	for (auto it = _records.begin(); it != _records.end(); ++it) {
+		if (it->kind == TableRecord::RecordKind::var && it->hasSlot) {
+			slots[it->scope]++;
+		}
+		else if (it->kind == TableRecord::RecordKind::array) {
+			arraysSizes[it->scope] += it->len;
+		}
+	}
+	auto localsCount = [&](const Scope scope) { return slots[scope] - _records[scope].len; };
+
 	unsigned int i = 0;
 	for (auto it = _records.begin(); it != _records.end(); ++it, ++i) {
 
-		if (it->kind == TableRecord::RecordKind::var && it->scope != SymbolTable::GLOBAL_SCOPE) {
+		if (it->kind == TableRecord::RecordKind::var && it->scope != SymbolTable::GLOBAL_SCOPE && !it->hasSlot) {
+			it->offset = -1;
+		}
+		else if (it->kind == TableRecord::RecordKind::var && it->scope != SymbolTable::GLOBAL_SCOPE) {
 			unsigned int n = _records[it->scope].len;
-			unsigned int m = getLocalsCount(it->scope);
-			unsigned int arrays = getArraysSize(it->scope);
+			unsigned int m = localsCount(it->scope);
+			unsigned int arrays = arraysSizes[it->scope];
 
 			unsigned int j = 1;
 
@@ -170,13 +190,13 @@ void SymbolTable::calculateOffset()
 		}
 		else if (it->kind == TableRecord::RecordKind::func) {
 			unsigned int n = _records[i].len;
-			unsigned int m = getLocalsCount(i);
-			unsigned int arrays = getArraysSize(i);
+			unsigned int m = localsCount(i);
+			unsigned int arrays = arraysSizes[i];
 			it->offset = 2 * (m + n + 1) + 2 * arrays;
 		}
 		else if (it->kind == TableRecord::RecordKind::array && it->scope != SymbolTable::GLOBAL_SCOPE) {
 			if (arraysOffsets.find(it->scope) == arraysOffsets.end()) {
-				arraysOffsets[it->scope] = getLocalsCount(it->scope) * 2;
+				arraysOffsets[it->scope] = localsCount(it->scope) * 2;
 			}
 
 			it->offset = arraysOffsets[it->scope];
@@ -185,14 +205,15 @@ void SymbolTable::calculateOffset()
 	}
 }
 
-void SymbolTable::generateGlobalsSection(std::ostream & stream) const
+void SymbolTable::generateGlobalsSection(CodeWriter& stream) const
 {
 	for (unsigned int i = 0; i < _records.size(); ++i) {
 		if (_records[i].scope == SymbolTable::GLOBAL_SCOPE && _records[i].kind == SymbolTable::TableRecord::RecordKind::var) {
-			stream << "var" << i << ": DB " << _records[i].init << std::endl;
+			const bool wide = _records[i].type == SymbolTable::TableRecord::RecordType::integer;
+			stream << "var" << i << (wide ? ": DW " : ": DB ") << _records[i].init << '\n';
 		}
 		else if (_records[i].scope == SymbolTable::GLOBAL_SCOPE && _records[i].kind == SymbolTable::TableRecord::RecordKind::array) {
-			stream << "ARR" << i << ": DS " << _records[i].len * 2 << std::endl;
+			stream << "ARR" << i << ": DS " << _records[i].len * 2 << '\n';
 		}
 	}
 }
@@ -223,6 +244,105 @@ std::vector<unsigned int> SymbolTable::functionsIds() const
 	return result;
 }
 
+void SymbolTable::setType(const int index, const TableRecord::RecordType type)
+{
+	_records[index].type = type;
+}
+
+void SymbolTable::setRegister(const int index, const Register reg)
+{
+	_records[index].reg = reg;
+}
+
+void SymbolTable::releaseSlot(const int index)
+{
+	_records[index].hasSlot = false;
+}
+
+std::vector<unsigned int> SymbolTable::localsIds(const Scope scope) const
+{
+	std::vector<unsigned int> result;
+
+	for (unsigned int i = 0; i < _records.size(); ++i) {
+		if (_records[i].scope == scope && _records[i].kind == TableRecord::RecordKind::var) {
+			result.push_back(i);
+		}
+	}
+
+	return result;
+}
+
+std::vector<unsigned int> SymbolTable::parametersIds(const Scope scope) const
+{
+	std::vector<unsigned int> result;
+
+	for (unsigned int i = 0; i < _records.size() && result.size() < (unsigned int)_records[scope].len; ++i) {
+		if (_records[i].scope == scope && _records[i].kind == TableRecord::RecordKind::var) {
+			result.push_back(i);
+		}
+	}
+
+	return result;
+}
+
+unsigned int SymbolTable::size() const
+{
+	return (unsigned int)_records.size();
+}
+
+void SymbolTable::clear()
+{
+	_records.clear();
+}
+
+void SymbolTable::save(BinaryWriter& writer) const
+{
+	writer.writeUnsigned(_records.size());
+
+	for (auto it = _records.begin(); it != _records.end(); ++it) {
+		writer.writeString(it->name);
+		writer.writeUnsigned((unsigned int)it->kind);
+		writer.writeUnsigned((unsigned int)it->type);
+		writer.writeInt(it->len);
+		writer.writeInt(it->init);
+		writer.writeInt(it->scope);
+		writer.writeInt(it->offset);
+		writer.writeUnsigned((unsigned int)it->reg);
+		writer.writeBool(it->hasSlot);
+		writer.writeUnsigned(it->position.line);
+		writer.writeUnsigned(it->position.column);
+	}
+}
+
+void SymbolTable::load(BinaryReader& reader)
+{
+	std::vector<TableRecord> records;
+	const uint64_t count = reader.readUnsigned();
+
+	for (uint64_t i = 0; i < count; ++i) {
+		TableRecord record;
+		record.name = reader.readString();
+		record.kind = (TableRecord::RecordKind)reader.readBounded(4, "record kind");
+		record.type = (TableRecord::RecordType)reader.readBounded(3, "record type");
+		record.len = (int)reader.readInt();
+		record.init = (int)reader.readInt();
+		record.scope = (Scope)reader.readInt();
+		record.offset = (int)reader.readInt();
+		record.reg = (Register)reader.readBounded(7, "register");
+		record.hasSlot = reader.readBool();
+		record.position.line = (unsigned int)reader.readUnsigned();
+		record.position.column = (unsigned int)reader.readUnsigned();
+
+		// Scope is either global or index of function
+		if (record.scope != GLOBAL_SCOPE && (record.scope < 0 || (uint64_t)record.scope >= count)) {
+			throw FormatError("Invalid scope " + std::to_string(record.scope));
+		}
+		records.push_back(record);
+	}
+
+	_records = std::move(records);
+}
+
 const SymbolTable::TableRecord & SymbolTable::operator[](const int index) const
 {
 	return _records[index];
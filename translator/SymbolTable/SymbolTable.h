@@ -4,6 +4,8 @@
 #include <iostream>
 #include <string>
 #include "..\Operand\Operand.h"
+#include "..\LexicalAnalyzer\Token.h"
+#include "..\Serialization\BinaryStream.h"
 
 typedef int Scope;
 
@@ -43,20 +45,27 @@ public:
 		int init;
 		Scope scope;
 		int offset;
+		// Register holding variable instead of its frame slot
+		Register reg = Register::none;
+		// Variables which are not accessed through frame don't take slot in it
+		bool hasSlot = true;
+		// Position of declaration in source, temporaries have none
+		SourcePosition position;
 
 		bool operator==(const TableRecord& other);
 	};
 
 	// Inserts new variable into the table. If var with given name and scope exists, returns nullptr
 	std::shared_ptr<MemoryOperand> insertVar(const std::string& name, const Scope scope,
-		const TableRecord::RecordType type, const unsigned int init = 0);
+		const TableRecord::RecordType type, const unsigned int init = 0, const SourcePosition& position = SourcePosition());
 
 	// Inserts new array into the table. If array with given name and scope exists, returns nullptr
 	std::shared_ptr<MemoryOperand> insertArray(const std::string& name, const Scope scope,
-		const TableRecord::RecordType type, const unsigned int len);
+		const TableRecord::RecordType type, const unsigned int len, const SourcePosition& position = SourcePosition());
 
 	// Inserts new function into the table. If var or function with given name exists, returns nullptr
-	std::shared_ptr<MemoryOperand> insertFunc(const std::string& name, const TableRecord::RecordType type, const int len);
+	std::shared_ptr<MemoryOperand> insertFunc(const std::string& name, const TableRecord::RecordType type, const int len,
+		const SourcePosition& position = SourcePosition());
 
 	// Find variable in given scope. If there's no var, returns nullptr
 	std::shared_ptr<MemoryOperand> checkVar(const Scope scope, const std::string& name);
@@ -71,7 +80,8 @@ public:
 	bool changeArgsCount(const int index, const int len);
 
 	// Allocate record for temporary variable
-	std::shared_ptr<MemoryOperand> alloc(Scope scope);
+	std::shared_ptr<MemoryOperand> alloc(Scope scope,
+		const TableRecord::RecordType type = TableRecord::RecordType::integer);
 
 	// Counts locals and temp variables with given scope
 	unsigned int getLocalsCount(const Scope scope) const;
@@ -80,15 +90,40 @@ public:
 	void calculateOffset();
 
 	// Generates global section with vars init
-	void generateGlobalsSection(std::ostream& stream) const;
+	void generateGlobalsSection(CodeWriter& stream) const;
 
 	// Sums len of arrays in given scope
 	unsigned int getArraysSize(const Scope scope) const;
 
+	// Changes type of variable, e.g. narrows temporary to char
+	void setType(const int index, const TableRecord::RecordType type);
+
+	// Places variable into given register
+	void setRegister(const int index, const Register reg);
+
+	// Removes slot of variable from frame, offsets have to be recalculated
+	void releaseSlot(const int index);
+
+	// Returns indexes of variables of given function (including params)
+	std::vector<unsigned int> localsIds(const Scope scope) const;
+
+	// Returns indexes of parameters of given function in declaration order
+	std::vector<unsigned int> parametersIds(const Scope scope) const;
+
 	// Returns names all of functions in string table
 	std::vector<std::string> functionNames() const;
 	std::vector<unsigned int> functionsIds() const;
 
+	// Returns count of records
+	unsigned int size() const;
+
+	// Removes all records, memory is kept for the next translation
+	void clear();
+
+	// Writes all records, load replaces records of table with read ones
+	void save(BinaryWriter& writer) const;
+	void load(BinaryReader& reader);
+
 	const TableRecord& operator[](const int index) const;
 	friend std::ostream& operator<<(std::ostream& stream, const SymbolTable& table);
 private:
@@ -18,6 +18,11 @@ const LexicalToken & LexemHistory::get(unsigned int index) const
 	return _list[index];
 }
 
+void LexemHistory::clear()
+{
+	_list.clear();
+}
+
 const std::vector<LexicalToken> LexemHistory::getAll() const
 {
 	return std::vector<LexicalToken>(_list.begin(), _list.end());
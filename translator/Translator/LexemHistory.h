@@ -16,6 +16,9 @@ public:
 
 	// Gets vector of all lexems
 	const std::vector<LexicalToken> getAll() const;
+
+	// Removes all lexems
+	void clear();
 private:
 	// Max list size
 	const unsigned int _size;
@@ -1,12 +1,85 @@
 #include "Translator.h"
 #include "Exception.h"
+#include "..\Runtime\Runtime.h"
 #include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+namespace {
+	// Tags of atoms and operands in saved state
+	enum class AtomTag { simpleBinaryOp, fnBinaryOp, unaryOp, simpleJump, complexJump, out, in, label, jump, switchOp, call, ret, param };
+	enum class OperandTag { none, memory, element, number, string };
+
+	const std::string STATE_MAGIC = "MINIC-STATE";
+
+	// Casts loaded operand to type required by atom
+	template<typename T>
+	std::shared_ptr<T> expectOperand(const std::shared_ptr<Operand> operand, const bool optional = false)
+	{
+		std::shared_ptr<T> result = std::dynamic_pointer_cast<T>(operand);
+		if (result == nullptr && !(optional && operand == nullptr)) {
+			throw FormatError("Unexpected operand");
+		}
+
+		return result;
+	}
+}
 
-Translator::Translator(std::istream & stream, std::ostream& errStream) : _lexicalAnalyzer(LexicalScanner(stream)), _currentLexem(nullptr),
+Translator::Translator(std::istream & stream, std::ostream& errStream) : _lexicalAnalyzer(stream), _currentLexem(nullptr),
 _currentLabelId(0), _errStream(errStream), _lexemHistory(LexemHistory(4)) {
 	_getNextLexem();
 }
 
+Translator::Translator(const char* source, const size_t size, std::ostream& errStream) : _lexicalAnalyzer(source, size),
+_currentLexem(nullptr), _currentLabelId(0), _errStream(errStream), _lexemHistory(LexemHistory(4)) {
+	_getNextLexem();
+}
+
+void Translator::reset(std::istream& stream)
+{
+	_lexicalAnalyzer.reset(stream);
+	_restart();
+}
+
+void Translator::reset(const char* source, const size_t size)
+{
+	_lexicalAnalyzer.reset(source, size);
+	_restart();
+}
+
+Translator::NestingGuard::NestingGuard(Translator& translator) : _translator(translator)
+{
+	if (++_translator._depth > _translator._maxDepth) {
+		--_translator._depth;
+		_translator.throwSyntaxError("Nesting depth exceeds limit of " + std::to_string(_translator._maxDepth));
+	}
+}
+
+Translator::NestingGuard::~NestingGuard()
+{
+	--_translator._depth;
+}
+
+void Translator::setMaxDepth(const unsigned int depth)
+{
+	_maxDepth = depth;
+}
+
+void Translator::setExpressionParser(const ExpressionParser parser)
+{
+	_expressionParser = parser;
+}
+
+void Translator::setSeparateCompilation(const bool separate)
+{
+	_separateCompilation = separate;
+}
+
+void Translator::setCache(CompilationCache* cache)
+{
+	_cache = cache;
+}
+
 void Translator::printAtoms(std::ostream & stream, const unsigned int width) const
 {
 	for (auto context = _atoms.begin(); context != _atoms.end(); ++context) {
@@ -31,8 +104,27 @@ void Translator::printStringTable(std::ostream & stream) const
 	stream << _stringTable;
 }
 
+void Translator::printOptimizationStatistics(std::ostream & stream) const
+{
+	stream << "OPTIMIZATIONS:" << std::endl;
+	for (auto it = _optimizationStatistics.begin(); it != _optimizationStatistics.end(); ++it) {
+		stream << it->first << " " << it->second << std::endl;
+	}
+}
+
+const std::vector<std::unique_ptr<Atom>>& Translator::atoms(const Scope scope) const
+{
+	return _atoms.at(scope);
+}
+
+const SymbolTable& Translator::symbolTable() const
+{
+	return _symbolTable;
+}
+
 void Translator::generateAtom(std::unique_ptr<Atom> atom, Scope scope)
 {
+	atom->setPosition(_statementPosition);
 	_atoms[scope].push_back(std::move(atom));
 }
 
@@ -77,6 +169,11 @@ void Translator::throwLexicalError(const std::string & text) const
 
 bool Translator::translate()
 {
+	// The first lexem of source given to reset is wrong
+	if (!_diagnostics.empty()) {
+		return false;
+	}
+
 	try {
 		StmtList(SymbolTable::GLOBAL_SCOPE);
 
@@ -86,41 +183,333 @@ bool Translator::translate()
 		}
 
 		std::shared_ptr<MemoryOperand> m = _symbolTable.checkFunc("main", 0);
-		if (!m) {
+		if (!m && !_separateCompilation) {
 			throwSyntaxError("No entry point for given program");
 		}
-
-		_symbolTable.calculateOffset();
-
-		return true;
 	}
 	catch (const LexicalError& error) {
-		_errStream << error.what();
-		return false;
+		_report(error);
 	}
 	catch (const SyntaxError&  error) {
-		_errStream << error.what();
+		_report(error);
+	}
+
+	// Functions without body are defined by other modules. Body of function may be missing
+	// because of other errors too, so it's checked only after successful translation
+	if (!_separateCompilation && _diagnostics.empty()) {
+		std::vector<unsigned int> fns = _symbolTable.functionsIds();
+		for (auto it = fns.begin(); it != fns.end(); ++it) {
+			if (_atoms.count(*it) == 0) {
+				_report(SyntaxError("Function " + _symbolTable[*it].name + " is declared but not defined"), _symbolTable[*it].position);
+			}
+		}
+	}
+
+	if (!_diagnostics.empty()) {
 		return false;
 	}
+
+	_symbolTable.calculateOffset();
+	_computeFunctionKeys();
+
+	return true;
+}
+
+const std::vector<Translator::Diagnostic>& Translator::diagnostics() const
+{
+	return _diagnostics;
+}
+
+void Translator::optimize()
+{
+	if (!_diagnostics.empty()) {
+		return;
+	}
+
+	Optimizer optimizer(_atoms, _symbolTable);
+	std::vector<unsigned int> fns = _definedFunctions();
+	_optimized = true;
+
+	// Turning tail recursion into loops may make function a leaf, so it goes before inlining
+	for (auto it = fns.begin(); it != fns.end(); ++it) {
+		optimizer.eliminateTailRecursion(*it, [this]() { return newLabel(); });
+	}
+
+	for (auto it = fns.begin(); it != fns.end(); ++it) {
+		optimizer.inlineCalls(*it, [this]() { return newLabel(); });
+	}
+
+	// Passes above are done for cached functions too, so labels of others don't change.
+	// Code of cached functions is resolved against symbols at this point
+	unsigned int reused = 0;
+	for (auto it = fns.begin(); it != fns.end(); ++it) {
+		_functionSymbols[*it] = _collectSymbols(*it);
+	}
+
+	for (auto it = fns.begin(); it != fns.end(); ++it) {
+		if (_cache != nullptr && _cache->contains(_cacheKey(*it))) {
+			++reused;
+			continue;
+		}
+
+		optimizer.hoistLoopInvariants(*it);
+		optimizer.reduceInductionMultiplications(*it);
+		optimizer.eliminateCommonSubexpressions(*it);
+		optimizer.propagateCopies(*it);
+		optimizer.eliminateDeadCode(*it);
+		optimizer.inferTypes(*it);
+
+		// Must be the last passes, they depend on final atoms
+		optimizer.allocateRegisters(*it);
+		optimizer.releaseFrameSlots(*it);
+	}
+
+	_optimizationStatistics = optimizer.statistics();
+	if (reused > 0) {
+		_optimizationStatistics["cache: reused functions"] = reused;
+	}
+
+	// Optimizations may allocate new temporaries
+	_symbolTable.calculateOffset();
 }
 
 void Translator::generateCode(std::ostream & stream) const
 {
-	stream << "ORG 8000H" << std::endl;
-	_symbolTable.generateGlobalsSection(stream);
-	_stringTable.generateGlobalsSection(stream);
-	_generateProlog(stream);
+	if (!_diagnostics.empty()) {
+		return;
+	}
 
-	std::vector<unsigned int> fns = _symbolTable.functionsIds();
+	std::vector<unsigned int> fns = _definedFunctions();
+	std::vector<std::string> code(fns.size());
+	std::vector<std::string> tables(fns.size());
+	std::set<std::string> routines;
+	size_t size = 0;
+
+	for (unsigned int i = 0; i < fns.size(); ++i) {
+		_generateFunction(fns[i], code[i], tables[i], routines);
+		size += code[i].size() + tables[i].size();
+	}
+
+	// Program is collected in memory and written to stream at once
+	CodeWriter program;
+	program.reserve(size);
+	program << "ORG 8000H\n";
+	_symbolTable.generateGlobalsSection(program);
+	_stringTable.generateGlobalsSection(program);
+
+	// Jump tables of switches
+	for (auto it = tables.begin(); it != tables.end(); ++it) {
+		program << *it;
+	}
+
+	Runtime::generateEntry(program, routines);
+
+	for (auto it = code.begin(); it != code.end(); ++it) {
+		program << *it;
+	}
+
+	program.flush(stream);
+}
+
+ModuleObject Translator::generateObject(const std::string& name) const
+{
+	ModuleObject object;
+	object.name = name;
+
+	if (!_diagnostics.empty()) {
+		return object;
+	}
+
+	// Labels and strings keep their numbers within module, globals are referred by name
+	CompilationCache::Symbols symbols;
+	for (unsigned int i = 0; i < _currentLabelId; ++i) {
+		symbols.labels.push_back(i);
+	}
+	for (unsigned int i = 0; i < _stringTable.size(); ++i) {
+		symbols.strings.push_back(i);
+		object.strings.push_back(_stringTable[i]);
+	}
+
+	for (unsigned int i = 0; i < _symbolTable.size(); ++i) {
+		const SymbolTable::TableRecord& record = _symbolTable[i];
+		if (record.scope != SymbolTable::GLOBAL_SCOPE) {
+			continue;
+		}
+
+		if (record.kind == SymbolTable::TableRecord::RecordKind::func) {
+			ModuleObject::Function function = { record.name, record.type, {} };
+			std::vector<unsigned int> params = _symbolTable.parametersIds(i);
+			for (auto it = params.begin(); it != params.end(); ++it) {
+				function.params.push_back(_symbolTable[*it].type);
+			}
 
+			if (_atoms.count(i) > 0) {
+				object.exports.push_back(function);
+			}
+			else {
+				object.imports.push_back(function);
+			}
+		}
+		else {
+			object.globals.push_back({ record.name, record.kind, record.type, record.len, record.init });
+			symbols.globals[i] = record.name;
+		}
+	}
+
+	std::string code;
+	std::string tables;
+	std::vector<unsigned int> fns = _definedFunctions();
 	for (auto it = fns.begin(); it != fns.end(); ++it) {
-		_generateFunctionCode(stream, *it);
+		std::string functionCode;
+		std::string functionTables;
+		_generateFunction(*it, functionCode, functionTables, object.routines);
+		code += functionCode;
+		tables += functionTables;
+	}
+
+	object.code = CompilationCache::relocate(code, symbols);
+	object.tables = CompilationCache::relocate(tables, symbols);
+	object.labels = _currentLabelId;
+
+	return object;
+}
+
+void Translator::save(std::ostream& stream) const
+{
+	BinaryWriter writer;
+	writer.writeString(STATE_MAGIC);
+	writer.writeUnsigned(STATE_VERSION);
+
+	writer.writeUnsigned(_currentLabelId);
+	writer.writeBool(_optimized);
+
+	writer.writeUnsigned(_diagnostics.size());
+	for (auto it = _diagnostics.begin(); it != _diagnostics.end(); ++it) {
+		writer.writeUnsigned(it->position.line);
+		writer.writeUnsigned(it->position.column);
+		writer.writeString(it->message);
+	}
+
+	_stringTable.save(writer);
+	_symbolTable.save(writer);
+
+	writer.writeUnsigned(_atoms.size());
+	for (auto scope = _atoms.begin(); scope != _atoms.end(); ++scope) {
+		writer.writeInt(scope->first);
+		writer.writeUnsigned(scope->second.size());
+		for (auto it = scope->second.begin(); it != scope->second.end(); ++it) {
+			_saveAtom(writer, it->get());
+		}
+	}
+
+	// Keys are computed only if translation succeeded
+	writer.writeUnsigned(_functionHashes.size());
+	for (auto it = _functionHashes.begin(); it != _functionHashes.end(); ++it) {
+		writer.writeInt(it->first);
+		writer.writeUnsigned(it->second);
+	}
+
+	writer.writeUnsigned(_functionKeys.size());
+	for (auto it = _functionKeys.begin(); it != _functionKeys.end(); ++it) {
+		writer.writeInt(it->first);
+		writer.writeUnsigned(it->second);
+	}
+
+	writer.writeUnsigned(_functionSymbols.size());
+	for (auto it = _functionSymbols.begin(); it != _functionSymbols.end(); ++it) {
+		writer.writeInt(it->first);
+
+		writer.writeUnsigned(it->second.labels.size());
+		for (auto label = it->second.labels.begin(); label != it->second.labels.end(); ++label) {
+			writer.writeUnsigned(*label);
+		}
+
+		writer.writeUnsigned(it->second.strings.size());
+		for (auto str = it->second.strings.begin(); str != it->second.strings.end(); ++str) {
+			writer.writeUnsigned(*str);
+		}
+
+		writer.writeUnsigned(it->second.globals.size());
+		for (auto global = it->second.globals.begin(); global != it->second.globals.end(); ++global) {
+			writer.writeUnsigned(global->first);
+			writer.writeString(global->second);
+		}
+	}
+
+	writer.writeUnsigned(_optimizationStatistics.size());
+	for (auto it = _optimizationStatistics.begin(); it != _optimizationStatistics.end(); ++it) {
+		writer.writeString(it->first);
+		writer.writeUnsigned(it->second);
+	}
+
+	writer.flush(stream);
+}
+
+void Translator::load(std::istream& stream)
+{
+	BinaryReader reader(stream);
+
+	try {
+		_loadState(reader);
+	}
+	catch (const FormatError&) {
+		_clearState();
+		throw;
+	}
+}
+
+void Translator::_clearState()
+{
+	_atoms.clear();
+	_stringTable.clear();
+	_symbolTable.clear();
+	_paramsList.clear();
+	_diagnostics.clear();
+	_functionHashes.clear();
+	_functionKeys.clear();
+	_functionSymbols.clear();
+	_optimizationStatistics.clear();
+	_currentLabelId = 0;
+	_optimized = false;
+}
+
+void Translator::_restart()
+{
+	_clearState();
+
+	_currentLexem = nullptr;
+	_lexemHistory.clear();
+	_statementPosition = SourcePosition();
+	_depth = 0;
+	_hashing = false;
+	_lexemsHash = 0;
+	_lexemsCount = 0;
+	_openBraces = 0;
+
+	// Unlike constructor, reset doesn't throw, error is reported by translation
+	try {
+		_getNextLexem();
+	}
+	catch (const LexicalError& error) {
+		_report(error);
 	}
 }
 
 LexicalToken Translator::_getNextLexem()
 {
+	if (_hashing) {
+		_lexemsHash = CompilationCache::hash(_currentLexem->toString(), _lexemsHash);
+	}
+
+	if (_currentLexem && _currentLexem->type() == LexemType::lbrace) {
+		++_openBraces;
+	}
+	else if (_currentLexem && _currentLexem->type() == LexemType::rbrace && _openBraces > 0) {
+		--_openBraces;
+	}
+
 	_currentLexem = std::make_unique<LexicalToken>(_lexicalAnalyzer.getNextToken());
+	++_lexemsCount;
 	_lexemHistory.push(*_currentLexem);
 
 	if (_currentLexem->type() == LexemType::error) {
@@ -130,6 +519,48 @@ LexicalToken Translator::_getNextLexem()
 	return *_currentLexem;
 }
 
+void Translator::_report(const std::exception& error)
+{
+	_report(error, _currentLexem->position());
+}
+
+void Translator::_report(const std::exception& error, const SourcePosition& position)
+{
+	if (!_diagnostics.empty()) {
+		_errStream << std::endl;
+	}
+
+	_diagnostics.push_back({ position, error.what() });
+	_errStream << position.line << ":" << position.column << ": " << error.what();
+}
+
+void Translator::_synchronize(const unsigned int start, const unsigned int braces)
+{
+	while (true) {
+		LexemType type = _currentLexem->type();
+		if (type == LexemType::eof) {
+			return;
+		}
+
+		// Enclosing block goes on, at least one lexem must be skipped to avoid the same error
+		bool enclosing = _openBraces == braces && _lexemsCount != start;
+		if (enclosing && (type == LexemType::rbrace || type == LexemType::kwint || type == LexemType::kwchar)) {
+			return;
+		}
+
+		try {
+			_getNextLexem();
+		}
+		catch (const LexicalError& error) {
+			_report(error);
+		}
+
+		if (_openBraces == braces && (type == LexemType::semicolon || type == LexemType::rbrace)) {
+			return;
+		}
+	}
+}
+
 bool Translator::_takeTerm(LexemType type)
 {
 	if (_currentLexem->type() != type) {
@@ -140,6 +571,17 @@ bool Translator::_takeTerm(LexemType type)
 	return true;
 }
 
+void Translator::_checkIndex(const std::shared_ptr<MemoryOperand> array, const std::shared_ptr<RValue> index) const
+{
+	std::shared_ptr<NumberOperand> number = std::dynamic_pointer_cast<NumberOperand>(index);
+	const SymbolTable::TableRecord& record = _symbolTable[array->index()];
+
+	if (number != nullptr && (number->value() < 0 || number->value() >= record.len)) {
+		throwSyntaxError("Index " + std::to_string(number->value()) + " is out of bounds of array " + record.name
+			+ "[" + std::to_string(record.len) + "]");
+	}
+}
+
 unsigned int Translator::ArgList(const Scope context)
 {
 
@@ -149,43 +591,33 @@ unsigned int Translator::ArgList(const Scope context)
 		return 0;
 	}
 
-	std::shared_ptr<RValue> p = E(context);
-
-	if (!p) {
-		throwSyntaxError("Unknown param format");
-	}
-
-	unsigned int m = ArgList_(context);
-
-	generateAtom(std::make_unique<ParamAtom>(p, _paramsList), context);
-
-	return m + 1;
-}
-
-unsigned int Translator::ArgList_(const Scope context)
-{
-	if (_currentLexem->type() == LexemType::comma) {
-		_getNextLexem();
+	std::vector<std::shared_ptr<RValue>> args;
 
+	while (true) {
 		std::shared_ptr<RValue> p = E(context);
 
 		if (!p) {
 			throwSyntaxError("Unknown param format");
 		}
+		args.push_back(p);
 
-		unsigned int m = ArgList_(context);
-
-		generateAtom(std::make_unique<ParamAtom>(p, _paramsList), context);
+		if (_currentLexem->type() != LexemType::comma) {
+			break;
+		}
+		_getNextLexem();
+	}
 
-		return m + 1;
+	// Params are pushed from the last one
+	for (auto it = args.rbegin(); it != args.rend(); ++it) {
+		generateAtom(std::make_unique<ParamAtom>(*it, _paramsList), context);
 	}
 
-	return 0;
+	return args.size();
 }
 
 std::shared_ptr<RValue> Translator::translateExpresssion()
 {
-	return E7(SymbolTable::GLOBAL_SCOPE);
+	return E(SymbolTable::GLOBAL_SCOPE);
 }
 
 bool Translator::translateExpression(int)
@@ -203,11 +635,11 @@ bool Translator::translateExpression(int)
 		return true;
 	}
 	catch (const LexicalError& error) {
-		_errStream << error.what();
+		_report(error);
 		return false;
 	}
 	catch (const SyntaxError&  error) {
-		_errStream << error.what();
+		_report(error);
 		return false;
 	}
 }
@@ -304,6 +736,7 @@ std::shared_ptr<MemoryOperand> Translator::E1_(const Scope context, const std::s
 		if (!arr) {
 			throwSyntaxError(p + " is not an array.");
 		}
+		_checkIndex(arr, key);
 
 		return std::make_shared<ArrayElementOperand>(arr->index(), key, &_symbolTable);
 	}
@@ -350,7 +783,12 @@ std::shared_ptr<RValue> Translator::E3(const Scope context)
 
 std::shared_ptr<RValue> Translator::E3_(const Scope context, std::shared_ptr<RValue> p)
 {
-	if (_currentLexem->type() == LexemType::opmult) {
+	static const std::map<LexemType, std::string> operations = {
+		{ LexemType::opmult, "MUL" }, { LexemType::opdiv, "DIV" }, { LexemType::opmod, "MOD" }
+	};
+
+	if (operations.count(_currentLexem->type()) > 0) {
+		const std::string& name = operations.at(_currentLexem->type());
 		_getNextLexem();
 
 		std::shared_ptr<RValue> r = E2(context);
@@ -361,7 +799,7 @@ std::shared_ptr<RValue> Translator::E3_(const Scope context, std::shared_ptr<RVa
 
 		std::shared_ptr<MemoryOperand> s = _symbolTable.alloc(context);
 
-		generateAtom(std::make_unique<FnBinaryOpAtom>("MUL", p, r, s), context);
+		generateAtom(std::make_unique<FnBinaryOpAtom>(name, p, r, s), context);
 
 		std::shared_ptr<RValue> t = E3_(context, s);
 
@@ -592,7 +1030,116 @@ std::shared_ptr<RValue> Translator::E7_(const Scope context, std::shared_ptr<RVa
 
 std::shared_ptr<RValue> Translator::E(const Scope context)
 {
-	return E7(context);
+	NestingGuard guard(*this);
+
+	if (_expressionParser == ExpressionParser::recursiveDescent) {
+		return E7(context);
+	}
+
+	return _climbExpression(context);
+}
+
+std::shared_ptr<RValue> Translator::_climbExpression(const Scope context)
+{
+	// All operators are left associative, comparisons can't be chained
+	static const std::map<LexemType, unsigned int> precedence = {
+		{ LexemType::opor, 1 }, { LexemType::opand, 2 },
+		{ LexemType::opeq, 3 }, { LexemType::opne, 3 }, { LexemType::opgt, 3 }, { LexemType::oplt, 3 }, { LexemType::ople, 3 },
+		{ LexemType::opplus, 4 }, { LexemType::opminus, 4 },
+		{ LexemType::opmult, 5 }, { LexemType::opdiv, 5 }, { LexemType::opmod, 5 }
+	};
+	static const unsigned int comparison = 3;
+
+	// Precedence of pending operators grows from bottom to top
+	std::vector<std::shared_ptr<RValue>> operands;
+	std::vector<LexemType> operators;
+
+	auto reduce = [&]() {
+		std::shared_ptr<RValue> right = operands.back();
+		operands.pop_back();
+		operands.back() = _binaryOperation(context, operators.back(), operands.back(), right);
+		operators.pop_back();
+	};
+
+	std::shared_ptr<RValue> operand = E2(context);
+	if (!operand) {
+		return nullptr;
+	}
+	operands.push_back(operand);
+
+	while (precedence.count(_currentLexem->type()) > 0) {
+		LexemType operation = _currentLexem->type();
+		unsigned int level = precedence.at(operation);
+
+		while (!operators.empty() && precedence.at(operators.back()) > level) {
+			reduce();
+		}
+
+		if (!operators.empty() && precedence.at(operators.back()) == level) {
+			if (level == comparison) {
+				break;
+			}
+			reduce();
+		}
+
+		operators.push_back(operation);
+		_getNextLexem();
+
+		operand = E2(context);
+		if (!operand) {
+			return nullptr;
+		}
+		operands.push_back(operand);
+	}
+
+	while (!operators.empty()) {
+		reduce();
+	}
+
+	return operands.back();
+}
+
+std::shared_ptr<MemoryOperand> Translator::_binaryOperation(const Scope context, const LexemType operation,
+	const std::shared_ptr<RValue> left, const std::shared_ptr<RValue> right)
+{
+	static const std::map<LexemType, std::string> functions = {
+		{ LexemType::opmult, "MUL" }, { LexemType::opdiv, "DIV" }, { LexemType::opmod, "MOD" }
+	};
+	static const std::map<LexemType, std::string> operations = {
+		{ LexemType::opplus, "ADD" }, { LexemType::opminus, "SUB" }, { LexemType::opand, "AND" }, { LexemType::opor, "OR" }
+	};
+	static const std::map<LexemType, std::string> conditions = {
+		{ LexemType::opeq, "EQ" }, { LexemType::opne, "NE" }, { LexemType::opgt, "GT" }, { LexemType::oplt, "LT" }
+	};
+
+	std::shared_ptr<MemoryOperand> s = _symbolTable.alloc(context);
+
+	if (functions.count(operation) > 0) {
+		generateAtom(std::make_unique<FnBinaryOpAtom>(functions.at(operation), left, right, s), context);
+		return s;
+	}
+
+	if (operations.count(operation) > 0) {
+		generateAtom(std::make_unique<SimpleBinaryOpAtom>(operations.at(operation), left, right, s), context);
+		return s;
+	}
+
+	// Comparison result is 1 unless jump over its reset is taken
+	std::shared_ptr<LabelOperand> l = newLabel();
+
+	generateAtom(std::make_unique<UnaryOpAtom>("MOV", std::make_shared<NumberOperand>(1), s), context);
+
+	if (operation == LexemType::ople) {
+		generateAtom(std::make_unique<ComplexConditinalJumpAtom>("LE", left, right, l), context);
+	}
+	else {
+		generateAtom(std::make_unique<SimpleConditionalJumpAtom>(conditions.at(operation), left, right, l), context);
+	}
+
+	generateAtom(std::make_unique<UnaryOpAtom>("MOV", std::make_shared<NumberOperand>(0), s), context);
+	generateAtom(std::make_unique<LabelAtom>(l), context);
+
+	return s;
 }
 
 void Translator::DeclareStmt(const Scope context)
@@ -604,30 +1151,48 @@ void Translator::DeclareStmt(const Scope context)
 	}
 
 	const std::string name = _currentLexem->str();
+	const SourcePosition position = _currentLexem->position();
 	_takeTerm(LexemType::id);
 
-	DeclareStmt_(context, p, name);
+	DeclareStmt_(context, p, name, position);
 }
 
-void Translator::DeclareStmt_(const Scope context, SymbolTable::TableRecord::RecordType p, const std::string & q)
+void Translator::DeclareStmt_(const Scope context, SymbolTable::TableRecord::RecordType p, const std::string & q, const SourcePosition& position)
 {
 	if (_currentLexem->type() == LexemType::lpar) {
 		if (context != SymbolTable::GLOBAL_SCOPE) {
 			throwSyntaxError("Function can't be defined inside another function.");
 		}
+		// Lexems of function are hashed for cache starting from its type and name
+		_lexemsHash = CompilationCache::hash(std::to_string((int)p) + " " + q);
+		_hashing = true;
 		_getNextLexem();
 
-		Scope newContext = _symbolTable.insertFunc(q, p, -1)->index();
+		std::shared_ptr<MemoryOperand> function = _symbolTable.insertFunc(q, p, -1, position);
+		if (!function) {
+			throwSyntaxError("Function with given name is already defined");
+		}
+		Scope newContext = function->index();
 
 		unsigned int n = ParamList(newContext);
 		_symbolTable.changeArgsCount(newContext, n);
 
 		_takeTerm(LexemType::rpar);
+
+		// Declaration of function defined by other module
+		if (_currentLexem->type() == LexemType::semicolon) {
+			_hashing = false;
+			_getNextLexem();
+			return;
+		}
+
 		_takeTerm(LexemType::lbrace);
 
 		StmtList(newContext);
 
 		_takeTerm(LexemType::rbrace);
+		_hashing = false;
+		_functionHashes[newContext] = _lexemsHash;
 
 		generateAtom(std::make_unique<RetAtom>(std::make_shared<NumberOperand>(0), newContext, _symbolTable), newContext);
 	}
@@ -638,7 +1203,7 @@ void Translator::DeclareStmt_(const Scope context, SymbolTable::TableRecord::Rec
 
 		_takeTerm(LexemType::num);
 
-		std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(q, context, p, val);
+		std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(q, context, p, val, position);
 		if (!var) {
 			throwSyntaxError("Variable with given name is already defined in this scope");
 		}
@@ -659,7 +1224,7 @@ void Translator::DeclareStmt_(const Scope context, SymbolTable::TableRecord::Rec
 		_takeTerm(LexemType::num);
 		_takeTerm(LexemType::rbracket);
 
-		std::shared_ptr<MemoryOperand> var = _symbolTable.insertArray(q, context, p, val);
+		std::shared_ptr<MemoryOperand> var = _symbolTable.insertArray(q, context, p, val, position);
 
 		if (!var) {
 			throwSyntaxError("Variable with given name is already defined in this scope");
@@ -669,7 +1234,7 @@ void Translator::DeclareStmt_(const Scope context, SymbolTable::TableRecord::Rec
 		_takeTerm(LexemType::semicolon);
 	}
 	else {
-		std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(q, context, p);
+		std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(q, context, p, 0, position);
 		if (!var) {
 			throwSyntaxError("Variable with given name is already defined in this scope");
 		}
@@ -694,20 +1259,18 @@ SymbolTable::TableRecord::RecordType Translator::Type()
 
 void Translator::DeclVarList_(const Scope context, SymbolTable::TableRecord::RecordType p)
 {
-	if (_currentLexem->type() == LexemType::comma) {
+	while (_currentLexem->type() == LexemType::comma) {
 		_getNextLexem();
 
 		const std::string name = _currentLexem->str();
+		const SourcePosition position = _currentLexem->position();
 		_takeTerm(LexemType::id);
 
-		InitVar(context, p, name);
-		DeclVarList_(context, p);
+		InitVar(context, p, name, position);
 	}
-
-	return;
 }
 
-void Translator::InitVar(const Scope context, SymbolTable::TableRecord::RecordType p, const std::string & q)
+void Translator::InitVar(const Scope context, SymbolTable::TableRecord::RecordType p, const std::string & q, const SourcePosition& position)
 {
 	if (_currentLexem->type() == LexemType::opassign) {
 		_getNextLexem();
@@ -720,7 +1283,7 @@ void Translator::InitVar(const Scope context, SymbolTable::TableRecord::RecordTy
 
 		_getNextLexem();
 
-		std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(q, context, p, val);
+		std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(q, context, p, val, position);
 
 		if (!var) {
 			throwSyntaxError("Variable with given name is already defined in this scope");
@@ -738,14 +1301,14 @@ void Translator::InitVar(const Scope context, SymbolTable::TableRecord::RecordTy
 		_takeTerm(LexemType::num);
 		_takeTerm(LexemType::rbracket);
 
-		std::shared_ptr<MemoryOperand> var = _symbolTable.insertArray(q, context, p, val);
+		std::shared_ptr<MemoryOperand> var = _symbolTable.insertArray(q, context, p, val, position);
 
 		if (!var) {
 			throwSyntaxError("Variable with given name is already defined in this scope");
 		}
 	}
 	else {
-		std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(q, context, p);
+		std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(q, context, p, 0, position);
 		if (!var) {
 			throwSyntaxError("Variable with given name is already defined in this scope");
 		}
@@ -761,9 +1324,10 @@ unsigned int Translator::ParamList(const Scope context)
 	}
 
 	const std::string name = _currentLexem->str();
+	const SourcePosition position = _currentLexem->position();
 	_takeTerm(LexemType::id);
 
-	std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(name, context, q);
+	std::shared_ptr<MemoryOperand> var = _symbolTable.insertVar(name, context, q, 0, position);
 
 	if (!var) {
 		throwSyntaxError("Variable with given name is already defined in this scope");
@@ -774,7 +1338,9 @@ unsigned int Translator::ParamList(const Scope context)
 
 unsigned int Translator::ParamList_(const Scope context)
 {
-	if (_currentLexem->type() == LexemType::comma) {
+	unsigned int n = 0;
+
+	while (_currentLexem->type() == LexemType::comma) {
 		_getNextLexem();
 
 		SymbolTable::TableRecord::RecordType q = Type();
@@ -784,36 +1350,58 @@ unsigned int Translator::ParamList_(const Scope context)
 		}
 
 		const std::string name = _currentLexem->str();
+		const SourcePosition position = _currentLexem->position();
 		_takeTerm(LexemType::id);
 
-		std::shared_ptr<MemoryOperand> var =_symbolTable.insertVar(name, context, q);
+		std::shared_ptr<MemoryOperand> var =_symbolTable.insertVar(name, context, q, 0, position);
 		if (!var) {
 			throwSyntaxError("Variable with given name is already defined in this scope");
 		}
 
-		return ParamList_(context) + 1;
+		++n;
 	}
 
-	return 0;
+	return n;
 }
 
 void Translator::StmtList(const Scope context)
 {
-	LexemType type = _currentLexem->type();
-	if (type == LexemType::kwchar || type == LexemType::kwint || type == LexemType::id
-		|| type == LexemType::kwwhile || type == LexemType::kwfor || type == LexemType::kwif
-		|| type == LexemType::kwswitch || type == LexemType::kwin || type == LexemType::kwin
-		|| type == LexemType::kwout || type == LexemType::semicolon || type == LexemType::lbrace
-		|| type == LexemType::kwreturn) {
-		Stmt(context);
-		StmtList(context);
+	while (true) {
+		LexemType type = _currentLexem->type();
+		if (type != LexemType::kwchar && type != LexemType::kwint && type != LexemType::id
+			&& type != LexemType::kwwhile && type != LexemType::kwfor && type != LexemType::kwif
+			&& type != LexemType::kwswitch && type != LexemType::kwin
+			&& type != LexemType::kwout && type != LexemType::semicolon && type != LexemType::lbrace
+			&& type != LexemType::kwreturn) {
+			return;
+		}
+
+		// Statement with error is skipped, translation goes on to find other errors
+		const unsigned int start = _lexemsCount;
+		const unsigned int braces = _openBraces;
+		try {
+			Stmt(context);
+		}
+		catch (const LexicalError& error) {
+			_report(error);
+			_synchronize(start, braces);
+		}
+		catch (const SyntaxError& error) {
+			_report(error);
+			_synchronize(start, braces);
+		}
 	}
 }
 
 void Translator::Stmt(const Scope context)
 {
+	NestingGuard guard(*this);
 	LexemType type = _currentLexem->type();
 
+	// Atoms get position of the innermost statement, the enclosing one is restored after it
+	const SourcePosition enclosing = _statementPosition;
+	_statementPosition = _currentLexem->position();
+
 	// If operator outside function, throw error
 	if ((type == LexemType::id || type == LexemType::kwwhile || type == LexemType::kwfor ||
 		type == LexemType::kwif || type == LexemType::kwswitch || type == LexemType::kwin ||
@@ -869,6 +1457,8 @@ void Translator::Stmt(const Scope context)
 
 		throwSyntaxError("Forbidden lexem"); //@TODO: CHANGE 
 	}
+
+	_statementPosition = enclosing;
 }
 
 void Translator::AssignOrCallOp(const Scope context)
@@ -909,6 +1499,7 @@ void Translator::AssignOrCall_(const Scope context, const std::string & p)
 		if (!arr) {
 			throwSyntaxError(p + " is not array.");
 		}
+		_checkIndex(arr, index);
 
 		_takeTerm(LexemType::opassign);
 
@@ -1091,42 +1682,72 @@ void Translator::SwitchOp(const Scope context)
 	_takeTerm(LexemType::lbrace);
 
 	std::shared_ptr<LabelOperand> end = newLabel();
-	Cases(context, p, end);
+	const unsigned int start = _atoms[context].size();
+	CasesList cases;
+	Cases(context, p, end, cases);
 
 	_takeTerm(LexemType::rbrace);
+
+	// Large switches dispatch at once: compares become labels of case bodies. Cases are
+	// compared as bytes, so words need all of them in byte range, and bytes never match
+	// cases out of it
+	bool bytes = true;
+	unsigned int inRange = 0;
+	for (auto it = cases.begin(); it != cases.end(); ++it) {
+		const bool byte = it->first >= 0 && it->first <= 255;
+		bytes = bytes && byte;
+		inRange += byte ? 1 : 0;
+	}
+
+	if (inRange >= SwitchAtom::MIN_CASES && (bytes || !p->isWide())) {
+		std::vector<std::pair<int, std::shared_ptr<LabelOperand>>> targets;
+
+		for (auto it = cases.begin(); it != cases.end(); ++it) {
+			std::shared_ptr<LabelOperand> body = newLabel();
+			_atoms[context][it->second] = std::make_unique<LabelAtom>(body);
+			if (it->first >= 0 && it->first <= 255) {
+				targets.push_back({ it->first, body });
+			}
+		}
+
+		// Default target is where the chain ends
+		std::shared_ptr<LabelOperand> def = dynamic_cast<JumpAtom*>(_atoms[context].back().get())->label();
+
+		_atoms[context].insert(_atoms[context].begin() + start, std::make_unique<SwitchAtom>(p, targets, def, newLabel()));
+	}
+
 	generateAtom(std::make_unique<LabelAtom>(end), context);
 }
 
-void Translator::Cases(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end)
+void Translator::Cases(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end, CasesList& cases)
 {
-	std::shared_ptr<LabelOperand> def1 = ACase(context, p, end);
-	Cases_(context, p, end, def1);
+	std::shared_ptr<LabelOperand> def1 = ACase(context, p, end, cases);
+	Cases_(context, p, end, def1, cases);
 }
 
-void Translator::Cases_(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end, std::shared_ptr<LabelOperand> def)
+void Translator::Cases_(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end, std::shared_ptr<LabelOperand> def, CasesList& cases)
 {
-	if (_currentLexem->type() == LexemType::kwcase || _currentLexem->type() == LexemType::kwdefault) {
-		std::shared_ptr<LabelOperand> def1 = ACase(context, p, end);
+	while (_currentLexem->type() == LexemType::kwcase || _currentLexem->type() == LexemType::kwdefault) {
+		std::shared_ptr<LabelOperand> def1 = ACase(context, p, end, cases);
 		
 		if (def != nullptr && def1 != nullptr) {
 			throwSyntaxError("There can't be more than ONE default section in case.");
 		}
 		
-		std::shared_ptr<LabelOperand> def2 = (def != nullptr) ? def : def1;
-
-		Cases_(context, p, end, def2);
-	}
-	else {
-		std::shared_ptr<LabelOperand> q = end;
-		if (def != nullptr) {
-			q = def;
+		if (def == nullptr) {
+			def = def1;
 		}
+	}
 
-		generateAtom(std::make_unique<JumpAtom>(q), context);
+	std::shared_ptr<LabelOperand> q = end;
+	if (def != nullptr) {
+		q = def;
 	}
+
+	generateAtom(std::make_unique<JumpAtom>(q), context);
 }
 
-std::shared_ptr<LabelOperand> Translator::ACase(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end)
+std::shared_ptr<LabelOperand> Translator::ACase(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end, CasesList& cases)
 {
 	if (_currentLexem->type() == LexemType::kwcase) {
 		_getNextLexem();
@@ -1134,6 +1755,7 @@ std::shared_ptr<LabelOperand> Translator::ACase(const Scope context, std::shared
 		_takeTerm(LexemType::num);
 
 		std::shared_ptr<LabelOperand> next = newLabel();
+		cases.push_back({ val, _atoms[context].size() });
 		generateAtom(std::make_unique<SimpleConditionalJumpAtom>("NE", p, std::make_shared<NumberOperand>(val), next), context);
 
 		_takeTerm(LexemType::colon);
@@ -1204,27 +1826,57 @@ void Translator::OOp_(const Scope context)
 	}
 }
 
-void Translator::_generateProlog(std::ostream & stream) const
-{
-	stream << "ORG 0" << std::endl;
-	stream << "LXI H, 0" << std::endl;
-	stream << "SPHL" << std::endl;
-	stream << "CALL main" << std::endl;
-	stream << "END" << std::endl;
-
-	stream << "@MULT:" << std::endl << "; code for mult lib" << std::endl;
-	stream << "@PRINT:" << std::endl << "; code for mult lib" << std::endl;
-}
-
-void Translator::_generateFunctionCode(std::ostream & stream, unsigned int function) const
+void Translator::_generateFunctionCode(CodeWriter& stream, unsigned int function) const
 {
 	const SymbolTable::TableRecord* record = &_symbolTable[function];
 
 	stream << record->name << ": ";
 
-	stream << "LXI B, 0" << std::endl;
-	for (unsigned int i = 0; i < _symbolTable.getLocalsCount(function) + _symbolTable.getArraysSize(function); ++i) {
-		stream << "PUSH B" << std::endl;
+	// Locals and arrays are zeroed. Frames with large arrays are cleared by loop, so code
+	// doesn't grow with their size
+	const unsigned int zeroed = _symbolTable.getLocalsCount(function) + _symbolTable.getArraysSize(function);
+	if (zeroed > 0) {
+		stream << "LXI B, 0\n";
+	}
+
+	if (_symbolTable.getArraysSize(function) >= RetAtom::FRAME_ARITHMETIC_WORDS) {
+		const std::string loop = record->name + "@ZERO";
+
+		if (zeroed <= 0xFF) {
+			stream << "MVI D, " << zeroed << '\n';
+			stream << loop << ": PUSH B\n";
+			stream << "DCR D\n";
+		}
+		else {
+			stream << "LXI D, " << zeroed << '\n';
+			stream << loop << ": PUSH B\n";
+			stream << "DCX D\n";
+			stream << "MOV A, D\n";
+			stream << "ORA E\n";
+		}
+		stream << "JNZ " << loop << '\n';
+	}
+	else {
+		for (unsigned int i = 0; i < zeroed; ++i) {
+			stream << "PUSH B\n";
+		}
+	}
+
+	// Load params placed in registers
+	std::vector<unsigned int> params = _symbolTable.parametersIds(function);
+	for (auto it = params.begin(); it != params.end(); ++it) {
+		const Register reg = _symbolTable[*it].reg;
+		if (reg == Register::none) {
+			continue;
+		}
+
+		stream << "LXI H, " << _symbolTable[*it].offset << '\n';
+		stream << "DAD SP\n";
+		if (_symbolTable[*it].type == SymbolTable::TableRecord::RecordType::integer) {
+			stream << "MOV " << registerName(lowRegister(reg)) << ", M\n";
+			stream << "INX H\n";
+		}
+		stream << "MOV " << registerName(reg) << ", M\n";
 	}
 
 	for (auto it = _atoms.at(function).begin(); it != _atoms.at(function).end(); ++it) {
@@ -1233,3 +1885,478 @@ void Translator::_generateFunctionCode(std::ostream & stream, unsigned int funct
 	}
 
 }
+
+void Translator::_generateFunction(const Scope function, std::string & code, std::string & tables, std::set<std::string>& routines) const
+{
+	auto found = _functionSymbols.find(function);
+	const CompilationCache::Symbols symbols = (found != _functionSymbols.end()) ? found->second : _collectSymbols(function);
+
+	const uint64_t key = (_cache != nullptr) ? _cacheKey(function) : 0;
+	if (_cache != nullptr) {
+		const CompilationCache::Entry* entry = _cache->find(key);
+		if (entry != nullptr && CompilationCache::resolve(entry->code, symbols, code)
+			&& CompilationCache::resolve(entry->tables, symbols, tables)) {
+			routines.insert(entry->routines.begin(), entry->routines.end());
+			return;
+		}
+	}
+
+	CodeWriter codeStream;
+	CodeWriter tablesStream;
+	std::set<std::string> called;
+
+	const std::vector<std::unique_ptr<Atom>>& atoms = _atoms.at(function);
+	for (auto it = atoms.begin(); it != atoms.end(); ++it) {
+		std::vector<std::string> atomRoutines = (*it)->routines();
+		called.insert(atomRoutines.begin(), atomRoutines.end());
+
+		SwitchAtom* switchAtom = dynamic_cast<SwitchAtom*>(it->get());
+		if (switchAtom != nullptr) {
+			switchAtom->generateTable(tablesStream);
+		}
+	}
+
+	_generateFunctionCode(codeStream, function);
+
+	code = codeStream.str();
+	tables = tablesStream.str();
+	routines.insert(called.begin(), called.end());
+
+	if (_cache != nullptr) {
+		_cache->store(key, code, tables, called, symbols);
+	}
+}
+
+std::vector<unsigned int> Translator::_definedFunctions() const
+{
+	std::vector<unsigned int> fns = _symbolTable.functionsIds();
+	fns.erase(std::remove_if(fns.begin(), fns.end(), [this](const unsigned int function) {
+		return _atoms.count(function) == 0;
+	}), fns.end());
+
+	return fns;
+}
+
+void Translator::_computeFunctionKeys()
+{
+	std::vector<unsigned int> fns = _definedFunctions();
+
+	for (auto function = fns.begin(); function != fns.end(); ++function) {
+		// Globals and functions used by function with their hashes, ordered by name
+		std::map<std::string, uint64_t> dependencies;
+		auto addRecord = [this, &dependencies, function](const int index) {
+			const SymbolTable::TableRecord& record = _symbolTable[index];
+			if (record.scope != SymbolTable::GLOBAL_SCOPE || index == (int)*function) {
+				return;
+			}
+
+			if (record.kind == SymbolTable::TableRecord::RecordKind::func) {
+				dependencies[record.name] = _functionKeys[index];
+			}
+			else {
+				dependencies[record.name] = CompilationCache::hash(std::to_string((int)record.kind) + " " +
+					std::to_string((int)record.type) + " " + std::to_string(record.len) + " " + std::to_string(record.init));
+			}
+		};
+
+		std::function<void(const std::shared_ptr<RValue>)> addOperand = [&addRecord, &addOperand](const std::shared_ptr<RValue> operand) {
+			std::shared_ptr<MemoryOperand> memory = std::dynamic_pointer_cast<MemoryOperand>(operand);
+			if (memory == nullptr) {
+				return;
+			}
+
+			addRecord(memory->index());
+
+			std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+			if (element != nullptr) {
+				addOperand(element->elementIndex());
+			}
+		};
+
+		const std::vector<std::unique_ptr<Atom>>& atoms = _atoms[*function];
+		for (auto it = atoms.begin(); it != atoms.end(); ++it) {
+			std::vector<std::shared_ptr<RValue>> operands = (*it)->operands();
+			for (auto operand = operands.begin(); operand != operands.end(); ++operand) {
+				addOperand(*operand);
+			}
+			addOperand((*it)->result());
+
+			CallAtom* call = dynamic_cast<CallAtom*>(it->get());
+			if (call != nullptr) {
+				addRecord(call->function()->index());
+			}
+		}
+
+		uint64_t key = _functionHashes[*function];
+		for (auto it = dependencies.begin(); it != dependencies.end(); ++it) {
+			key = CompilationCache::hash(it->first + " " + std::to_string(it->second), key);
+		}
+
+		_functionKeys[*function] = key;
+	}
+}
+
+uint64_t Translator::_cacheKey(const Scope function) const
+{
+	std::string options = std::to_string(CompilationCache::VERSION) + (_optimized ? " optimized" : " plain");
+	return CompilationCache::hash(options, _functionKeys.at(function));
+}
+
+CompilationCache::Symbols Translator::_collectSymbols(const Scope function) const
+{
+	CompilationCache::Symbols symbols;
+	auto addLabel = [&symbols](const std::shared_ptr<LabelOperand> label) {
+		if (std::find(symbols.labels.begin(), symbols.labels.end(), label->id()) == symbols.labels.end()) {
+			symbols.labels.push_back(label->id());
+		}
+	};
+
+	const std::vector<std::unique_ptr<Atom>>& atoms = _atoms.at(function);
+	for (auto it = atoms.begin(); it != atoms.end(); ++it) {
+		const Atom* atom = it->get();
+
+		if (dynamic_cast<const LabelAtom*>(atom) != nullptr) {
+			addLabel(dynamic_cast<const LabelAtom*>(atom)->label());
+		}
+		else if (dynamic_cast<const JumpAtom*>(atom) != nullptr) {
+			addLabel(dynamic_cast<const JumpAtom*>(atom)->label());
+		}
+		else if (dynamic_cast<const ConditionalJumpAtom*>(atom) != nullptr) {
+			addLabel(dynamic_cast<const ConditionalJumpAtom*>(atom)->label());
+		}
+		else if (dynamic_cast<const SwitchAtom*>(atom) != nullptr) {
+			const SwitchAtom* switchAtom = dynamic_cast<const SwitchAtom*>(atom);
+			for (auto label = switchAtom->cases().begin(); label != switchAtom->cases().end(); ++label) {
+				addLabel(label->second);
+			}
+			addLabel(switchAtom->defaultLabel());
+			addLabel(switchAtom->table());
+		}
+		else if (dynamic_cast<const OutAtom*>(atom) != nullptr) {
+			std::shared_ptr<StringOperand> str = std::dynamic_pointer_cast<StringOperand>(dynamic_cast<const OutAtom*>(atom)->value());
+			if (str != nullptr && std::find(symbols.strings.begin(), symbols.strings.end(), str->index()) == symbols.strings.end()) {
+				symbols.strings.push_back(str->index());
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < _symbolTable.size(); ++i) {
+		const SymbolTable::TableRecord& record = _symbolTable[i];
+		if (record.scope == SymbolTable::GLOBAL_SCOPE && record.kind != SymbolTable::TableRecord::RecordKind::func) {
+			symbols.globals[i] = record.name;
+		}
+	}
+
+	return symbols;
+}
+
+void Translator::_saveAtom(BinaryWriter& writer, const Atom* atom) const
+{
+	std::vector<std::shared_ptr<RValue>> operands = atom->operands();
+	auto saveLabel = [&writer](const std::shared_ptr<LabelOperand> label) {
+		writer.writeUnsigned(label->id());
+	};
+
+	if (typeid(*atom) == typeid(SimpleBinaryOpAtom) || typeid(*atom) == typeid(FnBinaryOpAtom)) {
+		writer.writeUnsigned((unsigned int)(typeid(*atom) == typeid(SimpleBinaryOpAtom) ? AtomTag::simpleBinaryOp : AtomTag::fnBinaryOp));
+		writer.writeString(dynamic_cast<const BinaryOpAtom*>(atom)->name());
+		_saveOperand(writer, operands[0]);
+		_saveOperand(writer, operands[1]);
+		_saveOperand(writer, atom->result());
+	}
+	else if (typeid(*atom) == typeid(UnaryOpAtom)) {
+		writer.writeUnsigned((unsigned int)AtomTag::unaryOp);
+		writer.writeString(dynamic_cast<const UnaryOpAtom*>(atom)->name());
+		_saveOperand(writer, operands[0]);
+		_saveOperand(writer, atom->result());
+	}
+	else if (typeid(*atom) == typeid(SimpleConditionalJumpAtom) || typeid(*atom) == typeid(ComplexConditinalJumpAtom)) {
+		const ConditionalJumpAtom* jump = dynamic_cast<const ConditionalJumpAtom*>(atom);
+		writer.writeUnsigned((unsigned int)(typeid(*atom) == typeid(SimpleConditionalJumpAtom) ? AtomTag::simpleJump : AtomTag::complexJump));
+		writer.writeString(jump->condition());
+		_saveOperand(writer, operands[0]);
+		_saveOperand(writer, operands[1]);
+		saveLabel(jump->label());
+	}
+	else if (typeid(*atom) == typeid(OutAtom)) {
+		writer.writeUnsigned((unsigned int)AtomTag::out);
+		_saveOperand(writer, dynamic_cast<const OutAtom*>(atom)->value());
+	}
+	else if (typeid(*atom) == typeid(InAtom)) {
+		writer.writeUnsigned((unsigned int)AtomTag::in);
+		_saveOperand(writer, atom->result());
+	}
+	else if (typeid(*atom) == typeid(LabelAtom)) {
+		writer.writeUnsigned((unsigned int)AtomTag::label);
+		saveLabel(dynamic_cast<const LabelAtom*>(atom)->label());
+	}
+	else if (typeid(*atom) == typeid(JumpAtom)) {
+		writer.writeUnsigned((unsigned int)AtomTag::jump);
+		saveLabel(dynamic_cast<const JumpAtom*>(atom)->label());
+	}
+	else if (typeid(*atom) == typeid(SwitchAtom)) {
+		const SwitchAtom* switchAtom = dynamic_cast<const SwitchAtom*>(atom);
+		writer.writeUnsigned((unsigned int)AtomTag::switchOp);
+		_saveOperand(writer, operands[0]);
+		writer.writeUnsigned(switchAtom->cases().size());
+		for (auto it = switchAtom->cases().begin(); it != switchAtom->cases().end(); ++it) {
+			writer.writeInt(it->first);
+			saveLabel(it->second);
+		}
+		saveLabel(switchAtom->defaultLabel());
+		saveLabel(switchAtom->table());
+	}
+	else if (typeid(*atom) == typeid(CallAtom)) {
+		const CallAtom* call = dynamic_cast<const CallAtom*>(atom);
+		writer.writeUnsigned((unsigned int)AtomTag::call);
+		_saveOperand(writer, call->function());
+		_saveOperand(writer, call->result());
+		writer.writeUnsigned(call->savedRegisters().size());
+		for (auto it = call->savedRegisters().begin(); it != call->savedRegisters().end(); ++it) {
+			writer.writeUnsigned((unsigned int)*it);
+		}
+	}
+	else if (typeid(*atom) == typeid(RetAtom)) {
+		writer.writeUnsigned((unsigned int)AtomTag::ret);
+		_saveOperand(writer, operands[0]);
+		writer.writeUnsigned(dynamic_cast<const RetAtom*>(atom)->scope());
+	}
+	else {
+		writer.writeUnsigned((unsigned int)AtomTag::param);
+		_saveOperand(writer, operands[0]);
+	}
+
+	writer.writeUnsigned(atom->position().line);
+	writer.writeUnsigned(atom->position().column);
+}
+
+std::unique_ptr<Atom> Translator::_loadAtom(BinaryReader& reader, std::map<int, std::shared_ptr<LabelOperand>>& labels)
+{
+	std::unique_ptr<Atom> atom;
+	const AtomTag tag = (AtomTag)reader.readBounded((unsigned int)AtomTag::param + 1, "atom");
+
+	if (tag == AtomTag::simpleBinaryOp || tag == AtomTag::fnBinaryOp || tag == AtomTag::unaryOp) {
+		const std::string name = reader.readString();
+		std::shared_ptr<RValue> left = expectOperand<RValue>(_loadOperand(reader));
+		if (tag == AtomTag::unaryOp) {
+			atom = std::make_unique<UnaryOpAtom>(name, left, expectOperand<MemoryOperand>(_loadOperand(reader)));
+		}
+		else {
+			std::shared_ptr<RValue> right = expectOperand<RValue>(_loadOperand(reader));
+			std::shared_ptr<MemoryOperand> result = expectOperand<MemoryOperand>(_loadOperand(reader));
+			if (tag == AtomTag::simpleBinaryOp) {
+				atom = std::make_unique<SimpleBinaryOpAtom>(name, left, right, result);
+			}
+			else {
+				atom = std::make_unique<FnBinaryOpAtom>(name, left, right, result);
+			}
+		}
+	}
+	else if (tag == AtomTag::simpleJump || tag == AtomTag::complexJump) {
+		const std::string condition = reader.readString();
+		std::shared_ptr<RValue> left = expectOperand<RValue>(_loadOperand(reader));
+		std::shared_ptr<RValue> right = expectOperand<RValue>(_loadOperand(reader));
+		std::shared_ptr<LabelOperand> label = _loadLabel(reader, labels);
+		if (tag == AtomTag::simpleJump) {
+			atom = std::make_unique<SimpleConditionalJumpAtom>(condition, left, right, label);
+		}
+		else {
+			atom = std::make_unique<ComplexConditinalJumpAtom>(condition, left, right, label);
+		}
+	}
+	else if (tag == AtomTag::out) {
+		atom = std::make_unique<OutAtom>(expectOperand<Operand>(_loadOperand(reader)));
+	}
+	else if (tag == AtomTag::in) {
+		atom = std::make_unique<InAtom>(expectOperand<MemoryOperand>(_loadOperand(reader)));
+	}
+	else if (tag == AtomTag::label) {
+		atom = std::make_unique<LabelAtom>(_loadLabel(reader, labels));
+	}
+	else if (tag == AtomTag::jump) {
+		atom = std::make_unique<JumpAtom>(_loadLabel(reader, labels));
+	}
+	else if (tag == AtomTag::switchOp) {
+		std::shared_ptr<RValue> value = expectOperand<RValue>(_loadOperand(reader));
+		std::vector<std::pair<int, std::shared_ptr<LabelOperand>>> cases;
+		const uint64_t count = reader.readUnsigned();
+		for (uint64_t i = 0; i < count; ++i) {
+			const int caseValue = (int)reader.readInt();
+			cases.push_back({ caseValue, _loadLabel(reader, labels) });
+		}
+		std::shared_ptr<LabelOperand> defaultLabel = _loadLabel(reader, labels);
+		atom = std::make_unique<SwitchAtom>(value, cases, defaultLabel, _loadLabel(reader, labels));
+	}
+	else if (tag == AtomTag::call) {
+		std::shared_ptr<MemoryOperand> function = expectOperand<MemoryOperand>(_loadOperand(reader));
+		std::shared_ptr<MemoryOperand> result = expectOperand<MemoryOperand>(_loadOperand(reader), true);
+		if (_symbolTable[function->index()].kind != SymbolTable::TableRecord::RecordKind::func) {
+			throw FormatError("Call of " + _symbolTable[function->index()].name + " which is not function");
+		}
+
+		std::vector<Register> registers;
+		const uint64_t count = reader.readUnsigned();
+		for (uint64_t i = 0; i < count; ++i) {
+			registers.push_back((Register)reader.readBounded(7, "register"));
+		}
+
+		std::unique_ptr<CallAtom> call = std::make_unique<CallAtom>(function, result, _symbolTable, _paramsList);
+		call->setSavedRegisters(registers);
+		atom = std::move(call);
+	}
+	else if (tag == AtomTag::ret) {
+		std::shared_ptr<RValue> value = expectOperand<RValue>(_loadOperand(reader));
+		atom = std::make_unique<RetAtom>(value, (Scope)reader.readBounded(_symbolTable.size(), "scope"), _symbolTable);
+	}
+	else {
+		atom = std::make_unique<ParamAtom>(expectOperand<RValue>(_loadOperand(reader)), _paramsList);
+	}
+
+	SourcePosition position;
+	position.line = (unsigned int)reader.readUnsigned();
+	position.column = (unsigned int)reader.readUnsigned();
+	atom->setPosition(position);
+
+	return atom;
+}
+
+void Translator::_saveOperand(BinaryWriter& writer, const std::shared_ptr<Operand> operand) const
+{
+	if (operand == nullptr) {
+		writer.writeUnsigned((unsigned int)OperandTag::none);
+	}
+	else if (std::dynamic_pointer_cast<ArrayElementOperand>(operand) != nullptr) {
+		std::shared_ptr<ArrayElementOperand> element = std::dynamic_pointer_cast<ArrayElementOperand>(operand);
+		writer.writeUnsigned((unsigned int)OperandTag::element);
+		writer.writeUnsigned(element->index());
+		_saveOperand(writer, element->elementIndex());
+	}
+	else if (std::dynamic_pointer_cast<MemoryOperand>(operand) != nullptr) {
+		writer.writeUnsigned((unsigned int)OperandTag::memory);
+		writer.writeUnsigned(std::dynamic_pointer_cast<MemoryOperand>(operand)->index());
+	}
+	else if (std::dynamic_pointer_cast<NumberOperand>(operand) != nullptr) {
+		writer.writeUnsigned((unsigned int)OperandTag::number);
+		writer.writeInt(std::dynamic_pointer_cast<NumberOperand>(operand)->value());
+	}
+	else {
+		writer.writeUnsigned((unsigned int)OperandTag::string);
+		writer.writeUnsigned(std::dynamic_pointer_cast<StringOperand>(operand)->index());
+	}
+}
+
+std::shared_ptr<Operand> Translator::_loadOperand(BinaryReader& reader) const
+{
+	const OperandTag tag = (OperandTag)reader.readBounded((unsigned int)OperandTag::string + 1, "operand");
+
+	switch (tag) {
+	case OperandTag::memory:
+		return std::make_shared<MemoryOperand>(reader.readBounded(_symbolTable.size(), "record"), &_symbolTable);
+	case OperandTag::element: {
+		const int index = reader.readBounded(_symbolTable.size(), "record");
+		return std::make_shared<ArrayElementOperand>(index, expectOperand<RValue>(_loadOperand(reader)), &_symbolTable);
+	}
+	case OperandTag::number:
+		return std::make_shared<NumberOperand>((int)reader.readInt());
+	case OperandTag::string:
+		return std::make_shared<StringOperand>(reader.readBounded(_stringTable.size(), "string"), &_stringTable);
+	default:
+		return nullptr;
+	}
+}
+
+std::shared_ptr<LabelOperand> Translator::_loadLabel(BinaryReader& reader, std::map<int, std::shared_ptr<LabelOperand>>& labels) const
+{
+	const int id = reader.readBounded(_currentLabelId, "label");
+	if (labels.find(id) == labels.end()) {
+		labels[id] = std::make_shared<LabelOperand>(id);
+	}
+
+	return labels[id];
+}
+
+void Translator::_loadState(BinaryReader& reader)
+{
+	if (reader.readString() != STATE_MAGIC) {
+		throw FormatError("Data is not translation state");
+	}
+	const uint64_t version = reader.readUnsigned();
+	if (version != STATE_VERSION) {
+		throw FormatError("Unsupported version " + std::to_string(version));
+	}
+
+	_currentLabelId = (unsigned int)reader.readUnsigned();
+	_optimized = reader.readBool();
+
+	_diagnostics.clear();
+	uint64_t count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		Diagnostic diagnostic;
+		diagnostic.position.line = (unsigned int)reader.readUnsigned();
+		diagnostic.position.column = (unsigned int)reader.readUnsigned();
+		diagnostic.message = reader.readString();
+		_diagnostics.push_back(diagnostic);
+	}
+
+	_stringTable.load(reader);
+	_symbolTable.load(reader);
+
+	// Labels are shared by atoms of all functions, e.g. by inlined copies
+	_atoms.clear();
+	std::map<int, std::shared_ptr<LabelOperand>> labels;
+	count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		std::vector<std::unique_ptr<Atom>>& atoms = _atoms[(Scope)reader.readInt()];
+		const uint64_t atomsCount = reader.readUnsigned();
+		for (uint64_t k = 0; k < atomsCount; ++k) {
+			atoms.push_back(_loadAtom(reader, labels));
+		}
+	}
+
+	_functionHashes.clear();
+	count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		const Scope function = (Scope)reader.readInt();
+		_functionHashes[function] = reader.readUnsigned();
+	}
+
+	_functionKeys.clear();
+	count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		const Scope function = (Scope)reader.readInt();
+		_functionKeys[function] = reader.readUnsigned();
+	}
+
+	_functionSymbols.clear();
+	count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		CompilationCache::Symbols& symbols = _functionSymbols[(Scope)reader.readInt()];
+
+		const uint64_t labelsCount = reader.readUnsigned();
+		for (uint64_t k = 0; k < labelsCount; ++k) {
+			symbols.labels.push_back(reader.readBounded(_currentLabelId, "label"));
+		}
+
+		const uint64_t stringsCount = reader.readUnsigned();
+		for (uint64_t k = 0; k < stringsCount; ++k) {
+			symbols.strings.push_back(reader.readBounded(_stringTable.size(), "string"));
+		}
+
+		const uint64_t globalsCount = reader.readUnsigned();
+		for (uint64_t k = 0; k < globalsCount; ++k) {
+			const int index = reader.readBounded(_symbolTable.size(), "record");
+			symbols.globals[index] = reader.readString();
+		}
+	}
+
+	_optimizationStatistics.clear();
+	count = reader.readUnsigned();
+	for (uint64_t i = 0; i < count; ++i) {
+		const std::string name = reader.readString();
+		_optimizationStatistics[name] = (unsigned int)reader.readUnsigned();
+	}
+
+	if (!reader.atEnd()) {
+		throw FormatError("Excess data after translation state");
+	}
+}
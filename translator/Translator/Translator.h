@@ -2,18 +2,61 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <set>
 #include <deque>
 #include <iostream>
 #include "..\Atom\Atom.h"
 #include "..\StringTable\StringTable.h"
 #include "..\SymbolTable\SymbolTable.h"
 #include "..\LexicalAnalyzer\Scanner.h"
+#include "..\Optimizer\Optimizer.h"
+#include "..\Cache\CompilationCache.h"
+#include "..\Linker\Linker.h"
 #include "LexemHistory.h"
 
 class Translator {
 public:
+	// Parsers of expressions, both produce the same atoms. Recursive descent is kept until
+	// precedence climbing replaces it everywhere
+	enum class ExpressionParser { recursiveDescent, precedenceClimbing };
+
+	// Statements and expressions can't be nested deeper by default
+	static const unsigned int DEFAULT_MAX_DEPTH = 256;
+
+	// Changes whenever format of saved translation state changes
+	static const unsigned int STATE_VERSION = 1;
+
+	// Lexical or syntax error found during translation
+	struct Diagnostic {
+		SourcePosition position;
+		std::string message;
+	};
+
 	Translator(std::istream& stream, std::ostream& errStream = std::cerr);
 
+	// Translates source in memory, it must outlive translation
+	Translator(const char* source, const size_t size, std::ostream& errStream = std::cerr);
+
+	// Prepares translator for other source. Settings are kept, tables and buffers keep
+	// their memory, so translators can be reused for many small sources. Lexical error in
+	// the first lexem is not thrown, translate reports it
+	void reset(std::istream& stream);
+	void reset(const char* source, const size_t size);
+
+	// Sets limit of nesting depth, deeper input is rejected with SyntaxError
+	void setMaxDepth(const unsigned int depth);
+
+	// Selects parser of expressions, precedence climbing is used by default
+	void setExpressionParser(const ExpressionParser parser);
+
+	// Translates module of program: main is not required and functions declared without body
+	// are defined by other modules. Modules are compiled to objects and linked together
+	void setSeparateCompilation(const bool separate);
+
+	// Sets cache of compiled functions. Functions found in it are not optimized, their code
+	// is taken from cache, code of others is stored there. Cache must outlive translator
+	void setCache(CompilationCache* cache);
+
 	// Prints atoms list to a stream
 	void printAtoms(std::ostream& stream, const unsigned int width = 10) const;
 
@@ -23,7 +66,16 @@ public:
 	// Prints string table to a stream
 	void printStringTable(std::ostream& stream) const;
 
-	// Adds new atom to list of atoms
+	// Prints counters of applied optimizations to a stream
+	void printOptimizationStatistics(std::ostream& stream) const;
+
+	// Returns atoms of given scope, throws std::out_of_range if there are none
+	const std::vector<std::unique_ptr<Atom>>& atoms(const Scope scope) const;
+
+	// Returns table of symbols declared in program
+	const SymbolTable& symbolTable() const;
+
+	// Adds new atom to list of atoms, atom gets position of statement being parsed
 	void generateAtom(std::unique_ptr<Atom> atom, Scope scope);
 
 	// Inserts record to symbol table
@@ -40,12 +92,30 @@ public:
 	// Throws lexical error
 	void throwLexicalError(const std::string& text) const;
 
-	// Runs translation
+	// Runs translation. Statements with errors are skipped up to the next ';', '}' or declaration,
+	// so all errors are collected in one pass. Returns false if there are any
 	bool translate();
 
-	// Generates code
+	// Returns errors found during translation in order of appearance
+	const std::vector<Diagnostic>& diagnostics() const;
+
+	// Optimizes atoms of translated program, does nothing if translation failed
+	void optimize();
+
+	// Generates code, nothing is generated if translation failed
 	void generateCode(std::ostream& stream) const;
 
+	// Generates object of module with given name for linker, translation must succeed
+	ModuleObject generateObject(const std::string& name) const;
+
+	// Writes translation state in binary form: tables, atoms, diagnostics and keys of functions.
+	// Translator which loads it can be optimized and generate code as the saved one
+	void save(std::ostream& stream) const;
+
+	// Replaces state of translator with saved one, which is read at once. Throws FormatError
+	// if data is truncated, corrupted or of other version, translator is left empty then
+	void load(std::istream& stream);
+
 	// Translates single expression
 	std::shared_ptr<RValue> translateExpresssion();
 	bool translateExpression(int);
@@ -57,6 +127,21 @@ private:
 	std::unique_ptr<LexicalToken> _currentLexem;
 	unsigned int _currentLabelId;
 	std::deque<std::shared_ptr<RValue>> _paramsList;
+	std::map<std::string, unsigned int> _optimizationStatistics;
+	ExpressionParser _expressionParser = ExpressionParser::precedenceClimbing;
+
+	// Nesting of statements and expressions being parsed
+	unsigned int _depth = 0;
+	unsigned int _maxDepth = DEFAULT_MAX_DEPTH;
+
+	// Increases nesting depth while rule is parsed, throws SyntaxError when limit is exceeded
+	class NestingGuard {
+	public:
+		NestingGuard(Translator& translator);
+		~NestingGuard();
+	private:
+		Translator& _translator;
+	};
 
 	// History of last 3 lexems
 	LexemHistory _lexemHistory;
@@ -64,15 +149,50 @@ private:
 	// Error stream
 	std::ostream& _errStream;
 
+	// Errors found during translation
+	std::vector<Diagnostic> _diagnostics;
+
+	// Position of statement being parsed, generated atoms get it
+	SourcePosition _statementPosition;
+
+	CompilationCache* _cache = nullptr;
+	bool _optimized = false;
+	bool _separateCompilation = false;
+
+	// Hash of lexems of function being parsed, taken lexems are added while _hashing is set
+	bool _hashing = false;
+	uint64_t _lexemsHash = 0;
+
+	// Hashes of lexems of functions and keys including hashes of globals and functions they use
+	std::map<Scope, uint64_t> _functionHashes;
+	std::map<Scope, uint64_t> _functionKeys;
+
+	// Symbols of functions after inlining, cached code is resolved against them
+	std::map<Scope, CompilationCache::Symbols> _functionSymbols;
+
+	// Count of lexems got so far and count of braces opened by taken lexems
+	unsigned int _lexemsCount = 0;
+	unsigned int _openBraces = 0;
+
 	// Gets next token and writes it to _currentLexem
 	LexicalToken _getNextLexem();
 
+	// Adds error at position of current lexem (or given one) to diagnostics and writes it to error stream
+	void _report(const std::exception& error);
+	void _report(const std::exception& error, const SourcePosition& position);
+
+	// Skips lexems after error in statement started at given lexem and brace level. Stops after ';'
+	// or '}' closing the statement block, before '}' or declaration of the enclosing block
+	void _synchronize(const unsigned int start, const unsigned int braces);
+
 	// Checks current token and gets next
 	bool _takeTerm(LexemType type);
 
-	// Recursive descent rules of expressions
+	// Checks constant index of element against length of array
+	void _checkIndex(const std::shared_ptr<MemoryOperand> array, const std::shared_ptr<RValue> index) const;
+
+	// Recursive descent rules of expressions. Lists are parsed by loops
 	unsigned int ArgList(const Scope context);
-	unsigned int ArgList_(const Scope context);
 
 	std::shared_ptr<RValue> E1(const Scope context);
 	std::shared_ptr<MemoryOperand> E1_(const Scope context, const std::string& p);
@@ -96,15 +216,22 @@ private:
 
 	std::shared_ptr<RValue> E(const Scope context);
 
+	// Iterative precedence climbing over binary operators, operands are parsed by E2
+	std::shared_ptr<RValue> _climbExpression(const Scope context);
+
+	// Generates atoms of binary operator the same way as E3_-E7_ rules
+	std::shared_ptr<MemoryOperand> _binaryOperation(const Scope context, const LexemType operation,
+		const std::shared_ptr<RValue> left, const std::shared_ptr<RValue> right);
+
 	// Recursive descent rules of miniC
 	void DeclareStmt(const Scope context);
-	void DeclareStmt_(const Scope context, SymbolTable::TableRecord::RecordType p, const std::string& q);
+	void DeclareStmt_(const Scope context, SymbolTable::TableRecord::RecordType p, const std::string& q, const SourcePosition& position);
 
 	SymbolTable::TableRecord::RecordType Type();
 
 	void DeclVarList_(const Scope context, SymbolTable::TableRecord::RecordType p);
 
-	void InitVar(const Scope context, SymbolTable::TableRecord::RecordType p, const std::string& q);
+	void InitVar(const Scope context, SymbolTable::TableRecord::RecordType p, const std::string& q, const SourcePosition& position);
 
 	unsigned int ParamList(const Scope context);
 	unsigned int ParamList_(const Scope context);
@@ -126,15 +253,49 @@ private:
 	void IfOp(const Scope context);
 	void ElsePart(const Scope context);
 
+	// Cases are collected as pairs of value and position of its compare atom
+	typedef std::vector<std::pair<int, unsigned int>> CasesList;
+
 	void SwitchOp(const Scope context);
-	void Cases(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end);
-	void Cases_(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end, std::shared_ptr<LabelOperand> def);
-	std::shared_ptr<LabelOperand> ACase(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end);
+	void Cases(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end, CasesList& cases);
+	void Cases_(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end, std::shared_ptr<LabelOperand> def, CasesList& cases);
+	std::shared_ptr<LabelOperand> ACase(const Scope context, std::shared_ptr<RValue> p, std::shared_ptr<LabelOperand> end, CasesList& cases);
 
 	void IOp(const Scope context);
 	void OOp(const Scope context);
 	void OOp_(const Scope context);
 
-	void _generateProlog(std::ostream& stream) const;
-	void _generateFunctionCode(std::ostream& stream, unsigned int function) const;
+	void _generateFunctionCode(CodeWriter& stream, unsigned int function) const;
+
+	// Takes code and jump tables of function from cache or generates them
+	void _generateFunction(const Scope function, std::string& code, std::string& tables, std::set<std::string>& routines) const;
+
+	// Returns indexes of functions which have body in this module
+	std::vector<unsigned int> _definedFunctions() const;
+
+	// Computes keys of functions in order of declaration, so keys of callees are known
+	void _computeFunctionKeys();
+
+	// Returns key of function in cache, optimized and plain code are stored separately
+	uint64_t _cacheKey(const Scope function) const;
+
+	// Collects labels and strings of function atoms and global records
+	CompilationCache::Symbols _collectSymbols(const Scope function) const;
+
+	// Binary form of atoms and operands. Operand may be nullptr, loaded ones refer to tables
+	// of translator. Labels with the same id are loaded as one operand
+	void _saveAtom(BinaryWriter& writer, const Atom* atom) const;
+	std::unique_ptr<Atom> _loadAtom(BinaryReader& reader, std::map<int, std::shared_ptr<LabelOperand>>& labels);
+	void _saveOperand(BinaryWriter& writer, const std::shared_ptr<Operand> operand) const;
+	std::shared_ptr<Operand> _loadOperand(BinaryReader& reader) const;
+	std::shared_ptr<LabelOperand> _loadLabel(BinaryReader& reader, std::map<int, std::shared_ptr<LabelOperand>>& labels) const;
+
+	// Reads state written by save
+	void _loadState(BinaryReader& reader);
+
+	// Removes results of translation
+	void _clearState();
+
+	// Clears state and parser and gets the first lexem of new source
+	void _restart();
 };
\ No newline at end of file
@@ -1,9 +1,35 @@
 #include <iostream>
 #include "Translator\Translator.h"
+#include "CycleCounter\CycleCounter.h"
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <thread>
+#include "Server\TranslationServer.h"
+#include "Serialization\BinaryStream.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+int main(int argc, char* argv[]) {
+	// Server mode: translation requests are read from stdin, responses are written to stdout
+	if (argc > 1 && std::string(argv[1]) == "--server") {
+#ifdef _WIN32
+		_setmode(_fileno(stdin), _O_BINARY);
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		const unsigned int workers = argc > 2 ? std::stoul(argv[2]) : std::thread::hardware_concurrency();
+		try {
+			TranslationServer(workers).serve(std::cin, std::cout);
+		}
+		catch (const FormatError& error) {
+			std::cerr << error.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
 
-int main() {
 	std::cout << "Enter input filename (in input folder): ";
 	std::string filename;
 	std::cin >> filename;
@@ -18,24 +44,51 @@ int main() {
 		while (true) {}
 	}
 
+	// Functions unchanged since the previous run are taken from cache
+	CompilationCache cache;
+	std::ifstream cacheInput(filename + ".cache", std::ios::binary);
+	cache.load(cacheInput);
+	cacheInput.close();
+
 	// Translation
 	std::ofstream status(filename + ".status.log");
 	Translator translator(input, status);
+	translator.setCache(&cache);
 
 	if (translator.translate()) {
 		status << "Translated OK" << std::endl;
 
+		// State of translation, optimization and code generation can be continued from it
+		std::ofstream state(filename + ".state", std::ios::binary);
+		translator.save(state);
+		state.close();
+
+		translator.optimize();
+
 		// Print info
 		translator.printSymbolTable(status);
 		translator.printStringTable(status);
+		status << std::endl;
+		translator.printOptimizationStatistics(status);
 
 		// Print atoms
 		std::ofstream atoms(filename + ".atoms.txt");
 		translator.printAtoms(atoms);
 
 		// Print code
+		std::ostringstream code;
+		translator.generateCode(code);
+
 		std::ofstream asmCode(filename + ".asm.txt");
-		translator.generateCode(asmCode);
+		asmCode << code.str();
+
+		std::ofstream cacheOutput(filename + ".cache", std::ios::binary);
+		cache.save(cacheOutput);
+		cacheOutput.close();
+		status << std::endl << "Functions reused from cache: " << cache.hits() << std::endl;
+
+		std::istringstream listing(code.str());
+		status << std::endl << "Static cycle count: " << CycleCounter::count(listing) << std::endl;
 
 		status.close();
 		input.close();
@@ -43,7 +96,7 @@ int main() {
 
 	}
 	else {
-		status << std::endl << "Error occured during translation";
+		status << std::endl << translator.diagnostics().size() << " error(s) occured during translation";
 		status.close();
 		input.close();
 	}